@@ -4,11 +4,11 @@
 #include "GridEditorEditorModeCommands.h"
 
 #include "Grid.h"
+#include "GridWorldSubsystem.h"
 #include "GridEditorWidget.h"
 // #include "LevelEditor.h"
 #include "Widgets/Docking/SDockTab.h"
 #include "ToolMenus.h"
-#include "EngineUtils.h"
 
 #define LOCTEXT_NAMESPACE "GridEditorModule"
 
@@ -62,10 +62,14 @@ TSharedRef<SDockTab> FGridEditorModule::OnSpawnGridEditorTab(const FSpawnTabArgs
 {
     TArray<TWeakObjectPtr<AGrid>> Grids;
 
-    // Find all Grid actors in the level
-    for (TActorIterator<AGrid> It(GEditor->GetEditorWorldContext().World()); It; ++It)
+    // All the Grid actors in the level, from the world's grid index
+    UWorld* World = GEditor->GetEditorWorldContext().World();
+    if (UGridWorldSubsystem* GridIndex = World ? World->GetSubsystem<UGridWorldSubsystem>() : nullptr)
     {
-        Grids.Add(*It);
+        for (AGrid* Grid : GridIndex->GetGrids())
+        {
+            Grids.Add(Grid);
+        }
     }
 
     return SNew(SDockTab)
@@ -3,6 +3,14 @@
 #include "Widgets/Text/STextBlock.h"
 #include "Widgets/Input/SButton.h"
 #include "Widgets/Input/SEditableTextBox.h"
+#include "ScopedTransaction.h"
+
+// Cell type named by the text, or Empty if there is no such type
+static EGridCellType GetGridCellTypeFromString(const FString& TypeName)
+{
+    const int64 Value = StaticEnum<EGridCellType>()->GetValueByNameString(TypeName);
+    return Value == INDEX_NONE ? EGridCellType::Empty : EGridCellType(Value);
+}
 
 void SGridEditorWidget::Construct(const FArguments& InArgs)
 {
@@ -13,7 +21,9 @@ void SGridEditorWidget::Construct(const FArguments& InArgs)
     {
         if (Manager.IsValid())
         {
-            GridNames.Add(MakeShareable(new FString(Manager->GetName())));
+            TSharedPtr<FString> Option = MakeShareable(new FString(Manager->GetName()));
+            GridNames.Add(Option);
+            GridsByOption.Add(Option, Manager);
         }
     }
 
@@ -93,10 +103,10 @@ void SGridEditorWidget::Construct(const FArguments& InArgs)
         .Padding(5)
         [
             SNew(SEditableTextBox)
-            .Text(FText::FromString("Soil")) // Default value
+            .Text(FText::FromString(CellTypeInput)) // Default value
             .OnTextCommitted_Lambda([this](const FText& Text, ETextCommit::Type CommitType)
             {
-                // CellTypeInput = Text.ToString();
+                CellTypeInput = Text.ToString();
             })
         ]
         + SVerticalBox::Slot()
@@ -143,14 +153,8 @@ void SGridEditorWidget::Construct(const FArguments& InArgs)
 void SGridEditorWidget::OnGridSelected(TSharedPtr<FString> NewValue, ESelectInfo::Type SelectInfo)
 {
     // Find the selected Grid
-    for (TWeakObjectPtr<AGrid> Manager : Grids)
-    {
-        if (Manager.IsValid() && Manager->GetName() == *NewValue)
-        {
-            SelectedGrid = Manager;
-            break;
-        }
-    }
+    const TWeakObjectPtr<AGrid>* Manager = GridsByOption.Find(NewValue);
+    SelectedGrid = Manager ? *Manager : nullptr;
 }
 
 FReply SGridEditorWidget::OnInitializeGridClicked()
@@ -183,17 +187,18 @@ FReply SGridEditorWidget::OnFillGridClicked()
 {
     if (SelectedGrid.IsValid())
     {
+        const FScopedTransaction Transaction(FText::FromString("Fill Grid"));
+        SelectedGrid->Modify();
+        const EGridCellType CellType = GetGridCellTypeFromString(CellTypeInput);
         for (int32 Y = 0; Y < SelectedGrid->GridHeight; ++Y)
         {
             for (int32 X = 0; X < SelectedGrid->GridWidth; ++X)
             {
-                UGridCell* Cell = SelectedGrid->GetGridCellAtXY(X, Y);
-                if (Cell)
-                {
-                    // Cell->CellType = GetGridCellTypeFromString(CellTypeInput);
-                    // Cell->Attributes.SoilQuality = SoilQualityInput;
-                    // Cell->Attributes.WaterLevel = WaterLevelInput;
-                }
+                // Write the cells directly, going through GetGridCellAtXY
+                // would create a UGridCell view for every cell of the grid
+                SelectedGrid->SetCellType(X, Y, CellType);
+                // SoilQuality = SoilQualityInput;
+                // WaterLevel = WaterLevelInput;
             }
         }
     }
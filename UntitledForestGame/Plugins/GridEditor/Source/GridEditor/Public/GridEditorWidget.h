@@ -27,6 +27,8 @@ private:
 
     // UI Components
     TArray<TSharedPtr<FString>> GridNames;
+    // Grid of each dropdown option
+    TMap<TSharedPtr<FString>, TWeakObjectPtr<AGrid>> GridsByOption;
     TSharedPtr<SComboBox<TSharedPtr<FString>>> GridDropdown;
 
     // Other callbacks for UI actions
@@ -36,8 +38,10 @@ private:
 
     TSubclassOf<UGridCellAttributes> GridCellAttributesClass;
 
+    // Name of the EGridCellType that Fill Grid sets
+    FString CellTypeInput = TEXT("Ground");
+
     // // Input values for grid cell attributes
-    // FString CellTypeInput;
     // float SoilQualityInput;
     // float WaterLevelInput;
 
@@ -1,28 +1,428 @@
 #include "Grid.h"
 #include "GridComponent.h"
+#include "GridManager.h"
+#include "GridManagerCounters.h"
+#include "GridManagerStats.h"
+#include "GridWorldSubsystem.h"
 #include "DrawDebugHelpers.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeRWLock.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "HAL/IConsoleManager.h"
+#include "Tasks/Task.h"
+#include "UObject/ObjectSaveContext.h"
+
+static TAutoConsoleVariable<int32> CVarGridDebugDraw(
+  TEXT("grid.DebugDraw"),
+  1,
+  TEXT("Draw the grids in the editor viewport.\n")
+  TEXT("0: off, 1: on"),
+  ECVF_Default);
+
+// Number of lines of a cell's debug box (the edges of a box)
+static constexpr int32 LinesPerCellBox = 12;
+
+// Line batch of the debug lattice, the boxes of the cells are in the batch of
+// their index + 1
+static constexpr uint32 DebugLatticeBatchID = MAX_uint32;
+
+// Above this many changed cells the visualization is redrawn as a whole rather
+// than a batch at a time, each ClearBatch goes over all of the lines
+static constexpr int32 MaxIncrementalDebugCells = 256;
 
 // Initialize the grid
 void AGrid::InitializeGrid() {
-  GridCells.Empty();
+  GRID_SCOPE_CYCLE_COUNTER(STAT_GridInitialize);
+  // drop a build in flight, its cells are replaced anyway
+  PendingBuild.Reset();
+  // any views we handed out refer to the old layout
+  ReleaseCellViews();
+  CellAttributes.Empty();
+  AttributeField.Empty();
+  // the wake conditions refer to the old cells
+  SleepIndex.Empty();
+
+  // every cell starts out empty, of the default type
+  CellStore.Init(GridWidth, GridHeight, DefaultCellType, StorageMode);
+  OccupancyMask.Init(GridWidth, GridHeight);
+  PlacementTable.Init(GridWidth, GridHeight);
+  Pathfinder.Init(GridWidth, GridHeight);
+  bDebugDrawAllDirty = true;
+  bQueryOccupancyDirty = true;
+  bQueryTypesDirty = true;
+  UpdateWorldIndex();
+  RefreshStaticLayer();
+
+  // the fresh cells have no occupants, put the items back
+  TArray<AActor*> EvictedItems;
+  RestoreItemsAfterRebuild(FIntPoint::ZeroValue, false, EvictedItems);
+
+  if (IsRecordingJournal()) {
+    FGridJournalRecord Record;
+    Record.Op = EGridJournalOp::Initialize;
+    Record.Target = FIntPoint(GridWidth, GridHeight);
+    Record.Value = CellSize;
+    Record.CellType = DefaultCellType;
+    RecordMutation(Record);
+  }
+
+  if (EvictedItems.Num() > 0) {
+    OnGridResized.Broadcast(this, EvictedItems);
+  }
+}
+
+///////// Async Initialization /////////
+
+struct FGridInitBuild
+{
+  int32 Width = 0;
+  int32 Height = 0;
+  EGridCellType DefaultType = EGridCellType::Ground;
+  EGridStorageMode Mode = EGridStorageMode::Chunked;
+  bool bPreserveCells = false;
+  // Where the preserved cells move to, added to their old position
+  FIntPoint Offset = FIntPoint::ZeroValue;
+  float InitialWaterLevel = 0.0f;
+  float InitialSoilQuality = 0.0f;
+
+  // The grid's cells going in, the new ones coming out
+  FGridCellStore CellStore;
+  FGridAttributeField AttributeField;
+
+  FGridOccupancyMask OccupancyMask;
+  FGridSummedAreaTable PlacementTable;
+  FGridPathfinder Pathfinder;
+
+  UE::Tasks::FTask Task;
+
+  // Items removed by the publication because they no longer fit
+  TArray<AActor*> EvictedItems;
+
+  void Run();
+};
+
+void FGridInitBuild::Run() {
+  GRID_SCOPE_CYCLE_COUNTER(STAT_GridInitialize);
+  FGridCellStore OldCells = MoveTemp(CellStore);
+  CellStore.Init(Width, Height, DefaultType, Mode);
+  OccupancyMask.Init(Width, Height);
+  PlacementTable.Init(Width, Height);
+  Pathfinder.Init(Width, Height);
+
+  if (bPreserveCells) {
+    // a single pass over the cells which differ from the default, the others
+    // are the default in the new store already
+    const int32 OldWidth = OldCells.GetWidth();
+    OldCells.ForEachNonDefaultCell([this, OldWidth](int32 OldIndex, EGridCellType Type, int32 Slot, int32 AttributeIndex) {
+      const int32 X = OldIndex % OldWidth + Offset.X;
+      const int32 Y = OldIndex / OldWidth + Offset.Y;
+      if (X < 0 || X >= Width || Y < 0 || Y >= Height) {
+        return;
+      }
+      const int32 Index = Y * Width + X;
+      if (Type != DefaultType) {
+        CellStore.SetType(Index, Type);
+      }
+      if (Slot != INDEX_NONE) {
+        CellStore.SetOccupantSlot(Index, Slot);
+        OccupancyMask.Set(X, Y, true);
+      }
+      if (AttributeIndex != INDEX_NONE) {
+        CellStore.SetAttributeIndex(Index, AttributeIndex);
+      }
+    });
+  }
+
+  FGridAttributeField OldAttributes = MoveTemp(AttributeField);
+  AttributeField.Empty();
+  if (bPreserveCells && OldAttributes.IsInitialized()) {
+    // the new cells start out with the initial values, the overlap keeps its
+    // own, copied a row at a time
+    TArray<float> WaterLevels;
+    TArray<float> SoilQualities;
+    WaterLevels.Init(InitialWaterLevel, Width * Height);
+    SoilQualities.Init(InitialSoilQuality, Width * Height);
+    const int32 OldWidth = OldAttributes.GetWidth();
+    const int32 MinX = FMath::Max(0, Offset.X);
+    const int32 MaxX = FMath::Min(Width, OldWidth + Offset.X);
+    const int32 MinY = FMath::Max(0, Offset.Y);
+    const int32 MaxY = FMath::Min(Height, OldAttributes.GetHeight() + Offset.Y);
+    for (int32 Y = MinY; Y < MaxY && MinX < MaxX; ++Y) {
+      const int32 OldIndex = (Y - Offset.Y) * OldWidth + MinX - Offset.X;
+      FMemory::Memcpy(&WaterLevels[Y * Width + MinX], &OldAttributes.GetWaterLevels()[OldIndex], (MaxX - MinX) * sizeof(float));
+      FMemory::Memcpy(&SoilQualities[Y * Width + MinX], &OldAttributes.GetSoilQualities()[OldIndex], (MaxX - MinX) * sizeof(float));
+    }
+    AttributeField.InitFromColumns(Width, Height, MoveTemp(WaterLevels), MoveTemp(SoilQualities));
+  }
+}
+
+TSharedPtr<FGridInitBuild> AGrid::PrepareBuild(bool bPreserveCells, const FVector2D& Anchor) {
+  // a build in flight has the cells we would start from
+  WaitForGridReady();
+
+  ReleaseCellViews();
+  SleepIndex.Empty();
+
+  TSharedPtr<FGridInitBuild> Build = MakeShared<FGridInitBuild>();
+  Build->Width = GridWidth;
+  Build->Height = GridHeight;
+  Build->DefaultType = DefaultCellType;
+  Build->Mode = StorageMode;
+  Build->bPreserveCells = bPreserveCells && CellStore.GetDefaultType() == DefaultCellType;
+  if (Build->bPreserveCells) {
+    const FVector2D Growth(GridWidth - CellStore.GetWidth(), GridHeight - CellStore.GetHeight());
+    const FVector2D ClampedAnchor(FMath::Clamp(Anchor.X, 0.0, 1.0), FMath::Clamp(Anchor.Y, 0.0, 1.0));
+    Build->Offset = FIntPoint(FMath::RoundToInt(Growth.X * ClampedAnchor.X), FMath::RoundToInt(Growth.Y * ClampedAnchor.Y));
+  } else {
+    CellAttributes.Empty();
+  }
+  Build->InitialWaterLevel = SimulationSettings.InitialWaterLevel;
+  Build->InitialSoilQuality = SimulationSettings.InitialSoilQuality;
+  // the build owns the cells until it is published, the grid has none
+  Build->CellStore = MoveTemp(CellStore);
+  Build->AttributeField = MoveTemp(AttributeField);
+  CellStore.Empty();
+  AttributeField.Empty();
+  OccupancyMask.Empty();
+  PlacementTable.Empty();
+  Pathfinder.Empty();
+  PendingBuild = Build;
+  return Build;
+}
+
+void AGrid::InitializeGridAsync(bool bPreserveCells) {
+  TSharedPtr<FGridInitBuild> Build = PrepareBuild(bPreserveCells, ResizeAnchor);
+  Build->Task = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Build]() { Build->Run(); });
+  // published on the game thread as soon as it is built, unless a wait got
+  // there first
+  UE::Tasks::Launch(UE_SOURCE_LOCATION, [WeakThis = TWeakObjectPtr<AGrid>(this), Build]() {
+    if (AGrid* Grid = WeakThis.Get()) {
+      Grid->PublishBuild(Build);
+    }
+  }, UE::Tasks::Prerequisites(Build->Task), UE::Tasks::ETaskPriority::Normal, UE::Tasks::EExtendedTaskPriority::GameThreadNormalPri);
+}
+
+void AGrid::ResizeGrid(int32 NewWidth, int32 NewHeight, FVector2D Anchor, TArray<AActor*>& OutEvictedItems) {
+  OutEvictedItems.Reset();
+  WaitForGridReady();
+  GridWidth = FMath::Max(1, NewWidth);
+  GridHeight = FMath::Max(1, NewHeight);
+
+  TSharedPtr<FGridInitBuild> Build = PrepareBuild(true, Anchor);
+  Build->Run();
+  PublishBuild(Build);
+  OutEvictedItems = MoveTemp(Build->EvictedItems);
+}
+
+void AGrid::WaitForGridReady() {
+  if (PendingBuild) {
+    PendingBuild->Task.Wait();
+    PublishBuild(PendingBuild);
+  }
+}
+
+void AGrid::PublishBuild(const TSharedPtr<FGridInitBuild>& Build) {
+  // superseded by a synchronous initialization, or published by a wait
+  if (!Build || Build != PendingBuild) {
+    return;
+  }
+  PendingBuild.Reset();
+
+  CellStore = MoveTemp(Build->CellStore);
+  AttributeField = MoveTemp(Build->AttributeField);
+  OccupancyMask = MoveTemp(Build->OccupancyMask);
+  PlacementTable = MoveTemp(Build->PlacementTable);
+  Pathfinder = MoveTemp(Build->Pathfinder);
+  bDebugDrawAllDirty = true;
+  bQueryOccupancyDirty = true;
+  bQueryTypesDirty = true;
+
+  RestoreItemsAfterRebuild(Build->Offset, Build->bPreserveCells, Build->EvictedItems);
+  if (Build->bPreserveCells) {
+    if (Build->Offset != FIntPoint::ZeroValue) {
+      // move the grid the other way, so the kept cells stay where they were
+      // in the world, and their items with them
+      const FVector Shift(Build->Offset.X * CellSize, Build->Offset.Y * CellSize, 0.0);
+      SetActorLocation(GetActorLocation() - CachedGridRotation.RotateVector(Shift));
+    }
+  }
+  UpdateWorldIndex();
+  RefreshStaticLayer();
+
+  if (Build->bPreserveCells) {
+    // replaying an Initialize would lose the preserved cells
+    CompactJournal();
+  } else if (IsRecordingJournal()) {
+    FGridJournalRecord Record;
+    Record.Op = EGridJournalOp::Initialize;
+    Record.Target = FIntPoint(GridWidth, GridHeight);
+    Record.Value = CellSize;
+    Record.CellType = DefaultCellType;
+    RecordMutation(Record);
+  }
+
+  OnGridReady.Broadcast(this);
+  if (Build->bPreserveCells || Build->EvictedItems.Num() > 0) {
+    OnGridResized.Broadcast(this, Build->EvictedItems);
+  }
+}
+
+void AGrid::RestoreItemsAfterRebuild(const FIntPoint& Offset, bool bCellsPreserved, TArray<AActor*>& OutEvictedItems) {
+  const FIntRect Bounds(0, 0, GridWidth, GridHeight);
+  for (AActor* Item : ItemRegistry.GetItems()) {
+    UGridComponent* GridComponent = GetGridComponent(Item);
+    if (!GridComponent) {
+      continue;
+    }
+    FIntRect Footprint = GridComponent->OccupiedFootprint;
+    const bool bPlaced = Footprint.Area() > 0;
+    Footprint += Offset;
+    GridComponent->Position += FVector2D(Offset);
+    if (!bPlaced || (Footprint.Min.X >= 0 && Footprint.Min.Y >= 0 && Footprint.Max.X <= GridWidth && Footprint.Max.Y <= GridHeight)) {
+      GridComponent->OccupiedFootprint = Footprint;
+      if (bPlaced && !bCellsPreserved) {
+        OccupyFootprint(Footprint, Item);
+      }
+      continue;
+    }
+    // only the preserved cells within the grid are still the item's, they
+    // are freed with it
+    Footprint.Clip(Bounds);
+    GridComponent->OccupiedFootprint = bCellsPreserved ? Footprint : FIntRect();
+    OutEvictedItems.Add(Item);
+  }
+
+  if (OutEvictedItems.Num() > 0) {
+    TArray<FString> Names;
+    for (const AActor* Item : OutEvictedItems) {
+      Names.Add(Item->GetName());
+    }
+    UE_LOG(LogGridManager, Warning, TEXT("%s: removed %d items which no longer fit the %dx%d grid: %s"), *GetName(), OutEvictedItems.Num(), GridWidth,
+      GridHeight, *FString::Join(Names, TEXT(", ")));
+    RemoveItems(OutEvictedItems);
+  }
+}
+
+void AGrid::RebuildOccupancyMask() {
+  OccupancyMask.Init(GridWidth, GridHeight);
+  PlacementTable.Init(GridWidth, GridHeight);
+  Pathfinder.Init(GridWidth, GridHeight);
+  bDebugDrawAllDirty = true;
+  bQueryOccupancyDirty = true;
+  if (CellStore.GetWidth() != GridWidth || CellStore.GetHeight() != GridHeight) {
+    return;
+  }
+
+  CellStore.ForEachOccupiedCell([this](int32 Index, int32 Slot) {
+    OccupancyMask.Set(Index % GridWidth, Index / GridWidth, true);
+  });
+}
+
+void AGrid::PostLoad() {
+  Super::PostLoad();
+
+  ItemRegistry.RebuildLookup();
+  MigrateDeprecatedCells();
+  MigrateDeprecatedItems();
+
+  // grids saved without cell storage (or with a stale one) get a fresh grid
+  if (CellStore.GetWidth() != GridWidth || CellStore.GetHeight() != GridHeight) {
+    InitializeGrid();
+    return;
+  }
+  CellStore.SetMode(StorageMode);
+  if (AttributeField.GetWidth() != GridWidth || AttributeField.GetHeight() != GridHeight) {
+    AttributeField.Empty();
+  }
+  RefreshStaticLayer();
+  // the bitmask is not saved, derive it from the loaded cells
+  RebuildOccupancyMask();
+}
+
+void AGrid::MigrateDeprecatedCells() {
+  if (GridCells_DEPRECATED.Num() == 0) {
+    return;
+  }
+
+  CellStore.Init(GridWidth, GridHeight, DefaultCellType, StorageMode);
+  CellAttributes.Reset();
+  for (UGridCell* Cell : GridCells_DEPRECATED) {
+    if (!Cell || !IsCellValid(Cell->GridPosition.X, Cell->GridPosition.Y)) {
+      continue;
+    }
+    int32 Index = GetGridCellIndex(Cell->GridPosition.X, Cell->GridPosition.Y);
+    CellStore.SetType(Index, Cell->CellType);
+    if (Cell->Attributes) {
+      CellStore.SetAttributeIndex(Index, CellAttributes.Add(Cell->Attributes));
+    }
+    if (Cell->OccupyingItem) {
+      CellStore.SetOccupantSlot(Index, ItemRegistry.Add(Cell->OccupyingItem).Slot);
+    }
+  }
+  UE_LOG(LogGridManager, Log, TEXT("%s: moved %d saved cells into the cell storage, resave the level to keep them"), *GetName(),
+    GridCells_DEPRECATED.Num());
+  GridCells_DEPRECATED.Empty();
+}
 
-  for (int32 y = 0; y < GridHeight; ++y) {
-    for (int32 x = 0; x < GridWidth; ++x) {
-      // Create a new grid cell, the array holds pointers to the cells
-      UGridCell* NewCell = NewObject<UGridCell>(this, GridCellClass);
-      // set the cell type to be Ground
-      NewCell->CellType = EGridCellType::Ground;
-      NewCell->Grid = this;
-      NewCell->GridPosition = FVector2D(x, y);
-      NewCell->OccupyingItem = nullptr;
-      // Add the cell to the grid
-      GridCells.Add(NewCell);
+void AGrid::MigrateDeprecatedItems() {
+  if (ManagedItems_DEPRECATED.Num() == 0) {
+    return;
+  }
+
+  // without cells the grid is initialized next, which occupies the
+  // footprints itself
+  const bool bHasCells = CellStore.GetWidth() == GridWidth && CellStore.GetHeight() == GridHeight;
+  for (AActor* Item : ManagedItems_DEPRECATED) {
+    UGridComponent* GridComponent = GetGridComponent(Item);
+    if (!GridComponent) {
+      continue;
+    }
+    const int32 Slot = ItemRegistry.Add(Item).Slot;
+    // the components of these grids kept their cells as UGridCells, derive
+    // the footprint from the saved position and rotation instead
+    GridComponent->Grid = this;
+    GridComponent->OccupiedFootprint = GetFootprint(GridComponent->Position, GridComponent->GetRotatedSize());
+    if (!bHasCells) {
+      continue;
+    }
+    const FIntRect& Footprint = GridComponent->OccupiedFootprint;
+    for (int32 y = Footprint.Min.Y; y < Footprint.Max.Y; ++y) {
+      for (int32 x = Footprint.Min.X; x < Footprint.Max.X; ++x) {
+        CellStore.SetOccupantSlot(GetGridCellIndex(x, y), Slot);
+      }
     }
   }
+  UE_LOG(LogGridManager, Log, TEXT("%s: moved %d saved items into the item registry, resave the level to keep them"), *GetName(),
+    ManagedItems_DEPRECATED.Num());
+  ManagedItems_DEPRECATED.Empty();
+}
+
+void AGrid::PreSave(FObjectPreSaveContext SaveContext) {
+  Super::PreSave(SaveContext);
+
+  // the cells are only saved once they are back in the grid
+  WaitForGridReady();
+}
+
+void AGrid::SetStorageMode(EGridStorageMode NewStorageMode) {
+  StorageMode = NewStorageMode;
+  CellStore.SetMode(StorageMode);
+}
+
+void AGrid::PostActorCreated() {
+  Super::PostActorCreated();
+
+  // spawned grids copy their cells from the template, but not the lookups
+  ItemRegistry.RebuildLookup();
+  RebuildOccupancyMask();
+  RefreshStaticLayer();
 }
 
 bool AGrid::IsCellValid(int32 X, int32 Y) const {
-  return X >= 0 && X < GridWidth && Y >= 0 && Y < GridHeight;
+  return IsGridReady() && X >= 0 && X < GridWidth && Y >= 0 && Y < GridHeight;
 }
 
 int32 AGrid::GetGridCellIndex(int32 X, int32 Y) const {
@@ -45,12 +445,157 @@ void AGrid::PostEditChangeProperty(FPropertyChangedEvent& e) {
     GridWidth = FMath::Max(1, GridWidth);
     GridHeight = FMath::Max(1, GridHeight);
 
-    // Initialize the grid
-    InitializeGrid();
+    // build the resized grid in the background, keeping the cells around
+    // ResizeAnchor
+    InitializeGridAsync(true);
+  } else if (PropertyName == GET_MEMBER_NAME_CHECKED(AGrid, DefaultCellType)) {
+    InitializeGridAsync(false);
+  } else if (PropertyName == GET_MEMBER_NAME_CHECKED(AGrid, StorageMode)) {
+    SetStorageMode(StorageMode);
+  } else if (PropertyName == GET_MEMBER_NAME_CHECKED(AGrid, CellSize)) {
+    UpdateWorldIndex();
+  } else if (PropertyName == GET_MEMBER_NAME_CHECKED(AGrid, StaticLayerFile)) {
+    RefreshStaticLayer();
   }
 }
+
+void AGrid::PostEditUndo() {
+  Super::PostEditUndo();
+
+  // undo restored the cells the pending build was made from
+  PendingBuild.Reset();
+  ItemRegistry.RebuildLookup();
+  RebuildOccupancyMask();
+}
 #endif
 
+/////// Static Layer ///////
+
+void AGrid::RefreshStaticLayer() {
+  const FString Filename = StaticLayerFile.IsEmpty() ? FString() : FPaths::Combine(FPaths::ProjectDir(), StaticLayerFile);
+  if (StaticLayer.IsMapped() && (StaticLayer.GetFilename() != Filename || StaticLayer.GetWidth() != GridWidth || StaticLayer.GetHeight() != GridHeight)) {
+    StaticLayer.Unmap();
+  } else if (StaticLayer.IsMapped() || Filename.IsEmpty()) {
+    return;
+  }
+
+  if (!Filename.IsEmpty() && StaticLayer.Map(Filename) && (StaticLayer.GetWidth() != GridWidth || StaticLayer.GetHeight() != GridHeight)) {
+    UE_LOG(LogGridManager, Warning, TEXT("%s: static layer %s is %dx%d, the grid %dx%d, it is not used"), *GetName(), *Filename, StaticLayer.GetWidth(),
+      StaticLayer.GetHeight(), GridWidth, GridHeight);
+    StaticLayer.Unmap();
+  }
+
+  // the unusable cells may have changed
+  PlacementTable.MarkAllDirty();
+  Pathfinder.MarkAllDirty();
+  bDebugDrawAllDirty = true;
+  bQueryTypesDirty = true;
+}
+
+uint8 AGrid::GetGroundType(int32 X, int32 Y) const {
+  if (!IsCellValid(X, Y) || !StaticLayer.IsMapped()) {
+    return 0;
+  }
+  return StaticLayer.GetGroundType(GetGridCellIndex(X, Y));
+}
+
+bool AGrid::CookStaticLayer(const TArray<uint8>& GroundTypes, const TArray<float>& BaseSoilQualities) {
+  const int32 NumCells = GridWidth * GridHeight;
+  if (StaticLayerFile.IsEmpty() || (GroundTypes.Num() != 0 && GroundTypes.Num() != NumCells)
+    || (BaseSoilQualities.Num() != 0 && BaseSoilQualities.Num() != NumCells)) {
+    UE_LOG(LogGridManager, Warning, TEXT("%s: cannot cook the static layer, it needs a file and one value per cell"), *GetName());
+    return false;
+  }
+
+  TArray<uint8> Types = GroundTypes;
+  if (Types.Num() == 0) {
+    Types.SetNumZeroed(NumCells);
+  }
+  TArray<float> Soil = BaseSoilQualities;
+  if (Soil.Num() == 0) {
+    Soil.Init(SimulationSettings.InitialSoilQuality, NumCells);
+  }
+  TArray<uint8> UnusableCells;
+  UnusableCells.SetNumZeroed((NumCells + 7) / 8);
+  TArray<int32> UnusableIndices;
+  for (int32 Index = 0; Index < NumCells; ++Index) {
+    if (GetCellTypeAtIndex(Index) == EGridCellType::Unusable) {
+      UnusableCells[Index >> 3] |= 1 << (Index & 7);
+      UnusableIndices.Add(Index);
+    }
+  }
+
+  const FString Filename = FPaths::Combine(FPaths::ProjectDir(), StaticLayerFile);
+  StaticLayer.Unmap();
+  if (!FGridStaticLayer::Write(Filename, GridWidth, GridHeight, Types, UnusableCells, Soil)) {
+    UE_LOG(LogGridManager, Warning, TEXT("%s: could not write the static layer %s"), *GetName(), *Filename);
+    RefreshStaticLayer();
+    return false;
+  }
+  RefreshStaticLayer();
+  if (!StaticLayer.IsMapped()) {
+    return false;
+  }
+
+  // the layer has the unusable cells now, the cell storage doesn't need them
+  if (DefaultCellType != EGridCellType::Unusable) {
+    for (int32 Index : UnusableIndices) {
+      if (CellStore.GetType(Index) == EGridCellType::Unusable) {
+        CellStore.SetType(Index, DefaultCellType);
+      }
+    }
+  }
+  return true;
+}
+
+/////// Chunks ///////
+
+void AGrid::UpdateResidentChunks(const FVector& WorldPosition, int32 ChunkRadius) {
+  FVector LocalPosition = CachedWorldToLocal.TransformPosition(WorldPosition) / CellSize;
+  int32 CenterX = FMath::FloorToInt(LocalPosition.X) >> FGridCellStore::ChunkShift;
+  int32 CenterY = FMath::FloorToInt(LocalPosition.Y) >> FGridCellStore::ChunkShift;
+  ChunkRadius = FMath::Max(0, ChunkRadius);
+
+  for (int32 ChunkY = 0; ChunkY < CellStore.GetNumChunksY(); ++ChunkY) {
+    for (int32 ChunkX = 0; ChunkX < CellStore.GetNumChunksX(); ++ChunkX) {
+      bool bInRange = FMath::Abs(ChunkX - CenterX) <= ChunkRadius && FMath::Abs(ChunkY - CenterY) <= ChunkRadius;
+      if (bInRange) {
+        CellStore.PageIn(ChunkX, ChunkY);
+      } else {
+        CellStore.PageOut(ChunkX, ChunkY);
+      }
+    }
+  }
+}
+
+void AGrid::TickChunkResidency(float DeltaTime) {
+  APlayerController* PlayerController = GetWorld() ? GetWorld()->GetFirstPlayerController() : nullptr;
+  if (!PlayerController) {
+    return;
+  }
+  FVector ViewLocation;
+  FRotator ViewRotation;
+  PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+  const FVector LocalPosition = CachedWorldToLocal.TransformPosition(ViewLocation) / CellSize;
+  const int32 CenterX = FMath::FloorToInt(LocalPosition.X) >> FGridCellStore::ChunkShift;
+  const int32 CenterY = FMath::FloorToInt(LocalPosition.Y) >> FGridCellStore::ChunkShift;
+  // writes page their chunk back in wherever it is, so go over the chunks
+  // again once in a while even if the view stays put
+  ResidencyTimer += DeltaTime;
+  if (CenterX == ResidencyCenterChunkX && CenterY == ResidencyCenterChunkY && ResidencyTimer < 1.0f) {
+    return;
+  }
+  ResidencyCenterChunkX = CenterX;
+  ResidencyCenterChunkY = CenterY;
+  ResidencyTimer = 0.0f;
+  UpdateResidentChunks(ViewLocation, ResidentChunkRadius);
+}
+
+int32 AGrid::GetNumResidentChunks() const {
+  return CellStore.CountChunks(EGridChunkState::Resident);
+}
+
 /////// Get Grid Cell ///////
 
 UGridCell* AGrid::GetGridCellAtXY(int32 X, int32 Y) const {
@@ -58,7 +603,7 @@ UGridCell* AGrid::GetGridCellAtXY(int32 X, int32 Y) const {
     return nullptr;
   }
 
-  return GridCells[GetGridCellIndex(X, Y)];
+  return GetCellView(GetGridCellIndex(X, Y));
 }
 
 UGridCell* AGrid::GetGridCellAtGridPosition(const FVector2D& GridPosition) const {
@@ -66,11 +611,210 @@ UGridCell* AGrid::GetGridCellAtGridPosition(const FVector2D& GridPosition) const
 }
 
 UGridCell* AGrid::GetGridCellAtIndex(int32 Index) const {
-  if (Index < 0 || Index >= GridCells.Num()) {
+  if (!CellStore.IsValidIndex(Index)) {
+    return nullptr;
+  }
+
+  return GetCellView(Index);
+}
+
+TArray<UGridCell*> AGrid::GetAllCells() const {
+  TArray<UGridCell*> Cells;
+  Cells.Reserve(CellStore.Num());
+  for (int32 Index = 0; Index < CellStore.Num(); ++Index) {
+    Cells.Add(GetCellView(Index));
+  }
+  return Cells;
+}
+
+///////// Cell Views /////////
+
+UGridCell* AGrid::GetCellView(int32 Index) const {
+  if (!CellStore.IsValidIndex(Index)) {
+    return nullptr;
+  }
+
+  // views are only a cache of the cell storage, so creating one does not
+  // change the grid
+  AGrid* MutableThis = const_cast<AGrid*>(this);
+  TWeakObjectPtr<UGridCell>& View = MutableThis->CellViews.FindOrAdd(Index);
+  UGridCell* Cell = View.Get();
+  if (!Cell) {
+    UClass* ViewClass = GridCellClass ? GridCellClass.Get() : UGridCell::StaticClass();
+    Cell = NewObject<UGridCell>(MutableThis, ViewClass, NAME_None, RF_Transient);
+    Cell->Grid = MutableThis;
+    Cell->GridPosition = FVector2D(Index % GridWidth, Index / GridWidth);
+    View = Cell;
+  }
+  SyncCellView(Index);
+  return Cell;
+}
+
+void AGrid::SyncCellView(int32 Index) const {
+  if (CellViews.Num() == 0) {
+    return;
+  }
+  const TWeakObjectPtr<UGridCell>* View = CellViews.Find(Index);
+  UGridCell* Cell = View ? View->Get() : nullptr;
+  if (!Cell) {
+    return;
+  }
+
+  Cell->CellType = GetCellTypeAtIndex(Index);
+  Cell->OccupyingItem = ItemRegistry.GetBySlot(CellStore.GetOccupantSlot(Index));
+  int32 AttributeIndex = CellStore.GetAttributeIndex(Index);
+  Cell->Attributes = CellAttributes.IsValidIndex(AttributeIndex) ? CellAttributes[AttributeIndex] : nullptr;
+}
+
+void AGrid::ReleaseCellViews() {
+  for (auto& Pair : CellViews) {
+    if (UGridCell* Cell = Pair.Value.Get()) {
+      // detach the view so that it no longer writes to the grid
+      Cell->Grid = nullptr;
+    }
+  }
+  CellViews.Empty();
+}
+
+void AGrid::PruneCellViews(float DeltaTime) {
+  CellViewsPruneTimer += DeltaTime;
+  if (CellViewsPruneTimer < 1.0f) {
+    return;
+  }
+  CellViewsPruneTimer = 0.0f;
+  for (auto It = CellViews.CreateIterator(); It; ++It) {
+    if (!It.Value().IsValid()) {
+      It.RemoveCurrent();
+    }
+  }
+}
+
+///////// Cell State /////////
+
+EGridCellType AGrid::GetCellType(int32 X, int32 Y) const {
+  if (!IsCellValid(X, Y)) {
+    return EGridCellType::Empty;
+  }
+
+  return GetCellTypeAtIndex(GetGridCellIndex(X, Y));
+}
+
+void AGrid::SetCellType(int32 X, int32 Y, EGridCellType NewCellType) {
+  WaitForGridReady();
+  if (!IsCellValid(X, Y)) {
+    return;
+  }
+
+  int32 Index = GetGridCellIndex(X, Y);
+  CellStore.SetType(Index, NewCellType);
+  PlacementTable.MarkDirty(X, Y);
+  Pathfinder.MarkDirty(X, Y);
+  bQueryTypesDirty = true;
+  if (bDebugDrawActive) {
+    DebugDirtyCells.Add(Index);
+  }
+  SyncCellView(Index);
+  if (SleepIndex.HasCellSubscribers()) {
+    WakeCellSubscribers(Index);
+  }
+
+  if (IsRecordingJournal()) {
+    FGridJournalRecord Record;
+    Record.Op = EGridJournalOp::CellType;
+    Record.Cell = FIntPoint(X, Y);
+    Record.CellType = NewCellType;
+    RecordMutation(Record);
+  }
+}
+
+AActor* AGrid::GetCellOccupant(int32 Index) const {
+  if (!CellStore.IsValidIndex(Index)) {
     return nullptr;
   }
 
-  return GridCells[Index];
+  return ItemRegistry.GetBySlot(CellStore.GetOccupantSlot(Index));
+}
+
+void AGrid::SetCellOccupant(int32 Index, AActor* Item) {
+  if (!CellStore.IsValidIndex(Index)) {
+    return;
+  }
+
+  // an occupant is always a managed item, so that the cell can refer to it by
+  // its slot
+  SetCellOccupantSlot(Index, Item ? ItemRegistry.Add(Item).Slot : INDEX_NONE);
+}
+
+void AGrid::SetCellOccupantSlot(int32 Index, int32 Slot) {
+  CellStore.SetOccupantSlot(Index, Slot);
+  int32 X = Index % GridWidth;
+  int32 Y = Index / GridWidth;
+  OccupancyMask.Set(X, Y, Slot != INDEX_NONE);
+  PlacementTable.MarkDirty(X, Y);
+  Pathfinder.MarkDirty(X, Y);
+  bQueryOccupancyDirty = true;
+  if (bDebugDrawActive) {
+    DebugDirtyCells.Add(Index);
+  }
+  SyncCellView(Index);
+  if (SleepIndex.HasCellSubscribers()) {
+    WakeCellSubscribers(Index);
+  }
+}
+
+FIntRect AGrid::GetFootprint(const FVector2D& GridPosition, const FVector2D& ItemSize) const {
+  FIntPoint Min(GridPosition.X, GridPosition.Y);
+  FIntPoint Max = Min + FIntPoint(FMath::CeilToInt(ItemSize.X), FMath::CeilToInt(ItemSize.Y));
+
+  // clip to the grid
+  Min = FIntPoint(FMath::Clamp(Min.X, 0, GridWidth), FMath::Clamp(Min.Y, 0, GridHeight));
+  Max = FIntPoint(FMath::Clamp(Max.X, Min.X, GridWidth), FMath::Clamp(Max.Y, Min.Y, GridHeight));
+  return FIntRect(Min, Max);
+}
+
+void AGrid::OccupyFootprint(const FIntRect& Footprint, AActor* Item) {
+  WaitForGridReady();
+  int32 Slot = Item ? ItemRegistry.Add(Item).Slot : INDEX_NONE;
+  for (int32 y = Footprint.Min.Y; y < Footprint.Max.Y; ++y) {
+    for (int32 x = Footprint.Min.X; x < Footprint.Max.X; ++x) {
+      SetCellOccupantSlot(GetGridCellIndex(x, y), Slot);
+    }
+  }
+}
+
+void AGrid::ReleaseFootprint(const FIntRect& Footprint, const AActor* Item) {
+  WaitForGridReady();
+  int32 Slot = ItemRegistry.FindSlot(Item);
+  if (Slot == INDEX_NONE) {
+    return;
+  }
+  for (int32 y = Footprint.Min.Y; y < Footprint.Max.Y; ++y) {
+    for (int32 x = Footprint.Min.X; x < Footprint.Max.X; ++x) {
+      int32 Index = GetGridCellIndex(x, y);
+      // only free the cells that still belong to the item
+      if (CellStore.IsValidIndex(Index) && CellStore.GetOccupantSlot(Index) == Slot) {
+        SetCellOccupantSlot(Index, INDEX_NONE);
+      }
+    }
+  }
+}
+
+///////// Managed Items /////////
+
+TArray<AActor*> AGrid::GetManagedItems() const {
+  return ItemRegistry.GetItems();
+}
+
+bool AGrid::IsManagedItem(const AActor* Item) const {
+  return ItemRegistry.Contains(Item);
+}
+
+FGridItemHandle AGrid::GetItemHandle(const AActor* Item) const {
+  return ItemRegistry.Find(Item);
+}
+
+AActor* AGrid::GetItemFromHandle(const FGridItemHandle& Handle) const {
+  return ItemRegistry.Get(Handle);
 }
 
 ///////// Get Grid Cell Attributes /////////
@@ -80,12 +824,12 @@ UGridCellAttributes* AGrid::GetGridCellAttributes(int32 X, int32 Y) {
     return nullptr;
   }
 
-  UGridCell* Cell = GetGridCellAtXY(X, Y);
-  if (!Cell) {
+  int32 AttributeIndex = CellStore.GetAttributeIndex(GetGridCellIndex(X, Y));
+  if (!CellAttributes.IsValidIndex(AttributeIndex)) {
     return nullptr;
   }
 
-  return Cell->Attributes;
+  return CellAttributes[AttributeIndex];
 }
 
 UGridCellAttributes* AGrid::GetGridCellAttributesAtGridPosition(const FVector2D& GridPosition) {
@@ -93,12 +837,25 @@ UGridCellAttributes* AGrid::GetGridCellAttributesAtGridPosition(const FVector2D&
 }
 
 UGridCellAttributes* AGrid::GetGridCellAttributesAtWorldPosition(const FVector& WorldPosition) {
-  UGridCell *Cell = GetCellAtWorldPosition(WorldPosition);
-  if (!Cell) {
-    return nullptr;
+  FVector2D GridPosition = WorldToGrid(WorldPosition);
+  return GetGridCellAttributes(GridPosition.X, GridPosition.Y);
+}
+
+void AGrid::SetGridCellAttributes(int32 X, int32 Y, UGridCellAttributes* Attributes) {
+  WaitForGridReady();
+  if (!IsCellValid(X, Y)) {
+    return;
   }
 
-  return Cell->Attributes;
+  int32 Index = GetGridCellIndex(X, Y);
+  int32 AttributeIndex = CellStore.GetAttributeIndex(Index);
+  if (CellAttributes.IsValidIndex(AttributeIndex)) {
+    // reuse the cell's slot
+    CellAttributes[AttributeIndex] = Attributes;
+  } else if (Attributes) {
+    CellStore.SetAttributeIndex(Index, CellAttributes.Add(Attributes));
+  }
+  SyncCellView(Index);
 }
 
 /////// Converters ///////
@@ -110,16 +867,14 @@ FVector2D AGrid::ItemSizeToGridSize(const FVector& ItemSize) const {
 FVector AGrid::GridToWorld(const FVector2D& GridPosition) const {
   FVector WorldPosition = FVector(GridPosition.X * CellSize, GridPosition.Y * CellSize, 0);
   // take into account the AGrid's rotation
-  auto Rotation = GetActorRotation();
-  WorldPosition = FRotator(Rotation.Pitch, Rotation.Yaw, Rotation.Roll).RotateVector(WorldPosition);
+  WorldPosition = CachedGridRotation.RotateVector(WorldPosition);
 
-  return WorldPosition + GetActorLocation();
+  return WorldPosition + CachedGridLocation;
 }
 
 FVector2D AGrid::WorldToGrid(const FVector& WorldPosition) const {
   // Transform the world position into the grid's local space
-  FTransform GridTransform = GetActorTransform().Inverse();
-  FVector RelativePosition = GridTransform.TransformPosition(WorldPosition);
+  FVector RelativePosition = CachedWorldToLocal.TransformPosition(WorldPosition);
 
   // if the relative position Z value is > CellSize or < 0, then it
   // is not on the grid, return an invalid position
@@ -133,6 +888,112 @@ FVector2D AGrid::WorldToGrid(const FVector& WorldPosition) const {
   return FVector2D(x, y);
 }
 
+void AGrid::GridToWorldBatch(const TArray<FVector2D>& GridPositions, TArray<FVector>& OutWorldPositions) const {
+  // cell units, rotation and location folded into a single matrix
+  const FMatrix GridToWorldMatrix = FScaleMatrix(CellSize) * FQuatRotationTranslationMatrix(CachedGridRotation, CachedGridLocation);
+
+  OutWorldPositions.SetNumUninitialized(GridPositions.Num());
+  for (int32 i = 0; i < GridPositions.Num(); ++i) {
+    OutWorldPositions[i] = GridToWorldMatrix.TransformPosition(FVector(GridPositions[i].X, GridPositions[i].Y, 0));
+  }
+}
+
+FMatrix AGrid::GetWorldToCellMatrix() const {
+  return CachedWorldToLocal * FScaleMatrix(1.0f / CellSize);
+}
+
+void AGrid::WorldToGridBatch(const TArray<FVector>& WorldPositions, TArray<FVector2D>& OutGridPositions) const {
+  // world to grid space in cell units as a single matrix
+  const FMatrix WorldToCellMatrix = GetWorldToCellMatrix();
+
+  OutGridPositions.SetNumUninitialized(WorldPositions.Num());
+  for (int32 i = 0; i < WorldPositions.Num(); ++i) {
+    FVector RelativePosition = WorldToCellMatrix.TransformPosition(WorldPositions[i]);
+    // same check as WorldToGrid, in cell units
+    if (RelativePosition.Z > 1.0f || RelativePosition.Z < 0) {
+      OutGridPositions[i] = FVector2D(-1, -1);
+    } else {
+      OutGridPositions[i] = FVector2D(FMath::RoundToInt(RelativePosition.X), FMath::RoundToInt(RelativePosition.Y));
+    }
+  }
+}
+
+/////// Cached Transform ///////
+
+void AGrid::UpdateCachedTransform() {
+  const FTransform& ActorTransform = GetActorTransform();
+  CachedGridRotation = ActorTransform.GetRotation();
+  CachedGridLocation = ActorTransform.GetLocation();
+  CachedGridUpVector = CachedGridRotation.GetUpVector();
+  CachedWorldToLocal = ActorTransform.ToInverseMatrixWithScale();
+  ++TransformVersion;
+  UpdateWorldIndex();
+}
+
+void AGrid::UpdateWorldIndex() {
+  // only registered grids are indexed, the rest register when they are
+  if (!TransformSource.IsValid()) {
+    return;
+  }
+  if (UWorld* World = GetWorld()) {
+    if (UGridWorldSubsystem* Index = World->GetSubsystem<UGridWorldSubsystem>()) {
+      Index->UpdateGrid(this);
+    }
+  }
+}
+
+void AGrid::BindTransformUpdates() {
+  if (TransformSource.Get() != RootComponent) {
+    if (USceneComponent* OldSource = TransformSource.Get()) {
+      OldSource->TransformUpdated.RemoveAll(this);
+    }
+    TransformSource = RootComponent;
+    if (RootComponent) {
+      RootComponent->TransformUpdated.AddUObject(this, &AGrid::OnRootTransformUpdated);
+    }
+  }
+  UpdateCachedTransform();
+}
+
+void AGrid::OnRootTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport) {
+  UpdateCachedTransform();
+}
+
+void AGrid::PostRegisterAllComponents() {
+  Super::PostRegisterAllComponents();
+
+  BindTransformUpdates();
+}
+
+void AGrid::PostUnregisterAllComponents() {
+  if (USceneComponent* OldSource = TransformSource.Get()) {
+    OldSource->TransformUpdated.RemoveAll(this);
+  }
+  TransformSource = nullptr;
+  if (UWorld* World = GetWorld()) {
+    if (UGridWorldSubsystem* Index = World->GetSubsystem<UGridWorldSubsystem>()) {
+      Index->RemoveGrid(this);
+    }
+  }
+  ClearStats();
+
+  Super::PostUnregisterAllComponents();
+}
+
+void AGrid::EndPlay(const EEndPlayReason::Type EndPlayReason) {
+  // everything journaled so far makes it to disk
+  StopJournal();
+
+  Super::EndPlay(EndPlayReason);
+}
+
+void AGrid::OnConstruction(const FTransform& Transform) {
+  Super::OnConstruction(Transform);
+
+  // rerunning the construction script can replace the root component
+  BindTransformUpdates();
+}
+
 //// GET ITEMS ////
 
 AActor* AGrid::GetItemAtXY(int32 X, int32 Y) {
@@ -148,22 +1009,16 @@ AActor* AGrid::GetItemAtCell(const UGridCell* Cell) {
 }
 
 AActor* AGrid::GetItemAtGridPosition(const FVector2D& GridPosition) {
-  UGridCell *Cell = GetGridCellAtGridPosition(GridPosition);
-  if (!Cell) {
+  if (!IsCellValid(GridPosition.X, GridPosition.Y)) {
     return nullptr;
   }
 
-  return Cell->OccupyingItem;
+  return GetCellOccupant(GetGridCellIndex(GridPosition.X, GridPosition.Y));
 }
 
 // Get an item at a specific world position
 AActor* AGrid::GetItemAtWorldPosition(const FVector& WorldPosition) {
-  UGridCell *Cell = GetCellAtWorldPosition(WorldPosition);
-  if (!Cell) {
-    return nullptr;
-  }
-
-  return Cell->OccupyingItem;
+  return GetItemAtGridPosition(WorldToGrid(WorldPosition));
 }
 
 //// GET CELLS ////
@@ -171,13 +1026,12 @@ AActor* AGrid::GetItemAtWorldPosition(const FVector& WorldPosition) {
 UGridCell* AGrid::GetCellAtGridPosition(const FVector2D& GridPosition) const {
   int32 x = FMath::CeilToInt(GridPosition.X);
   int32 y = FMath::CeilToInt(GridPosition.Y);
-  int32 Index = GetGridCellIndex(x, y);
 
-  if (!IsCellValid(x,y) || Index >= GridCells.Num()) {
+  if (!IsCellValid(x,y)) {
     return nullptr;
   }
 
-  return GridCells[Index];
+  return GetCellView(GetGridCellIndex(x, y));
 }
 
 // Get a cell at a specific world position
@@ -186,17 +1040,16 @@ UGridCell* AGrid::GetCellAtWorldPosition(const FVector& WorldPosition) const {
   FVector2D GridPosition = WorldToGrid(WorldPosition);
   int32 x = GridPosition.X;
   int32 y = GridPosition.Y;
-  int32 Index = GetGridCellIndex(x, y);
 
-  if (!IsCellValid(x,y) || Index >= GridCells.Num()) {
+  if (!IsCellValid(x,y)) {
     return nullptr;
   }
 
-  return GridCells[Index];
+  return GetCellView(GetGridCellIndex(x, y));
 }
 
 FVector AGrid::ProjectVectorOntoGridPlane(const FVector& InVector) const {
-  FVector GridUpVector = GetActorUpVector();
+  const FVector& GridUpVector = CachedGridUpVector;
   return InVector - FVector::DotProduct(InVector, GridUpVector) * GridUpVector;
 }
 
@@ -226,181 +1079,994 @@ UGridCell* AGrid::GetCellAtDistanceInFrontOfActor(const AActor* Actor, float Dis
   FVector ActorLocation = Actor->GetActorLocation();
   FVector ActorForwardVector = Actor->GetActorForwardVector();
 
-  ActorForwardVector = ProjectVectorOntoGridPlane(ActorForwardVector);
-  // re-normalize the vector
-  ActorForwardVector.Normalize();
+  ActorForwardVector = ProjectVectorOntoGridPlane(ActorForwardVector);
+  // re-normalize the vector
+  ActorForwardVector.Normalize();
+
+  auto CellPosition = ActorLocation + ActorForwardVector * Distance;
+  return GetCellAtWorldPosition(CellPosition);
+}
+
+///////// Actor Checks /////////
+
+UGridComponent* AGrid::GetGridComponent(const AActor* Item) const {
+  if (!Item) return nullptr;
+
+  return UGridComponent::FindGridComponent(Item);
+}
+
+bool AGrid::IsPlaceableItem(const AActor* Item) const {
+  if (!Item) return false;
+
+  return GetGridComponent(Item) != nullptr;
+}
+
+///////// PLACEMENT Checks /////////
+
+bool AGrid::CheckIfCellsAreFree(const FVector2D &GridPosition, const FVector2D &ItemSize, const AActor* Item) const {
+  GRID_SCOPE_CYCLE_COUNTER(STAT_GridCheckCells);
+  int32 X = GridPosition.X;
+  int32 Y = GridPosition.Y;
+  if (!IsCellValid(X, Y)) {
+    return false;
+  }
+
+  // the origin cell is always checked, even for an item with no size
+  int32 Width = FMath::Max(1, int32(ItemSize.X));
+  int32 Height = FMath::Max(1, int32(ItemSize.Y));
+  if (!IsCellValid(X + Width - 1, Y + Height - 1)) {
+    return false;
+  }
+  INC_DWORD_STAT(STAT_GridOccupancyChecks);
+  INC_DWORD_STAT_BY(STAT_GridCellsVisited, Width * Height);
+
+  if (Item == nullptr) {
+    return OccupancyMask.IsRectFree(X, Y, Width, Height);
+  }
+
+  // the cells occupied by the item itself count as free
+  auto GridComponent = GetGridComponent(Item);
+  if (GridComponent && GridComponent->Grid == this) {
+    return OccupancyMask.IsRectFree(X, Y, Width, Height, GridComponent->OccupiedFootprint);
+  }
+
+  // the item occupies cells without having been placed by us, compare the
+  // occupants themselves
+  int32 ItemSlot = ItemRegistry.FindSlot(Item);
+  for (int32 y = Y; y < Y + Height; ++y) {
+    for (int32 x = X; x < X + Width; ++x) {
+      int32 Slot = CellStore.GetOccupantSlot(GetGridCellIndex(x, y));
+      if (Slot != INDEX_NONE && Slot != ItemSlot) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+///////// PLACEMENT Search /////////
+
+// The size of an item turned by the given rotation, see
+// UGridComponent::GetSizeAtRotation
+static FIntPoint GetRotatedItemSize(const FVector2D& ItemSize, float Rotation) {
+  FIntPoint Size(FMath::Max(1, int32(ItemSize.X)), FMath::Max(1, int32(ItemSize.Y)));
+  if (Rotation == 90.0f || Rotation == 270.0f) {
+    Swap(Size.X, Size.Y);
+  }
+  return Size;
+}
+
+bool AGrid::IsCellBlocked(int32 X, int32 Y) const {
+  return OccupancyMask.Get(X, Y) || GetCellTypeAtIndex(GetGridCellIndex(X, Y)) == EGridCellType::Unusable;
+}
+
+bool AGrid::IsAreaPlaceable(int32 X, int32 Y, int32 Width, int32 Height) const {
+  if (Width <= 0 || Height <= 0) {
+    return false;
+  }
+  if (!IsCellValid(X, Y) || !IsCellValid(X + Width - 1, Y + Height - 1)) {
+    return false;
+  }
+
+  INC_DWORD_STAT(STAT_GridOccupancyChecks);
+  PlacementTable.Update([this](int32 x, int32 y) { return IsCellBlocked(x, y); });
+  return PlacementTable.CountInRect(X, Y, Width, Height) == 0;
+}
+
+TArray<FVector2D> AGrid::GetValidPlacementPositions(const FVector2D& ItemSize, float Rotation) const {
+  GRID_SCOPE_CYCLE_COUNTER(STAT_GridPlacementSearch);
+  TArray<FVector2D> Positions;
+  FIntPoint Size = GetRotatedItemSize(ItemSize, Rotation);
+  if (!IsGridReady() || Size.X > GridWidth || Size.Y > GridHeight) {
+    return Positions;
+  }
+
+  PlacementTable.Update([this](int32 x, int32 y) { return IsCellBlocked(x, y); });
+  for (int32 y = 0; y + Size.Y <= GridHeight; ++y) {
+    for (int32 x = 0; x + Size.X <= GridWidth; ++x) {
+      if (PlacementTable.CountInRect(x, y, Size.X, Size.Y) == 0) {
+        Positions.Add(FVector2D(x, y));
+      }
+    }
+  }
+  INC_DWORD_STAT_BY(STAT_GridOccupancyChecks, (GridWidth - Size.X + 1) * (GridHeight - Size.Y + 1));
+  return Positions;
+}
+
+bool AGrid::FindNearestValidPlacementPosition(const FVector2D& ItemSize, float Rotation, const FVector& WorldPosition, FVector2D& OutGridPosition) const {
+  GRID_SCOPE_CYCLE_COUNTER(STAT_GridPlacementSearch);
+  FIntPoint Size = GetRotatedItemSize(ItemSize, Rotation);
+  if (!IsGridReady() || Size.X > GridWidth || Size.Y > GridHeight) {
+    return false;
+  }
+  PlacementTable.Update([this](int32 x, int32 y) { return IsCellBlocked(x, y); });
+
+  // work in grid units, on the origin that would center the item on the
+  // position. Unlike WorldToGrid this does not reject positions off the grid
+  // plane.
+  FVector LocalPosition = CachedWorldToLocal.TransformPosition(WorldPosition) / CellSize;
+  FVector2D Target = FVector2D(LocalPosition.X, LocalPosition.Y) - FVector2D(Size.X - 1, Size.Y - 1) / 2.0f;
+  int32 MaxX = GridWidth - Size.X;
+  int32 MaxY = GridHeight - Size.Y;
+  FIntPoint Start(FMath::Clamp(FMath::RoundToInt(Target.X), 0, MaxX), FMath::Clamp(FMath::RoundToInt(Target.Y), 0, MaxY));
+
+  // search rings of growing radius around the start, until the ring is
+  // further away than the best position found so far
+  bool bFound = false;
+  double BestDistanceSquared = 0.0;
+  int32 NumChecks = 0;
+  int32 MaxRadius = FMath::Max(FMath::Max(Start.X, MaxX - Start.X), FMath::Max(Start.Y, MaxY - Start.Y));
+  double StartOffset = FVector2D::Distance(Target, FVector2D(Start));
+  for (int32 Radius = 0; Radius <= MaxRadius; ++Radius) {
+    if (bFound) {
+      double RingDistance = FMath::Max(0.0, Radius - StartOffset);
+      if (RingDistance * RingDistance > BestDistanceSquared) {
+        break;
+      }
+    }
+    for (int32 y = Start.Y - Radius; y <= Start.Y + Radius; ++y) {
+      if (y < 0 || y > MaxY) {
+        continue;
+      }
+      // only the edges of the ring, the inside has been searched already
+      bool bEdgeRow = y == Start.Y - Radius || y == Start.Y + Radius;
+      int32 Step = bEdgeRow ? 1 : FMath::Max(1, 2 * Radius);
+      for (int32 x = Start.X - Radius; x <= Start.X + Radius; x += Step) {
+        if (x < 0 || x > MaxX) {
+          continue;
+        }
+        ++NumChecks;
+        if (PlacementTable.CountInRect(x, y, Size.X, Size.Y) != 0) {
+          continue;
+        }
+        double DistanceSquared = FVector2D::DistSquared(Target, FVector2D(x, y));
+        if (!bFound || DistanceSquared < BestDistanceSquared) {
+          bFound = true;
+          BestDistanceSquared = DistanceSquared;
+          OutGridPosition = FVector2D(x, y);
+        }
+      }
+    }
+  }
+  INC_DWORD_STAT_BY(STAT_GridOccupancyChecks, NumChecks);
+  return bFound;
+}
+
+bool AGrid::CanPlaceInCell(const FVector2D &ItemSize, const UGridCell *Cell) const {
+  if (!Cell) {
+    return false;
+  }
+  return CheckIfCellsAreFree(Cell->GridPosition, ItemSize, nullptr);
+}
+
+bool AGrid::CanPlaceAtGridPosition(const FVector2D &ItemSize, const FVector2D &GridPosition) const {
+  int32 x = FMath::CeilToInt(GridPosition.X);
+  int32 y = FMath::CeilToInt(GridPosition.Y);
+
+  return CheckIfCellsAreFree(FVector2D(x, y), ItemSize, nullptr);
+}
+
+bool AGrid::CanPlaceAtWorldPosition(const FVector2D &ItemSize, const FVector &WorldPosition) const {
+  return CheckIfCellsAreFree(WorldToGrid(WorldPosition), ItemSize, nullptr);
+}
+
+bool AGrid::CanPlaceItemInCell_Implementation(const AActor* Item, const UGridCell* GridCell) const {
+  if (!Item) return false;
+  if (!GridCell) return false;
+  if (!IsPlaceableItem(Item)) return false;
+  auto GridComponent = GetGridComponent(Item);
+  return CanPlaceInCell(GridComponent->Size, GridCell);
+}
+
+bool AGrid::CanPlaceItemAtXY(const AActor* Item, int32 X, int32 Y) const {
+  if (!IsCellValid(X, Y)) {
+    return false;
+  }
+
+  // a blueprint override of CanPlaceItemInCell needs a cell to work with,
+  // otherwise we can check the cells directly without creating a view
+  if (GetClass()->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(AGrid, CanPlaceItemInCell))) {
+    return CanPlaceItemInCell(Item, GetCellView(GetGridCellIndex(X, Y)));
+  }
+
+  auto GridComponent = GetGridComponent(Item);
+  return CheckIfCellsAreFree(FVector2D(X, Y), GridComponent->Size, nullptr);
+}
+
+bool AGrid::CanPlaceItemAtGridPosition(const AActor* Item, const FVector2D& GridPosition) const {
+  if (!Item) return false;
+  if (!IsPlaceableItem(Item)) return false;
+
+  const FIntPoint Cell = GetPlacementCell(GridPosition);
+  return CanPlaceItemAtXY(Item, Cell.X, Cell.Y);
+}
+
+bool AGrid::CanPlaceItemAtWorldPosition(const AActor* Item, const FVector& WorldPosition) const {
+  if (!Item) return false;
+  if (!IsPlaceableItem(Item)) return false;
+  FVector2D GridPosition = WorldToGrid(WorldPosition);
+
+  return CanPlaceItemAtXY(Item, GridPosition.X, GridPosition.Y);
+}
+
+// Check if an item can be placed
+bool AGrid::CanPlaceItem(const AActor* Item) const {
+  if (!Item) return false;
+  if (!IsPlaceableItem(Item)) return false;
+  // get the world position of the item
+  FVector WorldPosition = Item->GetActorLocation();
+  return CanPlaceItemAtWorldPosition(Item, WorldPosition);
+}
+
+///////// Cell Queries /////////
+
+TArray<UGridCell*> AGrid::GetNeighborCells(const UGridCell* Cell, bool IncludeOccupied) const {
+  GRID_SCOPE_CYCLE_COUNTER(STAT_GridNeighbors);
+  TArray<UGridCell*> Neighbors;
+  if (!Cell) {
+    return Neighbors;
+  }
+
+  GRID_COUNTER_INC(NeighborQueries);
+  int32 Indices[MaxNeighborCells];
+  int32 NumNeighbors = GetNeighborCellIndices(FIntPoint(Cell->GridPosition.X, Cell->GridPosition.Y), Indices, IncludeOccupied);
+  Neighbors.Reserve(NumNeighbors);
+  for (int32 i = 0; i < NumNeighbors; ++i) {
+    Neighbors.Add(GetCellView(Indices[i]));
+  }
+  return Neighbors;
+}
+
+TArray<UGridCell*> AGrid::GetCells(const FVector2D& GridPosition, const FVector2D& GridSize) const {
+  TArray<UGridCell*> Cells;
+  FIntPoint Min(GridPosition.X, GridPosition.Y);
+  FIntRect Rect(Min, Min + FIntPoint(FMath::CeilToInt(GridSize.X), FMath::CeilToInt(GridSize.Y)));
+  Cells.Reserve(GetFootprint(GridPosition, GridSize).Area());
+  ForEachCellInRect(Rect, [this, &Cells](const FIntPoint& Cell, int32 Index) {
+    Cells.Add(GetCellView(Index));
+  });
+  return Cells;
+}
+
+int32 AGrid::GetNeighborCellIndices(const FIntPoint& Cell, TArrayView<int32> OutIndices, bool IncludeOccupied) const {
+  // called from the inner loops of the items, so counted but not timed
+  INC_DWORD_STAT(STAT_GridNeighborQueries);
+  INC_DWORD_STAT_BY(STAT_GridCellsVisited, MaxNeighborCells);
+  return GetPerimeterCellIndices(FIntRect(Cell, Cell + FIntPoint(1, 1)), OutIndices, IncludeOccupied);
+}
+
+int32 AGrid::GetPerimeterCellIndices(const FIntRect& Rect, TArrayView<int32> OutIndices, bool IncludeOccupied) const {
+  int32 Num = 0;
+  ForEachPerimeterCell(Rect, [this, &Num, &OutIndices, IncludeOccupied](const FIntPoint& Cell, int32 Index) {
+    if (Num < OutIndices.Num() && (IncludeOccupied || !IsCellOccupied(Cell))) {
+      OutIndices[Num++] = Index;
+    }
+  });
+  return Num;
+}
+
+int32 AGrid::GetRectCellIndices(const FIntRect& Rect, TArrayView<int32> OutIndices) const {
+  int32 Num = 0;
+  ForEachCellInRect(Rect, [&Num, &OutIndices](const FIntPoint& Cell, int32 Index) {
+    if (Num < OutIndices.Num()) {
+      OutIndices[Num++] = Index;
+    }
+  });
+  return Num;
+}
+
+///////// ITEM UPDATES /////////
+
+void AGrid::UpdateAllItems(float DeltaTime) {
+  GRID_SCOPE_CYCLE_COUNTER(STAT_GridUpdateItems);
+  CSV_SCOPED_TIMING_STAT(GridManager, UpdateItems);
+  ItemUpdateTime += DeltaTime;
+  ItemUpdateStats.ItemsUpdated = 0;
+
+  WakeExpiredSleepers();
+  NotifyPendingWakes();
+
+  const TArray<AActor*>& Items = ItemRegistry.GetItems();
+  if (Items.Num() == 0) {
+    ItemUpdateStats.Microseconds = 0.0f;
+    return;
+  }
+
+  const uint64 StartCycles = FPlatformTime::Cycles64();
+  const uint64 BudgetCycles = uint64(ItemUpdateBudgetMicroseconds / (FPlatformTime::GetSecondsPerCycle64() * 1000000.0));
+  uint64 ElapsedCycles = 0;
+  // at most one full pass per call, and at least one item so we always make
+  // progress
+  for (int32 Updated = 0; Updated < Items.Num(); ++Updated) {
+    if (Updated > 0 && ElapsedCycles >= BudgetCycles) {
+      break;
+    }
+    if (ItemUpdateCursor >= Items.Num()) {
+      // the pass is complete
+      ItemUpdateStats.LastPassDuration = ItemUpdateTime - ItemUpdatePassStart;
+      ItemUpdatePassStart = ItemUpdateTime;
+      ItemUpdateCursor = 0;
+    }
+
+    const int32 ItemIndex = ItemUpdateCursor++;
+    if (SleepIndex.IsSleeping(ItemRegistry.GetSlotAt(ItemIndex))) {
+      continue;
+    }
+    UGridComponent* GridComponent = GetGridComponent(Items[ItemIndex]);
+    if (GridComponent) {
+      // a new item starts its clock now
+      double LastUpdate = GridComponent->LastGridUpdateTime >= 0.0 ? GridComponent->LastGridUpdateTime : ItemUpdateTime;
+      GridComponent->LastGridUpdateTime = ItemUpdateTime;
+      GridComponent->UpdateOnGrid(ItemUpdateTime - LastUpdate);
+      ++ItemUpdateStats.ItemsUpdated;
+    }
+    ElapsedCycles = FPlatformTime::Cycles64() - StartCycles;
+  }
+
+  ItemUpdateStats.Microseconds = FPlatformTime::ToMilliseconds64(ElapsedCycles) * 1000.0;
+  GRID_COUNTER_ADD(ItemUpdates, ItemUpdateStats.ItemsUpdated);
+  if (ItemUpdateStats.Microseconds > ItemUpdateBudgetMicroseconds) {
+    ++ItemUpdateStats.Overruns;
+    GRID_COUNTER_INC(ItemUpdateOverruns);
+    UE_LOG(LogGridManager, Verbose, TEXT("%s: item updates took %.0fus, budget is %.0fus"), *GetName(), ItemUpdateStats.Microseconds,
+      ItemUpdateBudgetMicroseconds);
+  }
+}
+
+bool AGrid::SleepItem(AActor* Item, const FGridWakeCondition& WakeCondition) {
+  WaitForGridReady();
+  int32 Slot = ItemRegistry.FindSlot(Item);
+  UGridComponent* GridComponent = GetGridComponent(Item);
+  if (Slot == INDEX_NONE || !GridComponent) {
+    return false;
+  }
+
+  const FIntRect& Footprint = GridComponent->OccupiedFootprint;
+  TArray<int32, TInlineAllocator<32>> NeighborCells;
+  if (WakeCondition.bWakeOnNeighborChange) {
+    NeighborCells.SetNumUninitialized(2 * (Footprint.Width() + Footprint.Height()) + 4);
+    NeighborCells.SetNum(GetPerimeterCellIndices(Footprint, NeighborCells, true), EAllowShrinking::No);
+  }
+  int32 AttributeCell = IsCellValid(Footprint.Min.X, Footprint.Min.Y) ? GetGridCellIndex(Footprint.Min.X, Footprint.Min.Y) : INDEX_NONE;
+
+  SleepIndex.Sleep(Slot, WakeCondition, GetSleepTime(), NeighborCells, AttributeCell);
+  return true;
+}
+
+bool AGrid::WakeItem(AActor* Item) {
+  int32 Slot = ItemRegistry.FindSlot(Item);
+  if (!SleepIndex.IsSleeping(Slot)) {
+    return false;
+  }
+  WakeScratch.Reset();
+  WakeScratch.Add(Slot);
+  WakeSlots(WakeScratch);
+  NotifyPendingWakes();
+  return true;
+}
+
+bool AGrid::IsItemSleeping(const AActor* Item) const {
+  return SleepIndex.IsSleeping(ItemRegistry.FindSlot(Item));
+}
+
+double AGrid::GetSleepTime() const {
+  const UWorld* World = GetWorld();
+  return World ? World->GetTimeSeconds() : 0.0;
+}
+
+void AGrid::WakeExpiredSleepers() {
+  WakeScratch.Reset();
+  SleepIndex.AdvanceTime(GetSleepTime(), WakeScratch);
+  WakeSlots(WakeScratch);
+}
+
+void AGrid::WakeSlots(const TArray<int32>& Slots) {
+  for (int32 Slot : Slots) {
+    if (SleepIndex.Wake(Slot)) {
+      PendingWakes.Add(ItemRegistry.Find(ItemRegistry.GetBySlot(Slot)));
+    }
+  }
+}
+
+void AGrid::WakeCellSubscribers(int32 Index) {
+  WakeScratch.Reset();
+  SleepIndex.CollectCellSubscribers(Index, WakeScratch);
+  WakeSlots(WakeScratch);
+}
+
+void AGrid::WakeAttributeWatchers(int32 CellIndex) {
+  if (!SleepIndex.HasAttributeWatchers()) {
+    return;
+  }
+  WakeScratch.Reset();
+  SleepIndex.CollectAttributeWakes([this](int32 Cell, EGridCellAttribute Attribute) {
+    const int32 X = Cell % GridWidth;
+    const int32 Y = Cell / GridWidth;
+    return Attribute == EGridCellAttribute::WaterLevel ? GetWaterLevel(X, Y) : GetSoilQuality(X, Y);
+  }, WakeScratch, CellIndex);
+  WakeSlots(WakeScratch);
+}
+
+void AGrid::NotifyPendingWakes() {
+  if (PendingWakes.Num() == 0) {
+    return;
+  }
+  // the delegates may put items back to sleep or wake others
+  TArray<FGridItemHandle> Woken = MoveTemp(PendingWakes);
+  PendingWakes.Reset();
+  for (const FGridItemHandle& Handle : Woken) {
+    // skip items removed since they woke
+    UGridComponent* GridComponent = GetGridComponent(ItemRegistry.Get(Handle));
+    if (GridComponent) {
+      GridComponent->OnGridItemWake.Broadcast();
+    }
+  }
+}
+
+///////// ATTRIBUTE SIMULATION /////////
+
+FGridAttributeField& AGrid::GetWritableAttributeField() {
+  if (!AttributeField.IsInitialized()) {
+    AttributeField.Init(GridWidth, GridHeight, SimulationSettings.InitialWaterLevel, SimulationSettings.InitialSoilQuality);
+    // the simulation starts from the authored soil
+    if (StaticLayer.IsMapped()) {
+      for (int32 Index = 0; Index < GridWidth * GridHeight; ++Index) {
+        AttributeField.SetSoilQuality(Index, StaticLayer.GetBaseSoilQuality(Index));
+      }
+    }
+  }
+  return AttributeField;
+}
+
+float AGrid::GetWaterLevel(int32 X, int32 Y) const {
+  if (!IsCellValid(X, Y)) {
+    return 0.0f;
+  }
+  if (!AttributeField.IsInitialized()) {
+    return SimulationSettings.InitialWaterLevel;
+  }
+  return AttributeField.GetWaterLevel(GetGridCellIndex(X, Y));
+}
+
+void AGrid::SetWaterLevel(int32 X, int32 Y, float WaterLevel) {
+  WaitForGridReady();
+  if (!IsCellValid(X, Y)) {
+    return;
+  }
+  GetWritableAttributeField().SetWaterLevel(GetGridCellIndex(X, Y), WaterLevel);
+  WakeAttributeWatchers(GetGridCellIndex(X, Y));
+
+  if (IsRecordingJournal()) {
+    FGridJournalRecord Record;
+    Record.Op = EGridJournalOp::WaterLevel;
+    Record.Cell = FIntPoint(X, Y);
+    Record.Value = AttributeField.GetWaterLevel(GetGridCellIndex(X, Y));
+    RecordMutation(Record);
+  }
+}
+
+void AGrid::AddWater(int32 X, int32 Y, float Amount) {
+  SetWaterLevel(X, Y, GetWaterLevel(X, Y) + Amount);
+}
+
+float AGrid::GetSoilQuality(int32 X, int32 Y) const {
+  if (!IsCellValid(X, Y)) {
+    return 0.0f;
+  }
+  if (!AttributeField.IsInitialized()) {
+    return StaticLayer.IsMapped() ? StaticLayer.GetBaseSoilQuality(GetGridCellIndex(X, Y)) : SimulationSettings.InitialSoilQuality;
+  }
+  return AttributeField.GetSoilQuality(GetGridCellIndex(X, Y));
+}
+
+void AGrid::SetSoilQuality(int32 X, int32 Y, float SoilQuality) {
+  WaitForGridReady();
+  if (!IsCellValid(X, Y)) {
+    return;
+  }
+  GetWritableAttributeField().SetSoilQuality(GetGridCellIndex(X, Y), SoilQuality);
+  WakeAttributeWatchers(GetGridCellIndex(X, Y));
+
+  if (IsRecordingJournal()) {
+    FGridJournalRecord Record;
+    Record.Op = EGridJournalOp::SoilQuality;
+    Record.Cell = FIntPoint(X, Y);
+    Record.Value = AttributeField.GetSoilQuality(GetGridCellIndex(X, Y));
+    RecordMutation(Record);
+  }
+}
+
+void AGrid::StepAttributeSimulation() {
+  GRID_SCOPE_CYCLE_COUNTER(STAT_GridAttributeSimulation);
+  GetWritableAttributeField().Step(SimulationSettings, SimulationSettings.TimeStep);
+  WakeAttributeWatchers();
+}
+
+void AGrid::TickAttributeSimulation(float DeltaTime) {
+  GRID_SCOPE_CYCLE_COUNTER(STAT_GridAttributeSimulation);
+  CSV_SCOPED_TIMING_STAT(GridManager, AttributeSimulation);
+  const float TimeStep = FMath::Max(SimulationSettings.TimeStep, KINDA_SMALL_NUMBER);
+  SimulationTimeAccumulator += DeltaTime;
+  int32 Steps = 0;
+  while (SimulationTimeAccumulator >= TimeStep && Steps < SimulationSettings.MaxStepsPerFrame) {
+    StepAttributeSimulation();
+    SimulationTimeAccumulator -= TimeStep;
+    ++Steps;
+  }
+  // drop what we couldn't catch up on
+  if (Steps == SimulationSettings.MaxStepsPerFrame) {
+    SimulationTimeAccumulator = FMath::Min(SimulationTimeAccumulator, TimeStep);
+  }
+}
+
+///////// SNAPSHOTS /////////
+
+void AGrid::CaptureSnapshot(FGridSnapshot& OutSnapshot) {
+  GRID_SCOPE_CYCLE_COUNTER(STAT_GridSnapshots);
+  // the cells of a pending build are part of the state
+  WaitForGridReady();
+  OutSnapshot.Width = GridWidth;
+  OutSnapshot.Height = GridHeight;
+  OutSnapshot.CellSize = CellSize;
+  OutSnapshot.DefaultType = DefaultCellType;
+  OutSnapshot.InitCells();
+
+  // the item table, and the index in it of the item in each registry slot
+  OutSnapshot.ItemClasses.Reset();
+  OutSnapshot.Items.Reset();
+  TMap<const UClass*, int32> ClassIndices;
+  TArray<int32> SlotItems;
+  const TArray<AActor*>& Items = ItemRegistry.GetItems();
+  for (int32 i = 0; i < Items.Num(); ++i) {
+    const UGridComponent* GridComponent = GetGridComponent(Items[i]);
+    if (GridComponent == nullptr) {
+      continue;
+    }
+    const UClass* ItemClass = Items[i]->GetClass();
+    const int32* ClassIndex = ClassIndices.Find(ItemClass);
+    if (ClassIndex == nullptr) {
+      ClassIndex = &ClassIndices.Add(ItemClass, OutSnapshot.ItemClasses.Add(ItemClass->GetPathName()));
+    }
+    const int32 Slot = ItemRegistry.GetSlotAt(i);
+    while (SlotItems.Num() <= Slot) {
+      SlotItems.Add(INDEX_NONE);
+    }
+    FGridSnapshotItem& Item = OutSnapshot.Items.AddDefaulted_GetRef();
+    Item.ClassIndex = *ClassIndex;
+    Item.Position = FIntPoint(GridComponent->Position.X, GridComponent->Position.Y);
+    Item.Rotation = GridComponent->Rotation;
+    SlotItems[Slot] = OutSnapshot.Items.Num() - 1;
+  }
+
+  // one pass over the stored cells, without paging any chunks in
+  TArray<int32> CellItems;
+  CellItems.Init(INDEX_NONE, OutSnapshot.NumCells());
+  if (CellStore.GetWidth() == GridWidth && CellStore.GetHeight() == GridHeight) {
+    CellStore.ForEachNonDefaultCell([&](int32 Index, EGridCellType Type, int32 Slot, int32 AttributeIndex) {
+      OutSnapshot.SetCellType(Index, Type);
+      if (SlotItems.IsValidIndex(Slot)) {
+        CellItems[Index] = SlotItems[Slot];
+      }
+    });
+  }
+  OutSnapshot.SetOccupancy(CellItems);
+
+  if (AttributeField.IsInitialized()) {
+    OutSnapshot.WaterLevels = AttributeField.GetWaterLevels();
+    OutSnapshot.SoilQualities = AttributeField.GetSoilQualities();
+  } else {
+    OutSnapshot.WaterLevels.Reset();
+    OutSnapshot.SoilQualities.Reset();
+  }
+}
+
+bool AGrid::RestoreSnapshot(const FGridSnapshot& Snapshot) {
+  GRID_SCOPE_CYCLE_COUNTER(STAT_GridSnapshots);
+  UWorld* World = GetWorld();
+  if (World == nullptr) {
+    return false;
+  }
+  const double StartTime = FPlatformTime::Seconds();
+  // the journal starts over from the restored state instead
+  TGuardValue<bool> SuppressJournal(bSuppressJournal, true);
+
+  // the current items go away with the state they were part of
+  TArray<AActor*> RemovedItems = ItemRegistry.GetItems();
+  for (AActor* Item : RemovedItems) {
+    if (UGridComponent* GridComponent = GetGridComponent(Item)) {
+      GridComponent->OccupiedFootprint = FIntRect();
+      GridComponent->Grid = nullptr;
+    }
+  }
+  ItemRegistry.Empty();
+  PendingWakes.Reset();
+  ItemUpdateCursor = 0;
+  ItemUpdatePassCount = 0;
+
+  GridWidth = Snapshot.Width;
+  GridHeight = Snapshot.Height;
+  CellSize = Snapshot.CellSize;
+  DefaultCellType = Snapshot.DefaultType;
+  InitializeGrid();
+
+  for (int32 Index = 0; Index < Snapshot.NumCells(); ++Index) {
+    const EGridCellType Type = Snapshot.GetCellType(Index);
+    if (Type != DefaultCellType) {
+      CellStore.SetType(Index, Type);
+    }
+  }
+
+  if (Snapshot.WaterLevels.Num() > 0) {
+    AttributeField.InitFromColumns(GridWidth, GridHeight, Snapshot.WaterLevels, Snapshot.SoilQualities);
+  }
+
+  // spawn the items straight at their place, the snapshot was valid when it
+  // was taken so nothing is checked again
+  TArray<UClass*> ItemClasses;
+  ItemClasses.Reserve(Snapshot.ItemClasses.Num());
+  for (const FString& ClassPath : Snapshot.ItemClasses) {
+    UClass* ItemClass = FSoftClassPath(ClassPath).TryLoadClass<AActor>();
+    if (ItemClass == nullptr) {
+      UE_LOG(LogGridManager, Warning, TEXT("Snapshot item class %s not found, its items are dropped"), *ClassPath);
+    }
+    ItemClasses.Add(ItemClass);
+  }
+
+  FActorSpawnParameters SpawnParameters;
+  SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+  TArray<int32> ItemSlots;
+  ItemSlots.Init(INDEX_NONE, Snapshot.Items.Num());
+  TArray<AActor*> PlacedItems;
+  PlacedItems.Reserve(Snapshot.Items.Num());
+  for (int32 i = 0; i < Snapshot.Items.Num(); ++i) {
+    const FGridSnapshotItem& SnapshotItem = Snapshot.Items[i];
+    UClass* ItemClass = ItemClasses[SnapshotItem.ClassIndex];
+    if (ItemClass == nullptr) {
+      continue;
+    }
+    const FTransform SpawnTransform(CachedGridRotation, GridToWorld(FVector2D(SnapshotItem.Position)));
+    AActor* Item = World->SpawnActor(ItemClass, &SpawnTransform, SpawnParameters);
+    UGridComponent* GridComponent = GetGridComponent(Item);
+    if (GridComponent == nullptr) {
+      UE_LOG(LogGridManager, Warning, TEXT("Snapshot item of class %s has no grid component, dropped"), *ItemClass->GetName());
+      if (Item) {
+        Item->Destroy();
+      }
+      continue;
+    }
+    ItemSlots[i] = ItemRegistry.Add(Item).Slot;
+    GridComponent->RestorePlacement(this, FVector2D(SnapshotItem.Position), SnapshotItem.Rotation);
+    PlacedItems.Add(Item);
+  }
+
+  // the occupancy goes straight into the cells
+  Snapshot.ForEachOccupiedRun([this, &ItemSlots](int32 FirstCell, int32 NumCells, int32 ItemIndex) {
+    const int32 Slot = ItemSlots[ItemIndex];
+    if (Slot == INDEX_NONE) {
+      return;
+    }
+    for (int32 Index = FirstCell; Index < FirstCell + NumCells; ++Index) {
+      CellStore.SetOccupantSlot(Index, Slot);
+      OccupancyMask.Set(Index % GridWidth, Index / GridWidth, true);
+    }
+  });
+  PlacementTable.MarkAllDirty();
+  Pathfinder.MarkAllDirty();
+  bDebugDrawAllDirty = true;
+  bQueryOccupancyDirty = true;
+  bQueryTypesDirty = true;
+
+  GRID_COUNTER_ADD(ItemsPlaced, PlacedItems.Num());
+  INC_DWORD_STAT_BY(STAT_GridPlacements, PlacedItems.Num());
+  UE_LOG(LogGridManager, Log, TEXT("%s: restored %d cells and %d items in %.2f ms"), *GetName(), Snapshot.NumCells(), PlacedItems.Num(),
+    (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+  // the restored items are new to the grid, tell them once all of them are
+  // in place
+  for (AActor* Item : PlacedItems) {
+    GetGridComponent(Item)->NotifyPlacedInGrid(true);
+  }
+  OnItemsChanged.Broadcast(PlacedItems, RemovedItems);
+  for (AActor* Item : RemovedItems) {
+    if (IsValid(Item)) {
+      Item->Destroy();
+    }
+  }
+  CompactJournal();
+  return true;
+}
+
+void AGrid::SaveSnapshot(TArray<uint8>& OutData) {
+  FGridSnapshot Snapshot;
+  CaptureSnapshot(Snapshot);
+  OutData.Reset();
+  FMemoryWriter Writer(OutData);
+  Snapshot.Serialize(Writer);
+}
+
+bool AGrid::LoadSnapshot(const TArray<uint8>& Data) {
+  FGridSnapshot Snapshot;
+  FMemoryReader Reader(Data);
+  if (!Snapshot.Serialize(Reader)) {
+    UE_LOG(LogGridManager, Warning, TEXT("%s: not a valid grid snapshot"), *GetName());
+    return false;
+  }
+  return RestoreSnapshot(Snapshot);
+}
 
-  auto CellPosition = ActorLocation + ActorForwardVector * Distance;
-  return GetCellAtWorldPosition(CellPosition);
+bool AGrid::SaveSnapshotToFile(const FString& Filename) {
+  TArray<uint8> Data;
+  SaveSnapshot(Data);
+  return FFileHelper::SaveArrayToFile(Data, *Filename);
 }
 
-///////// Actor Checks /////////
+bool AGrid::LoadSnapshotFromFile(const FString& Filename) {
+  TArray<uint8> Data;
+  if (!FFileHelper::LoadFileToArray(Data, *Filename)) {
+    UE_LOG(LogGridManager, Warning, TEXT("%s: could not read %s"), *GetName(), *Filename);
+    return false;
+  }
+  return LoadSnapshot(Data);
+}
 
-UGridComponent* AGrid::GetGridComponent(const AActor* Item) const {
-  if (!Item) return nullptr;
+///////// JOURNAL /////////
 
-  return Cast<UGridComponent>(Item->GetComponentByClass(UGridComponent::StaticClass()));
+void AGrid::StartJournal(const FString& BaseFilename) {
+  WaitForGridReady();
+  StopJournal();
+  Journal = MakeUnique<FGridJournal>(BaseFilename);
+  JournalFlushTimer = 0.0f;
+  // the base everything journaled from now on applies to
+  CompactJournal();
 }
 
-bool AGrid::IsPlaceableItem(const AActor* Item) const {
-  if (!Item) return false;
+void AGrid::StopJournal() {
+  if (!Journal) {
+    return;
+  }
+  Journal->Flush();
+  // waits for the writes
+  Journal.Reset();
+}
 
-  return GetGridComponent(Item) != nullptr;
+void AGrid::CompactJournal() {
+  GRID_SCOPE_CYCLE_COUNTER(STAT_GridJournal);
+  if (!Journal) {
+    return;
+  }
+  // only the capture happens on the game thread, the encoding and writing
+  // happen in the background
+  FGridSnapshot Snapshot;
+  CaptureSnapshot(Snapshot);
+  Journal->Compact(MoveTemp(Snapshot));
 }
 
-///////// PLACEMENT Checks /////////
+bool AGrid::RecoverFromJournal(const FString& BaseFilename) {
+  GRID_SCOPE_CYCLE_COUNTER(STAT_GridJournal);
+  // the files are about to be read, not rewritten
+  StopJournal();
 
-bool AGrid::CheckIfCellsAreFree(const FVector2D &GridPosition, const FVector2D &ItemSize, const AActor* Item) const {
-  if (!IsCellValid(GridPosition.X, GridPosition.Y)) {
+  FGridSnapshot Snapshot;
+  TArray<FGridJournalRecord> Records;
+  if (!FGridJournal::Load(BaseFilename, Snapshot, Records)) {
+    UE_LOG(LogGridManager, Warning, TEXT("%s: no valid journal snapshot at %s"), *GetName(), *BaseFilename);
     return false;
   }
-
-  // check the cell at grid position
-  int32 Index = GetGridCellIndex(GridPosition.X, GridPosition.Y);
-  if (GridCells[Index]->IsOccupied()) {
-    if (Item == nullptr || GridCells[Index]->OccupyingItem != Item) {
-      return false;
-    }
+  if (!RestoreSnapshot(Snapshot)) {
+    return false;
   }
 
-  // now check the cells around it
-  int32 width = ItemSize.X;
-  int32 height = ItemSize.Y;
-  // note: we have to handle the case where the width or height are odd, so we
-  // have to ceil the division by 2
-  for (int32 y = 0; y < height; ++y) {
-    for (int32 x = 0; x < width; ++x) {
-      FVector2D CellPosition = GridPosition + FVector2D(x, y);
-      if (!IsCellValid(CellPosition.X, CellPosition.Y)) {
-        return false;
-      }
-      Index = GetGridCellIndex(CellPosition.X, CellPosition.Y);
-      UGridCell *Cell = GridCells[Index];
-      if (Cell->IsOccupied()) {
-        if (Item == nullptr || Cell->OccupyingItem != Item) {
-          return false;
-        }
-      }
+  TGuardValue<bool> SuppressJournal(bSuppressJournal, true);
+  int32 NumSkipped = 0;
+  for (const FGridJournalRecord& Record : Records) {
+    if (!ApplyJournalRecord(Record)) {
+      ++NumSkipped;
     }
   }
+  UE_LOG(LogGridManager, Log, TEXT("%s: replayed %d journal records, %d no longer applied"), *GetName(), Records.Num(), NumSkipped);
   return true;
 }
 
-bool AGrid::CanPlaceInCell(const FVector2D &ItemSize, const UGridCell *Cell) const {
-  if (!Cell) {
-    return false;
-  }
-  return CheckIfCellsAreFree(Cell->GridPosition, ItemSize, nullptr);
+void AGrid::RecordMutation(FGridJournalRecord& Record) {
+  Journal->Append(Record);
 }
 
-bool AGrid::CanPlaceAtGridPosition(const FVector2D &ItemSize, const FVector2D &GridPosition) const {
-  UGridCell *Cell = GetCellAtGridPosition(GridPosition);
-  if (!Cell) {
-    return false;
+void AGrid::RecordItemPlacement(const AActor* Item, bool bWasPlaced, const FVector2D& OldPosition) {
+  const UGridComponent* GridComponent = GetGridComponent(Item);
+  if (!IsRecordingJournal() || GridComponent == nullptr) {
+    return;
   }
-
-  return CanPlaceInCell(ItemSize, Cell);
+  FGridJournalRecord Record;
+  if (bWasPlaced) {
+    Record.Op = EGridJournalOp::MoveItem;
+    Record.Cell = FIntPoint(OldPosition.X, OldPosition.Y);
+    Record.Target = FIntPoint(GridComponent->Position.X, GridComponent->Position.Y);
+  } else {
+    Record.Op = EGridJournalOp::PlaceItem;
+    Record.Cell = FIntPoint(GridComponent->Position.X, GridComponent->Position.Y);
+    Record.ItemClass = Item->GetClass()->GetPathName();
+  }
+  Record.Value = GridComponent->Rotation;
+  RecordMutation(Record);
 }
 
-bool AGrid::CanPlaceAtWorldPosition(const FVector2D &ItemSize, const FVector &WorldPosition) const {
-  UGridCell *Cell = GetCellAtWorldPosition(WorldPosition);
-  if (!Cell) {
-    return false;
+void AGrid::RecordItemRemoval(const UGridComponent* GridComponent) {
+  // an item without cells was never journaled as placed
+  if (!IsRecordingJournal() || GridComponent->OccupiedFootprint.Area() <= 0) {
+    return;
   }
+  FGridJournalRecord Record;
+  Record.Op = EGridJournalOp::RemoveItem;
+  Record.Cell = FIntPoint(GridComponent->Position.X, GridComponent->Position.Y);
+  RecordMutation(Record);
+}
 
-  return CanPlaceInCell(ItemSize, Cell);
+void AGrid::TickJournal(float DeltaTime) {
+  JournalFlushTimer += DeltaTime;
+  if (JournalFlushTimer < JournalFlushInterval) {
+    return;
+  }
+  JournalFlushTimer = 0.0f;
+  if (JournalCompactionBytes > 0 && Journal->GetJournalSize() >= JournalCompactionBytes) {
+    CompactJournal();
+  } else {
+    Journal->Flush();
+  }
 }
 
-bool AGrid::CanPlaceItemInCell_Implementation(const AActor* Item, const UGridCell* GridCell) const {
-  if (!Item) return false;
-  if (!GridCell) return false;
-  if (!IsPlaceableItem(Item)) return false;
-  auto GridComponent = GetGridComponent(Item);
-  return CanPlaceInCell(GridComponent->Size, GridCell);
+AActor* AGrid::FindItemAtOrigin(const FIntPoint& Cell) const {
+  if (!IsCellValid(Cell.X, Cell.Y)) {
+    return nullptr;
+  }
+  AActor* Item = GetCellOccupant(GetGridCellIndex(Cell.X, Cell.Y));
+  const UGridComponent* GridComponent = GetGridComponent(Item);
+  if (GridComponent == nullptr || FIntPoint(GridComponent->Position.X, GridComponent->Position.Y) != Cell) {
+    return nullptr;
+  }
+  return Item;
 }
 
-bool AGrid::CanPlaceItemAtGridPosition(const AActor* Item, const FVector2D& GridPosition) const {
-  if (!Item) return false;
-  if (!IsPlaceableItem(Item)) return false;
-  UGridCell *Cell = GetCellAtGridPosition(GridPosition);
-  if (!Cell) {
-    return false;
+bool AGrid::ApplyJournalRecord(const FGridJournalRecord& Record) {
+  switch (Record.Op) {
+  case EGridJournalOp::Initialize:
+    GridWidth = FMath::Max(1, Record.Target.X);
+    GridHeight = FMath::Max(1, Record.Target.Y);
+    CellSize = Record.Value;
+    DefaultCellType = Record.CellType;
+    InitializeGrid();
+    return true;
+
+  case EGridJournalOp::PlaceItem: {
+    UClass* ItemClass = FSoftClassPath(Record.ItemClass).TryLoadClass<AActor>();
+    UWorld* World = GetWorld();
+    if (ItemClass == nullptr || World == nullptr) {
+      return false;
+    }
+    FActorSpawnParameters SpawnParameters;
+    SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+    const FTransform SpawnTransform(CachedGridRotation, GridToWorld(FVector2D(Record.Cell)));
+    AActor* Item = World->SpawnActor(ItemClass, &SpawnTransform, SpawnParameters);
+    FGridItemPlacement Placement;
+    Placement.Item = Item;
+    Placement.GridPosition = FVector2D(Record.Cell);
+    Placement.Rotation = Record.Value;
+    TArray<int32> FailedPlacements;
+    if (Item == nullptr || !PlaceItems({Placement}, FailedPlacements)) {
+      if (Item) {
+        Item->Destroy();
+      }
+      return false;
+    }
+    return true;
   }
 
-  return CanPlaceItemInCell(Item, Cell);
-}
+  case EGridJournalOp::RemoveItem: {
+    AActor* Item = FindItemAtOrigin(Record.Cell);
+    if (Item == nullptr || !RemoveItem(Item)) {
+      return false;
+    }
+    // the item was spawned by the recovery, nothing else refers to it
+    Item->Destroy();
+    return true;
+  }
 
-bool AGrid::CanPlaceItemAtWorldPosition(const AActor* Item, const FVector& WorldPosition) const {
-  if (!Item) return false;
-  if (!IsPlaceableItem(Item)) return false;
-  UGridCell *Cell = GetCellAtWorldPosition(WorldPosition);
-  if (!Cell) {
-    return false;
+  case EGridJournalOp::MoveItem: {
+    AActor* Item = FindItemAtOrigin(Record.Cell);
+    if (Item == nullptr) {
+      return false;
+    }
+    GetGridComponent(Item)->Update(FVector2D(Record.Target), Record.Value);
+    return true;
   }
 
-  return CanPlaceItemInCell(Item, Cell);
+  case EGridJournalOp::CellType:
+    if (!IsCellValid(Record.Cell.X, Record.Cell.Y)) {
+      return false;
+    }
+    SetCellType(Record.Cell.X, Record.Cell.Y, Record.CellType);
+    return true;
+
+  case EGridJournalOp::WaterLevel:
+  case EGridJournalOp::SoilQuality:
+    if (!IsCellValid(Record.Cell.X, Record.Cell.Y)) {
+      return false;
+    }
+    if (Record.Op == EGridJournalOp::WaterLevel) {
+      SetWaterLevel(Record.Cell.X, Record.Cell.Y, Record.Value);
+    } else {
+      SetSoilQuality(Record.Cell.X, Record.Cell.Y, Record.Value);
+    }
+    return true;
+  }
+  return false;
 }
 
-// Check if an item can be placed
-bool AGrid::CanPlaceItem(const AActor* Item) const {
-  if (!Item) return false;
-  if (!IsPlaceableItem(Item)) return false;
-  // get the world position of the item
-  FVector WorldPosition = Item->GetActorLocation();
-  return CanPlaceItemAtWorldPosition(Item, WorldPosition);
+///////// PATHFINDING /////////
+
+FGridPathfinder& AGrid::GetUpdatedPathfinder() const {
+  Pathfinder.Update([this](int32 x, int32 y) { return IsCellBlocked(x, y); });
+  return Pathfinder;
 }
 
-///////// Cell Queries /////////
+bool AGrid::IsCellWalkable(int32 X, int32 Y) const {
+  return IsCellValid(X, Y) && !IsCellBlocked(X, Y);
+}
 
-TArray<UGridCell*> AGrid::GetNeighborCells(const UGridCell* Cell, bool IncludeOccupied) const {
-  TArray<UGridCell*> Neighbors;
-  if (!Cell) {
-    return Neighbors;
+bool AGrid::FindPath(const FVector2D& Start, const FVector2D& Goal, TArray<FVector2D>& OutPath, EGridPathAlgorithm Algorithm) const {
+  OutPath.Reset();
+  TArray<FIntPoint> Cells;
+  if (!FindPathCells(FIntPoint(Start.X, Start.Y), FIntPoint(Goal.X, Goal.Y), Cells, Algorithm)) {
+    return false;
   }
-
-  // get the grid position of the cell
-  FVector2D GridPosition = Cell->GridPosition;
-  // for each direction
-  for (int32 y = -1; y <= 1; ++y) {
-    for (int32 x = -1; x <= 1; ++x) {
-      // skip the center cell
-      if (x == 0 && y == 0) {
-        continue;
-      }
-      // get the neighbor cell position
-      FVector2D NeighborPosition = GridPosition + FVector2D(x, y);
-      // check if the neighbor position is valid
-      if (IsCellValid(NeighborPosition.X, NeighborPosition.Y)) {
-        // get the neighbor cell
-        UGridCell *Neighbor = GetGridCellAtGridPosition(NeighborPosition);
-        if (Neighbor) {
-          // if we are including occupied cells, add the neighbor
-          if (IncludeOccupied || !Neighbor->IsOccupied()) {
-            Neighbors.Add(Neighbor);
-          }
-        }
-      }
-    }
+  OutPath.Reserve(Cells.Num());
+  for (const FIntPoint& Cell : Cells) {
+    OutPath.Add(FVector2D(Cell));
   }
+  return true;
+}
 
-  return Neighbors;
+bool AGrid::FindPathCells(const FIntPoint& Start, const FIntPoint& Goal, TArray<FIntPoint>& OutPath, EGridPathAlgorithm Algorithm) const {
+  GRID_SCOPE_CYCLE_COUNTER(STAT_GridPathfinding);
+  return GetUpdatedPathfinder().FindPath(Start, Goal, Algorithm, OutPath);
 }
 
-TArray<UGridCell*> AGrid::GetCells(const FVector2D& GridPosition, const FVector2D& GridSize) const {
-  TArray<UGridCell*> Cells;
-  // note: we have to handle the case where the width or height are odd, so we
-  // have to ceil the division by 2
-  for (int32 y = 0; y < GridSize.Y; ++y) {
-    for (int32 x = 0; x < GridSize.X; ++x) {
-      FVector2D CellPosition = GridPosition + FVector2D(x, y);
-      UGridCell *Cell = GetGridCellAtGridPosition(CellPosition);
-      if (Cell) {
-        Cells.Add(Cell);
-      }
-    }
+bool AGrid::GetFlowFieldStep(const FVector2D& Target, const FVector2D& From, FVector2D& OutNextCell) const {
+  FIntPoint FromCell(From.X, From.Y);
+  if (!IsCellValid(FromCell.X, FromCell.Y)) {
+    return false;
   }
+  const FGridFlowField* Field = GetFlowField(FIntPoint(Target.X, Target.Y));
+  FIntPoint NextCell;
+  if (Field == nullptr || !Field->GetNextCell(FromCell, NextCell)) {
+    return false;
+  }
+  OutNextCell = FVector2D(NextCell);
+  return true;
+}
 
-  return Cells;
+const FGridFlowField* AGrid::GetFlowField(const FIntPoint& Target) const {
+  GRID_SCOPE_CYCLE_COUNTER(STAT_GridPathfinding);
+  return GetUpdatedPathfinder().GetFlowField(Target);
 }
 
 ///////// PLACEMENT /////////
@@ -417,33 +2083,43 @@ bool AGrid::PlaceItem(AActor* Item) {
   // get the grid position of the item
   FVector2D GridPosition = WorldToGrid(WorldPosition);
 
-  // get the cell at the grid position for the item's origin cell
-  UGridCell *Cell = GetCellAtGridPosition(GridPosition);
-  if (!Cell) {
-    return false;
-  }
-
-  return PlaceItemInCell(Item, Cell);
+  return PlaceItemAtXY(Item, GridPosition.X, GridPosition.Y);
 }
 
 bool AGrid::PlaceItemInCell(AActor* Item, UGridCell* GridCell) {
   if (!Item) return false;
   if (!GridCell) return false;
+
+  return PlaceItemAtXY(Item, GridCell->GridPosition.X, GridCell->GridPosition.Y);
+}
+
+bool AGrid::PlaceItemAtXY(AActor* Item, int32 X, int32 Y) {
+  GRID_SCOPE_CYCLE_COUNTER(STAT_GridPlaceItems);
+  WaitForGridReady();
+  if (!Item) return false;
+  if (!IsCellValid(X, Y)) return false;
   if (!IsPlaceableItem(Item)) return false;
   auto GridComponent = GetGridComponent(Item);
 
-  if (!CanPlaceItemInCell(Item, GridCell)) {
-    UE_LOG(LogTemp, Warning, TEXT("Cannot place item: %s"), *Item->GetName());
+  if (!CanPlaceItemAtXY(Item, X, Y)) {
+    GRID_COUNTER_INC(PlacementsRejected);
+    UE_LOG(LogGridManager, Verbose, TEXT("Cannot place item: %s"), *Item->GetName());
     return false;
   }
 
   // Update the Item to the new position, which will update the occupied cells
-  GridComponent->PlaceInGrid(this, GridCell->GridPosition, GridComponent->Rotation);
+  GridComponent->PlaceInGrid(this, FVector2D(X, Y), GridComponent->Rotation);
+
+  GRID_COUNTER_INC(ItemsPlaced);
+  INC_DWORD_STAT(STAT_GridPlacements);
+  UE_LOG(LogGridManager, Verbose, TEXT("Item placed: %s"), *Item->GetName());
 
-  UE_LOG(LogTemp, Log, TEXT("Item placed: %s"), *Item->GetName());
+  // add the item to the grid, if it was not already on it
+  ItemRegistry.Add(Item);
 
-  // add the item to the grid
-  ManagedItems.Add(Item);
+  if (OnItemsChanged.IsBound()) {
+    OnItemsChanged.Broadcast({Item}, {});
+  }
 
   return true;
 }
@@ -451,12 +2127,8 @@ bool AGrid::PlaceItemInCell(AActor* Item, UGridCell* GridCell) {
 bool AGrid::PlaceItemAtGridPosition(AActor* Item, const FVector2D& GridPosition) {
   if (!Item) return false;
 
-  UGridCell *Cell = GetCellAtGridPosition(GridPosition);
-  if (!Cell) {
-    return false;
-  }
-
-  return PlaceItemInCell(Item, Cell);
+  const FIntPoint Cell = GetPlacementCell(GridPosition);
+  return PlaceItemAtXY(Item, Cell.X, Cell.Y);
 }
 
 ///////// REMOVAL /////////
@@ -464,26 +2136,159 @@ bool AGrid::PlaceItemAtGridPosition(AActor* Item, const FVector2D& GridPosition)
 // Remove an item from the grid
 bool AGrid::RemoveItem(AActor* Item)
 {
+  GRID_SCOPE_CYCLE_COUNTER(STAT_GridRemoveItems);
+  WaitForGridReady();
   if (!Item) return false;
   if (!IsPlaceableItem(Item)) return false;
   auto GridComponent = GetGridComponent(Item);
 
-  TArray<UGridCell*> CellsToFree = GridComponent->OccupiedCells;
-  for (UGridCell* Cell : CellsToFree) {
-    if (!Cell) {
+  RecordItemRemoval(GridComponent);
+  // free the cells and forget them, so that a later update of the component
+  // does not touch cells that are no longer its own
+  ReleaseFootprint(GridComponent->OccupiedFootprint, Item);
+  GridComponent->OccupiedFootprint = FIntRect();
+
+  GRID_COUNTER_INC(ItemsRemoved);
+  UE_LOG(LogGridManager, Verbose, TEXT("Item removed: %s"), *Item->GetName());
+
+  // remove the item from the grid
+  SleepIndex.Wake(ItemRegistry.FindSlot(Item));
+  ItemRegistry.Remove(Item);
+
+  if (OnItemsChanged.IsBound()) {
+    OnItemsChanged.Broadcast({}, {Item});
+  }
+
+  return true;
+}
+
+///////// BATCH OPERATIONS /////////
+
+bool AGrid::PlaceItems(const TArray<FGridItemPlacement>& Placements, TArray<int32>& OutFailedPlacements) {
+  GRID_SCOPE_CYCLE_COUNTER(STAT_GridPlaceItems);
+  CSV_SCOPED_TIMING_STAT(GridManager, PlaceItems);
+  WaitForGridReady();
+  OutFailedPlacements.Reset();
+  if (Placements.Num() == 0) {
+    return true;
+  }
+
+  const bool bHasCellCheckOverride = GetClass()->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(AGrid, CanPlaceItemInCell));
+  // Validate every placement before changing anything. The cells claimed by
+  // the earlier placements of the batch are tracked in their own mask so that
+  // placements which overlap each other are caught as well.
+  FGridOccupancyMask BatchMask;
+  BatchMask.Init(GridWidth, GridHeight);
+  TSet<const AActor*> BatchItems;
+  BatchItems.Reserve(Placements.Num());
+  TArray<UGridComponent*> Components;
+  Components.Reserve(Placements.Num());
+
+  for (int32 i = 0; i < Placements.Num(); ++i) {
+    const FGridItemPlacement& Placement = Placements[i];
+    UGridComponent* GridComponent = GetGridComponent(Placement.Item);
+    Components.Add(GridComponent);
+
+    bool bAlreadyInBatch = false;
+    if (Placement.Item) {
+      BatchItems.Add(Placement.Item, &bAlreadyInBatch);
+    }
+    if (!GridComponent || bAlreadyInBatch) {
+      OutFailedPlacements.Add(i);
       continue;
     }
-    if (!Cell->IsOccupied()) {
+
+    const FIntPoint Cell = GetPlacementCell(Placement.GridPosition);
+    int32 X = Cell.X;
+    int32 Y = Cell.Y;
+    FIntPoint Size = GetRotatedItemSize(GridComponent->Size, Placement.Rotation);
+    bool bFits = IsCellValid(X, Y) && IsCellValid(X + Size.X - 1, Y + Size.Y - 1);
+    if (bFits) {
+      // an item which is already on this grid may overlap its own cells
+      FIntRect Ignore = ItemRegistry.Contains(Placement.Item) ? GridComponent->OccupiedFootprint : FIntRect();
+      INC_DWORD_STAT(STAT_GridOccupancyChecks);
+      INC_DWORD_STAT_BY(STAT_GridCellsVisited, Size.X * Size.Y);
+      bFits = OccupancyMask.IsRectFree(X, Y, Size.X, Size.Y, Ignore) && BatchMask.IsRectFree(X, Y, Size.X, Size.Y);
+    }
+    if (bFits && bHasCellCheckOverride) {
+      bFits = CanPlaceItemInCell(Placement.Item, GetCellView(GetGridCellIndex(X, Y)));
+    }
+    if (!bFits) {
+      OutFailedPlacements.Add(i);
       continue;
     }
-    Cell->SetOccupyingItem(nullptr);
+    BatchMask.SetRect(X, Y, Size.X, Size.Y, true);
   }
 
-  UE_LOG(LogTemp, Log, TEXT("Item removed: %s"), *Item->GetName());
+  if (OutFailedPlacements.Num() > 0) {
+    GRID_COUNTER_ADD(PlacementsRejected, OutFailedPlacements.Num());
+    UE_LOG(LogGridManager, Warning, TEXT("Cannot place %d of %d items"), OutFailedPlacements.Num(), Placements.Num());
+    return false;
+  }
 
-  // remove the item from the grid
-  ManagedItems.Remove(Item);
+  // Commit
+  TArray<AActor*> PlacedItems;
+  PlacedItems.Reserve(Placements.Num());
+  TBitArray<> GridChanged(false, Placements.Num());
+  for (int32 i = 0; i < Placements.Num(); ++i) {
+    const FGridItemPlacement& Placement = Placements[i];
+    UGridComponent* GridComponent = Components[i];
+    if (GridComponent->Grid != this) {
+      if (GridComponent->Grid != nullptr) {
+        GridComponent->Grid->RemoveItem(Placement.Item);
+      }
+      GridComponent->Grid = this;
+      GridChanged[i] = true;
+    }
+    ItemRegistry.Add(Placement.Item);
+    GridComponent->SetPlacement(FVector2D(GetPlacementCell(Placement.GridPosition)), Placement.Rotation);
+    PlacedItems.Add(Placement.Item);
+  }
+
+  // the events PlaceItemAtXY sends for a single item
+  for (int32 i = 0; i < Components.Num(); ++i) {
+    Components[i]->NotifyPlacedInGrid(GridChanged[i]);
+  }
+
+  GRID_COUNTER_ADD(ItemsPlaced, PlacedItems.Num());
+  INC_DWORD_STAT_BY(STAT_GridPlacements, PlacedItems.Num());
+  OnItemsChanged.Broadcast(PlacedItems, {});
+  return true;
+}
+
+bool AGrid::RemoveItems(const TArray<AActor*>& Items) {
+  GRID_SCOPE_CYCLE_COUNTER(STAT_GridRemoveItems);
+  WaitForGridReady();
+  if (Items.Num() == 0) {
+    return true;
+  }
+
+  // Validate: every item must be on this grid
+  TSet<AActor*> ItemsToRemove;
+  ItemsToRemove.Reserve(Items.Num());
+  for (AActor* Item : Items) {
+    if (!Item || !ItemRegistry.Contains(Item) || !GetGridComponent(Item)) {
+      UE_LOG(LogGridManager, Warning, TEXT("Cannot remove items: %s is not on this grid"), Item ? *Item->GetName() : TEXT("None"));
+      return false;
+    }
+    ItemsToRemove.Add(Item);
+  }
+
+  // Commit
+  TArray<AActor*> RemovedItems;
+  RemovedItems.Reserve(ItemsToRemove.Num());
+  for (AActor* Item : ItemsToRemove) {
+    auto GridComponent = GetGridComponent(Item);
+    RecordItemRemoval(GridComponent);
+    ReleaseFootprint(GridComponent->OccupiedFootprint, Item);
+    GridComponent->OccupiedFootprint = FIntRect();
+    SleepIndex.Wake(ItemRegistry.FindSlot(Item));
+    ItemRegistry.Remove(Item);
+    RemovedItems.Add(Item);
+  }
 
+  GRID_COUNTER_ADD(ItemsRemoved, RemovedItems.Num());
+  OnItemsChanged.Broadcast({}, RemovedItems);
   return true;
 }
 
@@ -491,7 +2296,7 @@ bool AGrid::RemoveItem(AActor* Item)
 
 bool AGrid::CanRotateItem(AActor* Item, float NewRotation) {
   if (!Item) return false;
-  if (!ManagedItems.Contains(Item)) return false;
+  if (!ItemRegistry.Contains(Item)) return false;
   auto GridComponent = GetGridComponent(Item);
   if (!GridComponent) return false;
   if (GridComponent->Rotation == NewRotation) return false;
@@ -513,17 +2318,22 @@ bool AGrid::RotateItem(AActor* Item, float NewRotation) {
 }
 
 void AGrid::DrawCell(const UGridCell* Cell, const FColor &Color, float Duration) const {
+  if (!Cell) return;
+
+  DrawCellAtXY(Cell->GridPosition.X, Cell->GridPosition.Y, Color, Duration);
+}
+
+void AGrid::DrawCellAtXY(int32 X, int32 Y, const FColor &Color, float Duration) const {
   UWorld* World = GetWorld();
   if (!World) return;
-  if (!Cell) return;
 
   FVector HalfSize = FVector(CellSize / 2, CellSize / 2, CellSize / 2);
-  FVector Center = GridToWorld(Cell->GridPosition);
+  FVector Center = GridToWorld(FVector2D(X, Y));
   // Move the center up by half the size so the box is drawn at the correct location
   // we use the actor's up vector for this to handle the grid's rotation
-  Center += GetActorUpVector() * CellSize / 2;
+  Center += CachedGridUpVector * CellSize / 2;
   // ensure the box is drawn at the correct location with the correct rotation
-  DrawDebugBox(World, Center, HalfSize, GetActorQuat(), Color, false, Duration);
+  DrawDebugBox(World, Center, HalfSize, CachedGridRotation, Color, false, Duration);
 }
 
 // Debug: Draw the grid
@@ -531,14 +2341,158 @@ void AGrid::DebugDrawGrid(const FColor& EmptyColor, const FColor& OccupiedColor)
   UWorld* World = GetWorld();
   if (!World) return;
 
-  for (const UGridCell* Cell : GridCells) {
+  for (int32 Index = 0; Index < CellStore.Num(); ++Index) {
     // Set the color to blue by default
     auto Color = EmptyColor;
     // Set the color to green if the cell is occupied
-    if (Cell->IsOccupied()) {
+    if (OccupancyMask.Get(Index % GridWidth, Index / GridWidth)) {
       Color = OccupiedColor;
     }
-    DrawCell(Cell, Color, -1.0f);
+    DrawCellAtXY(Index % GridWidth, Index / GridWidth, Color, -1.0f);
+  }
+}
+
+// Debug: Persistent grid visualization
+void AGrid::UpdateDebugDrawing() {
+  GRID_SCOPE_CYCLE_COUNTER(STAT_GridDebugDrawing);
+  // redrawn once the pending build is published
+  if (!IsGridReady()) {
+    return;
+  }
+  if (CVarGridDebugDraw.GetValueOnGameThread() == 0) {
+    if (bDebugDrawActive) {
+      // turned off, clear what we drew
+      if (DebugLineBatcher) {
+        DebugLineBatcher->Flush();
+      }
+      DebugBoxCells.Empty();
+      DebugDirtyCells.Empty();
+      bDebugDrawActive = false;
+      bDebugDrawAllDirty = true;
+    }
+    return;
+  }
+
+  if (!DebugLineBatcher) {
+    DebugLineBatcher = NewObject<ULineBatchComponent>(this, TEXT("DebugLineBatcher"), RF_Transient);
+    DebugLineBatcher->bSelectable = false;
+    DebugLineBatcher->RegisterComponent();
+  }
+  bDebugDrawActive = true;
+
+  // moving the grid or changing its layout moves every line
+  if (TransformVersion != DebugDrawTransformVersion || CellSize != DebugDrawCellSize || DebugBoxCells.Num() != CellStore.Num()
+    || DebugDirtyCells.Num() > MaxIncrementalDebugCells) {
+    bDebugDrawAllDirty = true;
+  }
+
+  TArray<FBatchedLine> Lines;
+  if (bDebugDrawAllDirty) {
+    DebugDrawTransformVersion = TransformVersion;
+    DebugDrawCellSize = CellSize;
+    DebugLineBatcher->Flush();
+    DrawDebugLattice();
+    DebugBoxCells.Init(false, CellStore.Num());
+    // only the cells which differ from the default can be occupied or
+    // unusable, the static layer's unusable cells aside
+    CellStore.ForEachNonDefaultCell([this, &Lines](int32 Index, EGridCellType Type, int32 Slot, int32 AttributeIndex) {
+      AddCellDebugBox(Index, Slot != INDEX_NONE, Type, Lines);
+    });
+    if (StaticLayer.IsMapped()) {
+      for (int32 Index = 0; Index < CellStore.Num(); ++Index) {
+        if (!DebugBoxCells[Index] && StaticLayer.IsUnusable(Index)) {
+          AddCellDebugBox(Index, false, EGridCellType::Unusable, Lines);
+        }
+      }
+    }
+  } else if (DebugDirtyCells.Num() > 0) {
+    // replace the boxes of the changed cells, each once
+    DebugDirtyCells.Sort();
+    for (int32 i = 0; i < DebugDirtyCells.Num(); ++i) {
+      const int32 Index = DebugDirtyCells[i];
+      if ((i > 0 && Index == DebugDirtyCells[i - 1]) || !CellStore.IsValidIndex(Index)) {
+        continue;
+      }
+      if (DebugBoxCells[Index]) {
+        DebugLineBatcher->ClearBatch(uint32(Index) + 1);
+        DebugBoxCells[Index] = false;
+      }
+      AddCellDebugBox(Index, OccupancyMask.Get(Index % GridWidth, Index / GridWidth), GetCellTypeAtIndex(Index), Lines);
+    }
+  } else {
+    // nothing changed
+    return;
+  }
+  DebugDirtyCells.Reset();
+  bDebugDrawAllDirty = false;
+
+  if (Lines.Num() > 0) {
+    DebugLineBatcher->DrawLines(Lines);
+  }
+}
+
+void AGrid::DrawDebugLattice() {
+  // the cell boundaries on the bottom and top of the cell boxes, a line per
+  // row and column rather than four edges per cell, and the vertical edges
+  // of the grid's corners
+  const float Half = CellSize / 2;
+  const double MinX = -Half;
+  const double MinY = -Half;
+  const double MaxX = GridWidth * CellSize - Half;
+  const double MaxY = GridHeight * CellSize - Half;
+  auto ToWorld = [this](double X, double Y, double Z) {
+    return CachedGridLocation + CachedGridRotation.RotateVector(FVector(X, Y, Z));
+  };
+
+  TArray<FBatchedLine> Lines;
+  Lines.Reserve(2 * (GridWidth + GridHeight + 2) + 4);
+  for (double Z : {0.0, double(CellSize)}) {
+    for (int32 X = 0; X <= GridWidth; ++X) {
+      const double LineX = X * CellSize - Half;
+      Lines.Add(FBatchedLine(ToWorld(LineX, MinY, Z), ToWorld(LineX, MaxY, Z), FColor::Green, -1.0f, 0.0f, SDPG_World, DebugLatticeBatchID));
+    }
+    for (int32 Y = 0; Y <= GridHeight; ++Y) {
+      const double LineY = Y * CellSize - Half;
+      Lines.Add(FBatchedLine(ToWorld(MinX, LineY, Z), ToWorld(MaxX, LineY, Z), FColor::Green, -1.0f, 0.0f, SDPG_World, DebugLatticeBatchID));
+    }
+  }
+  for (const FVector2D Corner : {FVector2D(MinX, MinY), FVector2D(MaxX, MinY), FVector2D(MinX, MaxY), FVector2D(MaxX, MaxY)}) {
+    Lines.Add(FBatchedLine(ToWorld(Corner.X, Corner.Y, 0.0), ToWorld(Corner.X, Corner.Y, CellSize), FColor::Green, -1.0f, 0.0f, SDPG_World,
+      DebugLatticeBatchID));
+  }
+  DebugLineBatcher->DrawLines(Lines);
+}
+
+void AGrid::AddCellDebugBox(int32 Index, bool bOccupied, EGridCellType Type, TArray<FBatchedLine>& OutLines) {
+  // the lattice draws the other cells
+  FColor Color;
+  if (bOccupied) {
+    Color = FColor::Red;
+  } else if (Type == EGridCellType::Unusable) {
+    Color = FColor(64, 64, 64);
+  } else {
+    return;
+  }
+  DebugBoxCells[Index] = true;
+
+  // same box as DrawCell, sitting on top of the grid plane
+  const FQuat& Rotation = CachedGridRotation;
+  const FVector Center = CachedGridLocation + Rotation.RotateVector(FVector((Index % GridWidth) * CellSize, (Index / GridWidth) * CellSize, CellSize / 2));
+  const float Half = CellSize / 2;
+  FVector Corners[8];
+  for (int32 i = 0; i < 8; ++i) {
+    FVector Offset((i & 1) ? Half : -Half, (i & 2) ? Half : -Half, (i & 4) ? Half : -Half);
+    Corners[i] = Center + Rotation.RotateVector(Offset);
+  }
+
+  // pairs of corners which differ in exactly one axis
+  static const int32 Edges[LinesPerCellBox][2] = {
+    {0, 1}, {2, 3}, {4, 5}, {6, 7},
+    {0, 2}, {1, 3}, {4, 6}, {5, 7},
+    {0, 4}, {1, 5}, {2, 6}, {3, 7},
+  };
+  for (int32 i = 0; i < LinesPerCellBox; ++i) {
+    OutLines.Add(FBatchedLine(Corners[Edges[i][0]], Corners[Edges[i][1]], Color, -1.0f, 0.0f, SDPG_World, uint32(Index) + 1));
   }
 }
 
@@ -548,13 +2502,15 @@ void AGrid::DebugDrawItem(const AActor* Item, const FColor& ItemColor) const {
   if (!World) return;
 
   if (!Item) return;
-  if (!ManagedItems.Contains(Item)) return;
+  if (!ItemRegistry.Contains(Item)) return;
   auto GridComponent = GetGridComponent(Item);
   if (!GridComponent) return;
 
-  TArray<UGridCell*> Cells = GridComponent->OccupiedCells;
-  for (UGridCell* Cell : Cells) {
-    DrawCell(Cell, ItemColor, -1.0f);
+  const FIntRect& Footprint = GridComponent->OccupiedFootprint;
+  for (int32 y = Footprint.Min.Y; y < Footprint.Max.Y; ++y) {
+    for (int32 x = Footprint.Min.X; x < Footprint.Max.X; ++x) {
+      DrawCellAtXY(x, y, ItemColor, -1.0f);
+    }
   }
 }
 
@@ -568,7 +2524,7 @@ AGrid::AGrid() {
 
 #if WITH_EDITOR
 void AGrid::EditorTick(float DeltaTime) {
-  DebugDrawGrid();
+  UpdateDebugDrawing();
 }
 #endif
 
@@ -582,6 +2538,10 @@ bool AGrid::ShouldTickIfViewportsOnly() const {
 }
 
 void AGrid::Tick(float DeltaTime) {
+  if (CellViews.Num() > 0) {
+    PruneCellViews(DeltaTime);
+  }
+  UpdateStats(DeltaTime);
   if (GetWorld() != nullptr && GetWorld()->WorldType == EWorldType::Editor) {
 #if WITH_EDITOR
     EditorTick(DeltaTime);
@@ -589,5 +2549,135 @@ void AGrid::Tick(float DeltaTime) {
 #endif
   } else {
     Super::Tick(DeltaTime);
+    if (bSimulateAttributes && IsGridReady()) {
+      TickAttributeSimulation(DeltaTime);
+    }
+    if (bUpdateItems) {
+      UpdateAllItems(DeltaTime);
+    } else {
+      // the items still wake on time while nothing updates them
+      WakeExpiredSleepers();
+      NotifyPendingWakes();
+    }
+    if (Journal) {
+      TickJournal(DeltaTime);
+    }
+    if (ResidentChunkRadius > 0 && CellStore.GetMode() == EGridStorageMode::Chunked && IsGridReady()) {
+      TickChunkResidency(DeltaTime);
+    }
+  }
+  // last, so the workers see this frame's changes
+  if (bPublishQuerySnapshots) {
+    PublishQuerySnapshot();
+  }
+}
+
+///////// WORKER THREAD QUERIES /////////
+
+TSharedPtr<const FGridQuerySnapshot, ESPMode::ThreadSafe> AGrid::GetQuerySnapshot() const {
+  FReadScopeLock Lock(QuerySnapshotLock);
+  return QuerySnapshot;
+}
+
+void AGrid::PublishQuerySnapshot() {
+  check(IsInGameThread());
+  if (!IsGridReady()) {
+    return;
+  }
+  // the game thread is the only writer, it reads the pointer without the lock
+  const bool bTransformChanged = !QuerySnapshot || QuerySnapshot->TransformVersion != TransformVersion || QuerySnapshot->CellSize != CellSize;
+  if (QuerySnapshot && !bQueryOccupancyDirty && !bQueryTypesDirty && !bTransformChanged) {
+    return;
+  }
+  GRID_SCOPE_CYCLE_COUNTER(STAT_GridQuerySnapshots);
+
+  TSharedRef<FGridQuerySnapshot, ESPMode::ThreadSafe> Snapshot = MakeShared<FGridQuerySnapshot, ESPMode::ThreadSafe>();
+  Snapshot->Version = ++QuerySnapshotVersion;
+  Snapshot->Width = GridWidth;
+  Snapshot->Height = GridHeight;
+  Snapshot->CellSize = CellSize;
+  Snapshot->GridRotation = CachedGridRotation;
+  Snapshot->GridLocation = CachedGridLocation;
+  Snapshot->WorldToLocal = CachedWorldToLocal;
+  Snapshot->TransformVersion = TransformVersion;
+
+  // copy what changed, share the rest with the last snapshot
+  if (bQueryOccupancyDirty || !QuerySnapshot) {
+    Snapshot->Occupancy = MakeShared<const FGridOccupancyMask, ESPMode::ThreadSafe>(OccupancyMask);
+  } else {
+    Snapshot->Occupancy = QuerySnapshot->Occupancy;
+  }
+  if (bQueryTypesDirty || !QuerySnapshot) {
+    TSharedRef<TArray<EGridCellType>, ESPMode::ThreadSafe> CellTypes = MakeShared<TArray<EGridCellType>, ESPMode::ThreadSafe>();
+    CellTypes->Init(CellStore.GetDefaultType(), CellStore.Num());
+    CellStore.ForEachNonDefaultCell([&CellTypes](int32 Index, EGridCellType Type, int32 Slot, int32 AttributeIndex) {
+      (*CellTypes)[Index] = Type;
+    });
+    if (StaticLayer.IsMapped()) {
+      for (int32 Index = 0; Index < CellTypes->Num(); ++Index) {
+        if (StaticLayer.IsUnusable(Index)) {
+          (*CellTypes)[Index] = EGridCellType::Unusable;
+        }
+      }
+    }
+    Snapshot->CellTypes = CellTypes;
+  } else {
+    Snapshot->CellTypes = QuerySnapshot->CellTypes;
+  }
+  bQueryOccupancyDirty = false;
+  bQueryTypesDirty = false;
+
+  FWriteScopeLock Lock(QuerySnapshotLock);
+  QuerySnapshot = Snapshot;
+}
+
+///////// STATS /////////
+
+int64 AGrid::GetMemoryUsage() const {
+  SIZE_T Size = CellStore.GetAllocatedSize() + OccupancyMask.GetAllocatedSize() + PlacementTable.GetAllocatedSize() + Pathfinder.GetAllocatedSize()
+    + AttributeField.GetAllocatedSize() + ItemRegistry.GetAllocatedSize() + SleepIndex.GetAllocatedSize() + CellAttributes.GetAllocatedSize()
+    + PendingWakes.GetAllocatedSize() + WakeScratch.GetAllocatedSize() + DebugBoxCells.GetAllocatedSize() + DebugDirtyCells.GetAllocatedSize()
+    + CellViews.GetAllocatedSize() + (QuerySnapshot ? QuerySnapshot->GetAllocatedSize() : 0);
+  // the cell views are objects of their own
+  for (const auto& Pair : CellViews) {
+    if (const UGridCell* Cell = Pair.Value.Get()) {
+      Size += Cell->GetClass()->GetStructureSize();
+    }
+  }
+  return int64(Size);
+}
+
+void AGrid::UpdateStats(float DeltaTime) {
+#if STATS
+  if (!FThreadStats::IsCollectingData()) {
+    return;
+  }
+  // the totals are shared by all the grids, so each grid applies the change
+  // of its own share. grid.Memory has the up to date breakdown.
+  StatsMemoryTimer += DeltaTime;
+  if (StatsMemoryTimer >= 1.0f || ReportedMemory == 0) {
+    StatsMemoryTimer = 0.0f;
+    const int64 Memory = GetMemoryUsage();
+    if (Memory != ReportedMemory) {
+      DEC_MEMORY_STAT_BY(STAT_GridMemory, ReportedMemory);
+      INC_MEMORY_STAT_BY(STAT_GridMemory, Memory);
+      ReportedMemory = Memory;
+    }
+  }
+  const int32 CellObjects = CellViews.Num();
+  if (CellObjects != ReportedCellObjects) {
+    DEC_DWORD_STAT_BY(STAT_GridLiveCellObjects, ReportedCellObjects);
+    INC_DWORD_STAT_BY(STAT_GridLiveCellObjects, CellObjects);
+    ReportedCellObjects = CellObjects;
   }
+#endif
+}
+
+void AGrid::ClearStats() {
+#if STATS
+  DEC_MEMORY_STAT_BY(STAT_GridMemory, ReportedMemory);
+  DEC_DWORD_STAT_BY(STAT_GridLiveCellObjects, ReportedCellObjects);
+#endif
+  ReportedMemory = 0;
+  ReportedCellObjects = 0;
 }
@@ -0,0 +1,105 @@
+#include "GridAttributeField.h"
+#include "Async/ParallelFor.h"
+
+// Rows per ParallelFor task. The partition doesn't affect the result, only how
+// the work is spread across the cores.
+static constexpr int32 RowsPerTask = 16;
+
+// Below this many cells a step is cheaper than waking the worker threads
+static constexpr int32 MinCellsForParallelStep = 64 * 64;
+
+void FGridAttributeField::Init(int32 InWidth, int32 InHeight, float WaterLevel, float SoilQuality) {
+  Width = FMath::Max(0, InWidth);
+  Height = FMath::Max(0, InHeight);
+
+  WaterLevels.Init(WaterLevel, Width * Height);
+  SoilQualities.Init(SoilQuality, Width * Height);
+  NextWaterLevels.Empty();
+  NextSoilQualities.Empty();
+}
+
+bool FGridAttributeField::InitFromColumns(int32 InWidth, int32 InHeight, TArray<float> InWaterLevels, TArray<float> InSoilQualities) {
+  const int32 NumCells = FMath::Max(0, InWidth) * FMath::Max(0, InHeight);
+  if (InWaterLevels.Num() != NumCells || InSoilQualities.Num() != NumCells) {
+    return false;
+  }
+
+  Width = FMath::Max(0, InWidth);
+  Height = FMath::Max(0, InHeight);
+  WaterLevels = MoveTemp(InWaterLevels);
+  SoilQualities = MoveTemp(InSoilQualities);
+  NextWaterLevels.Empty();
+  NextSoilQualities.Empty();
+  return true;
+}
+
+void FGridAttributeField::Empty() {
+  Width = 0;
+  Height = 0;
+  WaterLevels.Empty();
+  SoilQualities.Empty();
+  NextWaterLevels.Empty();
+  NextSoilQualities.Empty();
+}
+
+void FGridAttributeField::Step(const FGridAttributeSimulationSettings& Settings, float DeltaTime) {
+  if (!IsInitialized() || DeltaTime <= 0.0f) {
+    return;
+  }
+
+  // explicit diffusion is only stable while a cell gives away at most a
+  // quarter of the difference to each of its 4 neighbors
+  const float Diffusion = FMath::Min(Settings.WaterDiffusionRate * DeltaTime, 0.25f);
+  const float WaterRetained = FMath::Max(0.0f, 1.0f - Settings.EvaporationRate * DeltaTime);
+  const float SoilRetained = FMath::Max(0.0f, 1.0f - Settings.SoilDecayRate * DeltaTime);
+
+  NextWaterLevels.SetNumUninitialized(WaterLevels.Num());
+  NextSoilQualities.SetNumUninitialized(SoilQualities.Num());
+
+  const int32 NumTasks = FMath::DivideAndRoundUp(Height, RowsPerTask);
+  const EParallelForFlags Flags = Width * Height < MinCellsForParallelStep ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None;
+  ParallelFor(NumTasks, [this, Diffusion, WaterRetained, SoilRetained](int32 Task) {
+    const int32 RowBegin = Task * RowsPerTask;
+    StepRows(RowBegin, FMath::Min(RowBegin + RowsPerTask, Height), Diffusion, WaterRetained, SoilRetained);
+  }, Flags);
+
+  Swap(WaterLevels, NextWaterLevels);
+  Swap(SoilQualities, NextSoilQualities);
+}
+
+void FGridAttributeField::StepRows(int32 RowBegin, int32 RowEnd, float Diffusion, float WaterRetained, float SoilRetained) {
+  const float* Water = WaterLevels.GetData();
+  const float* Soil = SoilQualities.GetData();
+  float* NextWater = NextWaterLevels.GetData();
+  float* NextSoil = NextSoilQualities.GetData();
+
+  for (int32 y = RowBegin; y < RowEnd; ++y) {
+    const int32 Row = y * Width;
+    for (int32 x = 0; x < Width; ++x) {
+      const int32 Index = Row + x;
+      const float Level = Water[Index];
+      // the edges of the grid don't let water through, so the total amount is
+      // only changed by evaporation
+      float Flow = 0.0f;
+      if (x > 0) {
+        Flow += Water[Index - 1] - Level;
+      }
+      if (x < Width - 1) {
+        Flow += Water[Index + 1] - Level;
+      }
+      if (y > 0) {
+        Flow += Water[Index - Width] - Level;
+      }
+      if (y < Height - 1) {
+        Flow += Water[Index + Width] - Level;
+      }
+      NextWater[Index] = FMath::Max(0.0f, (Level + Diffusion * Flow) * WaterRetained);
+      NextSoil[Index] = Soil[Index] * SoilRetained;
+    }
+  }
+}
+
+SIZE_T FGridAttributeField::GetAllocatedSize() const {
+  return WaterLevels.GetAllocatedSize() + SoilQualities.GetAllocatedSize() + NextWaterLevels.GetAllocatedSize()
+    + NextSoilQualities.GetAllocatedSize();
+}
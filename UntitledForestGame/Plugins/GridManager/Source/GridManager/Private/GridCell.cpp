@@ -41,8 +41,33 @@ bool UGridCell::IsOccupied() const {
   return OccupyingItem != nullptr;
 }
 
+AActor* UGridCell::GetOccupyingItem() const {
+  return OccupyingItem;
+}
+
+// The setters write through to the grid, which then refreshes this view
 void UGridCell::SetOccupyingItem(AActor* Item) {
-  OccupyingItem = Item;
+  if (!Grid) {
+    OccupyingItem = Item;
+    return;
+  }
+  Grid->SetCellOccupant(Grid->GetGridCellIndex(GridPosition.X, GridPosition.Y), Item);
+}
+
+void UGridCell::SetCellType(EGridCellType NewCellType) {
+  if (!Grid) {
+    CellType = NewCellType;
+    return;
+  }
+  Grid->SetCellType(GridPosition.X, GridPosition.Y, NewCellType);
+}
+
+void UGridCell::SetAttributes(UGridCellAttributes* NewAttributes) {
+  if (!Grid) {
+    Attributes = NewAttributes;
+    return;
+  }
+  Grid->SetGridCellAttributes(GridPosition.X, GridPosition.Y, NewAttributes);
 }
 
 UWorld* UGridCell::GetWorld() const
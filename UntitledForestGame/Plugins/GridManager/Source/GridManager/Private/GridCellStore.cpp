@@ -0,0 +1,382 @@
+#include "GridCellStore.h"
+#include "Misc/Compression.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+void FGridCellStore::Init(int32 InWidth, int32 InHeight, EGridCellType InDefaultType, EGridStorageMode InMode) {
+  Width = FMath::Max(0, InWidth);
+  Height = FMath::Max(0, InHeight);
+  DefaultType = InDefaultType;
+  Mode = InMode;
+
+  Chunks.Reset();
+  SparseKeys.Empty();
+  SparseCells.Empty();
+  NumSparseCells = 0;
+  ReadScratch = FGridCellChunk();
+  ReadScratchChunk = INDEX_NONE;
+  if (Mode == EGridStorageMode::Sparse) {
+    NumChunksX = 0;
+    NumChunksY = 0;
+    return;
+  }
+
+  // every chunk starts out unallocated
+  NumChunksX = (Width + ChunkMask) >> ChunkShift;
+  NumChunksY = (Height + ChunkMask) >> ChunkShift;
+  Chunks.SetNum(NumChunksX * NumChunksY);
+}
+
+void FGridCellStore::SetMode(EGridStorageMode NewMode) {
+  if (NewMode == Mode) {
+    return;
+  }
+
+  struct FCell
+  {
+    int32 Index;
+    EGridCellType Type;
+    int32 Slot;
+    int32 AttributeIndex;
+  };
+  TArray<FCell> Cells;
+  ForEachNonDefaultCell([&Cells](int32 Index, EGridCellType Type, int32 Slot, int32 AttributeIndex) {
+    Cells.Add({Index, Type, Slot, AttributeIndex});
+  });
+
+  Init(Width, Height, DefaultType, NewMode);
+  for (const FCell& Cell : Cells) {
+    SetType(Cell.Index, Cell.Type);
+    SetOccupantSlot(Cell.Index, Cell.Slot);
+    SetAttributeIndex(Cell.Index, Cell.AttributeIndex);
+  }
+}
+
+void FGridCellStore::Empty() {
+  Width = 0;
+  Height = 0;
+  NumChunksX = 0;
+  NumChunksY = 0;
+  Chunks.Empty();
+  SparseKeys.Empty();
+  SparseCells.Empty();
+  NumSparseCells = 0;
+  ReadScratch = FGridCellChunk();
+  ReadScratchChunk = INDEX_NONE;
+}
+
+//// Cells ////
+
+EGridCellType FGridCellStore::GetType(int32 Index) const {
+  if (Mode == EGridStorageMode::Sparse) {
+    int32 Slot = FindSparseSlot(PackIndex(Index));
+    return Slot != INDEX_NONE ? SparseCells[Slot].Type : DefaultType;
+  }
+  int32 ChunkIndex, Local;
+  Locate(Index, ChunkIndex, Local);
+  const FGridCellChunk* Chunk = GetChunkForRead(ChunkIndex);
+  return Chunk ? Chunk->Types[Local] : DefaultType;
+}
+
+void FGridCellStore::SetType(int32 Index, EGridCellType Type) {
+  if (Mode == EGridStorageMode::Sparse) {
+    int32 Slot = Type == DefaultType ? FindSparseSlot(PackIndex(Index)) : FindOrAddSparseSlot(PackIndex(Index));
+    if (Slot != INDEX_NONE) {
+      SparseCells[Slot].Type = Type;
+      RemoveSparseSlotIfDefault(Slot);
+    }
+    return;
+  }
+  int32 ChunkIndex, Local;
+  Locate(Index, ChunkIndex, Local);
+  // writing the default value doesn't need a chunk
+  if (Type == DefaultType && Chunks[ChunkIndex].State == EGridChunkState::Unallocated) {
+    return;
+  }
+  GetChunkForWrite(ChunkIndex).Types[Local] = Type;
+}
+
+int32 FGridCellStore::GetOccupantSlot(int32 Index) const {
+  if (Mode == EGridStorageMode::Sparse) {
+    int32 Slot = FindSparseSlot(PackIndex(Index));
+    return Slot != INDEX_NONE ? SparseCells[Slot].OccupantSlot : INDEX_NONE;
+  }
+  int32 ChunkIndex, Local;
+  Locate(Index, ChunkIndex, Local);
+  const FGridCellChunk* Chunk = GetChunkForRead(ChunkIndex);
+  return Chunk ? Chunk->OccupantSlots[Local] : INDEX_NONE;
+}
+
+void FGridCellStore::SetOccupantSlot(int32 Index, int32 Slot) {
+  if (Mode == EGridStorageMode::Sparse) {
+    int32 TableSlot = Slot == INDEX_NONE ? FindSparseSlot(PackIndex(Index)) : FindOrAddSparseSlot(PackIndex(Index));
+    if (TableSlot != INDEX_NONE) {
+      SparseCells[TableSlot].OccupantSlot = Slot;
+      RemoveSparseSlotIfDefault(TableSlot);
+    }
+    return;
+  }
+  int32 ChunkIndex, Local;
+  Locate(Index, ChunkIndex, Local);
+  if (Slot == INDEX_NONE && Chunks[ChunkIndex].State == EGridChunkState::Unallocated) {
+    return;
+  }
+  GetChunkForWrite(ChunkIndex).OccupantSlots[Local] = Slot;
+}
+
+int32 FGridCellStore::GetAttributeIndex(int32 Index) const {
+  if (Mode == EGridStorageMode::Sparse) {
+    int32 Slot = FindSparseSlot(PackIndex(Index));
+    return Slot != INDEX_NONE ? SparseCells[Slot].AttributeIndex : INDEX_NONE;
+  }
+  int32 ChunkIndex, Local;
+  Locate(Index, ChunkIndex, Local);
+  const FGridCellChunk* Chunk = GetChunkForRead(ChunkIndex);
+  return Chunk ? Chunk->AttributeIndices[Local] : INDEX_NONE;
+}
+
+void FGridCellStore::SetAttributeIndex(int32 Index, int32 AttributeIndex) {
+  if (Mode == EGridStorageMode::Sparse) {
+    int32 Slot = AttributeIndex == INDEX_NONE ? FindSparseSlot(PackIndex(Index)) : FindOrAddSparseSlot(PackIndex(Index));
+    if (Slot != INDEX_NONE) {
+      SparseCells[Slot].AttributeIndex = AttributeIndex;
+      RemoveSparseSlotIfDefault(Slot);
+    }
+    return;
+  }
+  int32 ChunkIndex, Local;
+  Locate(Index, ChunkIndex, Local);
+  if (AttributeIndex == INDEX_NONE && Chunks[ChunkIndex].State == EGridChunkState::Unallocated) {
+    return;
+  }
+  GetChunkForWrite(ChunkIndex).AttributeIndices[Local] = AttributeIndex;
+}
+
+//// Sparse table ////
+
+int32 FGridCellStore::FindSparseSlot(uint64 Key) const {
+  if (NumSparseCells == 0) {
+    return INDEX_NONE;
+  }
+  const int32 Mask = SparseKeys.Num() - 1;
+  // the table is never full, so we always reach an empty slot
+  for (int32 Slot = GetHomeSlot(Key);; Slot = (Slot + 1) & Mask) {
+    if (SparseKeys[Slot] == Key) {
+      return Slot;
+    }
+    if (SparseKeys[Slot] == EmptySparseKey) {
+      return INDEX_NONE;
+    }
+  }
+}
+
+int32 FGridCellStore::FindOrAddSparseSlot(uint64 Key) {
+  // keep the load factor under 3/4
+  if ((NumSparseCells + 1) * 4 > SparseKeys.Num() * 3) {
+    RehashSparse(FMath::Max(16, SparseKeys.Num() * 2));
+  }
+
+  const int32 Mask = SparseKeys.Num() - 1;
+  int32 Slot = GetHomeSlot(Key);
+  for (; SparseKeys[Slot] != EmptySparseKey; Slot = (Slot + 1) & Mask) {
+    if (SparseKeys[Slot] == Key) {
+      return Slot;
+    }
+  }
+  SparseKeys[Slot] = Key;
+  SparseCells[Slot] = FGridSparseCell();
+  SparseCells[Slot].Type = DefaultType;
+  ++NumSparseCells;
+  return Slot;
+}
+
+void FGridCellStore::RemoveSparseSlotIfDefault(int32 Slot) {
+  const FGridSparseCell& Cell = SparseCells[Slot];
+  if (Cell.Type != DefaultType || Cell.OccupantSlot != INDEX_NONE || Cell.AttributeIndex != INDEX_NONE) {
+    return;
+  }
+
+  // backward shift deletion: pull later entries of the probe sequence into the
+  // hole so lookups never need tombstones
+  const int32 Mask = SparseKeys.Num() - 1;
+  int32 Hole = Slot;
+  for (int32 Next = (Hole + 1) & Mask; SparseKeys[Next] != EmptySparseKey; Next = (Next + 1) & Mask) {
+    // distance from the entry's home slot to the hole and to where it is now
+    const int32 Home = GetHomeSlot(SparseKeys[Next]);
+    if (((Hole - Home) & Mask) < ((Next - Home) & Mask)) {
+      SparseKeys[Hole] = SparseKeys[Next];
+      SparseCells[Hole] = SparseCells[Next];
+      Hole = Next;
+    }
+  }
+  SparseKeys[Hole] = EmptySparseKey;
+  SparseCells[Hole] = FGridSparseCell();
+  --NumSparseCells;
+}
+
+void FGridCellStore::RehashSparse(int32 NewCapacity) {
+  TArray<uint64> OldKeys = MoveTemp(SparseKeys);
+  TArray<FGridSparseCell> OldCells = MoveTemp(SparseCells);
+
+  SparseKeys.Init(EmptySparseKey, NewCapacity);
+  SparseCells.SetNum(NewCapacity);
+  const int32 Mask = NewCapacity - 1;
+  for (int32 i = 0; i < OldKeys.Num(); ++i) {
+    if (OldKeys[i] == EmptySparseKey) {
+      continue;
+    }
+    int32 Slot = GetHomeSlot(OldKeys[i]);
+    while (SparseKeys[Slot] != EmptySparseKey) {
+      Slot = (Slot + 1) & Mask;
+    }
+    SparseKeys[Slot] = OldKeys[i];
+    SparseCells[Slot] = OldCells[i];
+  }
+}
+
+//// Chunks ////
+
+const FGridCellChunk* FGridCellStore::GetChunkForRead(int32 ChunkIndex) const {
+  const FGridCellChunk& Chunk = Chunks[ChunkIndex];
+  if (Chunk.State == EGridChunkState::Resident) {
+    return &Chunk;
+  }
+  if (Chunk.State == EGridChunkState::Unallocated) {
+    return nullptr;
+  }
+  // read the cells without paging the chunk in, which chunks are resident is
+  // up to the owner of the store
+  if (ReadScratchChunk != ChunkIndex) {
+    ReadScratchChunk = INDEX_NONE;
+    if (!DecompressChunk(Chunk, ReadScratch)) {
+      return nullptr;
+    }
+    ReadScratchChunk = ChunkIndex;
+  }
+  return &ReadScratch;
+}
+
+FGridCellChunk& FGridCellStore::GetChunkForWrite(int32 ChunkIndex) {
+  FGridCellChunk& Chunk = Chunks[ChunkIndex];
+  if (Chunk.State == EGridChunkState::PagedOut) {
+    PageIn(ChunkIndex % NumChunksX, ChunkIndex / NumChunksX);
+  }
+  if (Chunk.State != EGridChunkState::Resident) {
+    AllocateChunk(Chunk);
+  }
+  return Chunk;
+}
+
+void FGridCellStore::AllocateChunk(FGridCellChunk& Chunk) const {
+  Chunk.Types.Init(DefaultType, CellsPerChunk);
+  Chunk.OccupantSlots.Init(INDEX_NONE, CellsPerChunk);
+  Chunk.AttributeIndices.Init(INDEX_NONE, CellsPerChunk);
+  Chunk.PagedData.Empty();
+  Chunk.PagedDataUncompressedSize = 0;
+  Chunk.State = EGridChunkState::Resident;
+}
+
+bool FGridCellStore::IsChunkDefault(const FGridCellChunk& Chunk) const {
+  for (int32 i = 0; i < CellsPerChunk; ++i) {
+    if (Chunk.Types[i] != DefaultType || Chunk.OccupantSlots[i] != INDEX_NONE || Chunk.AttributeIndices[i] != INDEX_NONE) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void FGridCellStore::SerializeChunkCells(FArchive& Ar, FGridCellChunk& Chunk) {
+  Ar << Chunk.Types;
+  Ar << Chunk.OccupantSlots;
+  Ar << Chunk.AttributeIndices;
+}
+
+bool FGridCellStore::PageOut(int32 ChunkX, int32 ChunkY) {
+  if (!IsValidChunk(ChunkX, ChunkY)) {
+    return false;
+  }
+  FGridCellChunk& Chunk = Chunks[GetChunkIndex(ChunkX, ChunkY)];
+  if (Chunk.State != EGridChunkState::Resident) {
+    return false;
+  }
+  ReadScratchChunk = INDEX_NONE;
+
+  // nothing worth keeping, the chunk can be recreated on demand
+  if (IsChunkDefault(Chunk)) {
+    Chunk = FGridCellChunk();
+    return true;
+  }
+
+  TArray<uint8> Uncompressed;
+  FMemoryWriter Writer(Uncompressed);
+  SerializeChunkCells(Writer, Chunk);
+
+  int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, Uncompressed.Num());
+  Chunk.PagedData.SetNumUninitialized(CompressedSize);
+  if (!FCompression::CompressMemory(NAME_Zlib, Chunk.PagedData.GetData(), CompressedSize, Uncompressed.GetData(), Uncompressed.Num())) {
+    // keep the chunk resident rather than lose its cells
+    Chunk.PagedData.Empty();
+    return false;
+  }
+  Chunk.PagedData.SetNum(CompressedSize);
+  Chunk.PagedDataUncompressedSize = Uncompressed.Num();
+
+  Chunk.Types.Empty();
+  Chunk.OccupantSlots.Empty();
+  Chunk.AttributeIndices.Empty();
+  Chunk.State = EGridChunkState::PagedOut;
+  return true;
+}
+
+bool FGridCellStore::DecompressChunk(const FGridCellChunk& Chunk, FGridCellChunk& OutCells) const {
+  TArray<uint8> Uncompressed;
+  Uncompressed.SetNumUninitialized(Chunk.PagedDataUncompressedSize);
+  if (!FCompression::UncompressMemory(NAME_Zlib, Uncompressed.GetData(), Uncompressed.Num(), Chunk.PagedData.GetData(), Chunk.PagedData.Num())) {
+    return false;
+  }
+
+  FMemoryReader Reader(Uncompressed);
+  SerializeChunkCells(Reader, OutCells);
+  return !Reader.IsError() && OutCells.Types.Num() == CellsPerChunk && OutCells.OccupantSlots.Num() == CellsPerChunk
+    && OutCells.AttributeIndices.Num() == CellsPerChunk;
+}
+
+bool FGridCellStore::PageIn(int32 ChunkX, int32 ChunkY) {
+  if (!IsValidChunk(ChunkX, ChunkY)) {
+    return false;
+  }
+  FGridCellChunk& Chunk = Chunks[GetChunkIndex(ChunkX, ChunkY)];
+  if (Chunk.State != EGridChunkState::PagedOut) {
+    return false;
+  }
+  ReadScratchChunk = INDEX_NONE;
+
+  if (!DecompressChunk(Chunk, Chunk)) {
+    // corrupt page, the best we can do is a chunk of default cells
+    ensureMsgf(false, TEXT("Failed to page in grid chunk (%d, %d)"), ChunkX, ChunkY);
+    AllocateChunk(Chunk);
+    return true;
+  }
+  Chunk.PagedData.Empty();
+  Chunk.PagedDataUncompressedSize = 0;
+  Chunk.State = EGridChunkState::Resident;
+  return true;
+}
+
+int32 FGridCellStore::CountChunks(EGridChunkState State) const {
+  int32 Count = 0;
+  for (const FGridCellChunk& Chunk : Chunks) {
+    Count += Chunk.State == State ? 1 : 0;
+  }
+  return Count;
+}
+
+SIZE_T FGridCellStore::GetAllocatedSize() const {
+  SIZE_T Size = Chunks.GetAllocatedSize() + SparseKeys.GetAllocatedSize() + SparseCells.GetAllocatedSize() + ReadScratch.Types.GetAllocatedSize()
+    + ReadScratch.OccupantSlots.GetAllocatedSize() + ReadScratch.AttributeIndices.GetAllocatedSize();
+  for (const FGridCellChunk& Chunk : Chunks) {
+    Size += Chunk.Types.GetAllocatedSize() + Chunk.OccupantSlots.GetAllocatedSize() + Chunk.AttributeIndices.GetAllocatedSize()
+      + Chunk.PagedData.GetAllocatedSize();
+  }
+  return Size;
+}
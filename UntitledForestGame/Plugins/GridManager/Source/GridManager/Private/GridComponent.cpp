@@ -1,11 +1,49 @@
 #include "GridComponent.h"
 #include "Grid.h"
 #include "GridCell.h"
+#include "GridManager.h"
+#include "GridManagerCounters.h"
+#include "GridManagerStats.h"
+
+// Grid component of each actor that has one, maintained by OnRegister /
+// OnUnregister. Only used from the game thread.
+static TMap<const AActor*, UGridComponent*> GGridComponentsByOwner;
 
 UGridComponent::UGridComponent() {
   PrimaryComponentTick.bCanEverTick = false;
 }
 
+UGridComponent* UGridComponent::FindGridComponent(const AActor* Actor) {
+  if (!Actor) {
+    return nullptr;
+  }
+  if (UGridComponent** Found = GGridComponentsByOwner.Find(Actor)) {
+    return *Found;
+  }
+  // not registered yet (e.g. during the actor's construction)
+  return Actor->FindComponentByClass<UGridComponent>();
+}
+
+void UGridComponent::OnRegister() {
+  Super::OnRegister();
+
+  // the first grid component of an actor is the one the grid uses
+  if (AActor* Owner = GetOwner()) {
+    GGridComponentsByOwner.FindOrAdd(Owner, this);
+  }
+}
+
+void UGridComponent::OnUnregister() {
+  if (AActor* Owner = GetOwner()) {
+    UGridComponent** Found = GGridComponentsByOwner.Find(Owner);
+    if (Found && *Found == this) {
+      GGridComponentsByOwner.Remove(Owner);
+    }
+  }
+
+  Super::OnUnregister();
+}
+
 void UGridComponent::BeginPlay() {
   Super::BeginPlay();
 }
@@ -32,62 +70,36 @@ void UGridComponent::SetGrid(AGrid* NewGrid) {
 }
 
 TArray<UGridCell*> UGridComponent::GetOccupiedCells() const {
-  return OccupiedCells;
+  if (Grid == nullptr) {
+    return TArray<UGridCell*>();
+  }
+  return Grid->GetCells(FVector2D(OccupiedFootprint.Min), FVector2D(OccupiedFootprint.Size()));
 }
 
 TArray<UGridCell*> UGridComponent::GetNeighborCells(bool IncludeOccupied) const {
+  GRID_SCOPE_CYCLE_COUNTER(STAT_GridNeighbors);
   TArray<UGridCell*> AdjacentCells;
   if (Grid == nullptr) {
     return AdjacentCells;
   }
-  // // build up a list of FVector2D's that represent the neighboring cells around
-  // // the object
-  TArray<FVector2D> NeighborCoords;
-  // use the center + the size of the object to compute the neighboring cells
-  FVector2D RotatedSize = GetRotatedSize();
-  FVector2D PermiterSize = RotatedSize + FVector2D(2.0f, 2.0f);
-  FVector2D TopLeft = Position - FVector2D(1.0f, 1.0f);
-  FVector2D BottomRight = TopLeft + PermiterSize;
-
-  // log the center, size, half size
-  UE_LOG(LogTemp, Warning, TEXT("PerimeterSize: (%f, %f)"), PermiterSize.X, PermiterSize.Y);
-  UE_LOG(LogTemp, Warning, TEXT("TopLeft: (%f, %f)"), TopLeft.X, TopLeft.Y);
-  UE_LOG(LogTemp, Warning, TEXT("BottomRight: (%f, %f)"), BottomRight.X, BottomRight.Y);
-
-  // Get coordinates for the cells around the perimeter of the object
-  for (int32 x = TopLeft.X; x < BottomRight.X; x++) {
-    for (int32 y = TopLeft.Y; y < BottomRight.Y; y++) {
-      // top edge or bottom edge, add all the cells in this row
-      if (y == TopLeft.Y || y == (BottomRight.Y-1)) {
-        NeighborCoords.Add(FVector2D(x, y));
-      } else {
-        // left edge or right edge, add the cells on the left and right
-        if (x == TopLeft.X || x == (BottomRight.X-1)) {
-          NeighborCoords.Add(FVector2D(x, y));
-        }
-      }
-    }
-  }
+  GRID_COUNTER_INC(NeighborQueries);
+  // use the position + the size of the object to compute the neighboring cells
+  FIntRect ItemRect = GetItemRect();
+  FIntPoint PermiterSize = ItemRect.Size() + FIntPoint(2, 2);
+  INC_DWORD_STAT(STAT_GridNeighborQueries);
+  INC_DWORD_STAT_BY(STAT_GridCellsVisited, 2 * (PermiterSize.X + PermiterSize.Y) - 4);
 
-  // print out the neighbor coords
-  // UE_LOG(LogTemp, Warning, TEXT("NeighborCoords:"));
-  // for (const FVector2D &Coord : NeighborCoords) {
-  //   UE_LOG(LogTemp, Warning, TEXT("  (%d, %d)"), (int32)Coord.X, (int32)Coord.Y);
-  // }
+  UE_LOG(LogGridManager, VeryVerbose, TEXT("Neighbors of %s: (%d, %d) - (%d, %d)"), *GetNameSafe(GetOwner()), ItemRect.Min.X - 1,
+    ItemRect.Min.Y - 1, ItemRect.Max.X, ItemRect.Max.Y);
 
-  for (FVector2D Coord : NeighborCoords) {
-    UGridCell* Cell = Grid->GetCellAtGridPosition(Coord);
-    if (Cell == nullptr) {
-      continue;
-    }
+  // the perimeter visits every cell once, so there is nothing to deduplicate
+  AdjacentCells.Reserve(2 * (PermiterSize.X + PermiterSize.Y));
+  Grid->ForEachPerimeterCell(ItemRect, [this, &AdjacentCells, IncludeOccupied](const FIntPoint& Cell, int32 Index) {
     // Only add the cell if it is empty or we want to include occupied cells.
-    // Only add the cell if it is not already in the list.
-    if (IncludeOccupied || Cell->IsEmpty()) {
-      if (!AdjacentCells.Contains(Cell)) {
-        AdjacentCells.Add(Cell);
-      }
+    if (IncludeOccupied || !Grid->IsCellOccupied(Cell)) {
+      AdjacentCells.Add(Grid->GetGridCellAtIndex(Index));
     }
-  }
+  });
 
   // // Less efficient, but more general way to get the adjacent cells
   // for (UGridCell* Cell : OccupiedCells) {
@@ -111,6 +123,37 @@ TArray<UGridCell*> UGridComponent::GetNeighborCells(bool IncludeOccupied) const
   return AdjacentCells;
 }
 
+void UGridComponent::UpdateOnGrid(float DeltaTime) {
+  OnGridItemUpdate.Broadcast(DeltaTime);
+}
+
+bool UGridComponent::Sleep(const FGridWakeCondition& WakeCondition) {
+  if (Grid == nullptr) {
+    return false;
+  }
+  return Grid->SleepItem(GetOwner(), WakeCondition);
+}
+
+bool UGridComponent::Wake() {
+  if (Grid == nullptr) {
+    return false;
+  }
+  return Grid->WakeItem(GetOwner());
+}
+
+bool UGridComponent::IsSleeping() const {
+  if (Grid == nullptr) {
+    return false;
+  }
+  return Grid->IsItemSleeping(GetOwner());
+}
+
+FIntRect UGridComponent::GetItemRect() const {
+  FVector2D RotatedSize = GetRotatedSize();
+  FIntPoint Min(Position.X, Position.Y);
+  return FIntRect(Min, Min + FIntPoint(FMath::CeilToInt(RotatedSize.X), FMath::CeilToInt(RotatedSize.Y)));
+}
+
 FVector2D UGridComponent::GetSize() const {
   return Size;
 }
@@ -139,33 +182,48 @@ void UGridComponent::Update(FVector2D NewPosition, float NewRotation) {
   if (Grid == nullptr) {
     return;
   }
+  SetPlacement(NewPosition, NewRotation);
+  // broadcast that the item has been updated
+  OnGridPositionRotationChanged.Broadcast(NewPosition, NewRotation);
+}
+
+void UGridComponent::SetPlacement(FVector2D NewPosition, float NewRotation) {
+  GRID_SCOPE_CYCLE_COUNTER(STAT_GridSetPlacement);
+  const FVector2D OldPosition = Position;
+  const bool bWasPlaced = OccupiedFootprint.Area() > 0;
   // set the new position and rotation
   Position = NewPosition;
   Rotation = NewRotation;
   // clear the occupied cells
-  for (UGridCell* Cell : OccupiedCells) {
-    if (Cell != nullptr) {
-      Cell->SetOccupyingItem(nullptr);
-    }
-  }
-  // Clear out the old cells
-  OccupiedCells.Empty();
+  AActor* Owner = GetOwner();
+  Grid->ReleaseFootprint(OccupiedFootprint, Owner);
   // change the size that we use for occupying cells based on the rotation
   FVector2D RotatedSize = GetRotatedSize();
   // get the new cells
-  OccupiedCells = Grid->GetCells(NewPosition, RotatedSize);
+  OccupiedFootprint = Grid->GetFootprint(NewPosition, RotatedSize);
   // set the new cells' occupying item to be the owning actor of this component
-  AActor* Owner = GetOwner();
-  for (UGridCell* Cell : OccupiedCells) {
-    if (Cell != nullptr) {
-      Cell->SetOccupyingItem(Owner);
-    }
-  }
+  Grid->OccupyFootprint(OccupiedFootprint, Owner);
+  Grid->RecordItemPlacement(Owner, bWasPlaced, OldPosition);
   // now set the owning actor's transform to be the center of the occupied cells
   FTransform NewTransform = GetWorldTransform();
   GetOwner()->SetActorTransform(NewTransform);
-  // broadcast that the item has been updated
-  OnGridPositionRotationChanged.Broadcast(NewPosition, NewRotation);
+}
+
+void UGridComponent::RestorePlacement(AGrid* NewGrid, FVector2D NewPosition, float NewRotation) {
+  Grid = NewGrid;
+  Position = NewPosition;
+  Rotation = NewRotation;
+  OccupiedFootprint = Grid->GetFootprint(NewPosition, GetRotatedSize());
+  GetOwner()->SetActorTransform(GetWorldTransform());
+}
+
+void UGridComponent::NotifyPlacedInGrid(bool bGridChanged) {
+  // same order as PlaceInGrid
+  if (bGridChanged) {
+    OnGridChanged.Broadcast(Grid);
+  }
+  OnGridPositionRotationChanged.Broadcast(Position, Rotation);
+  OnPlacedInGrid.Broadcast();
 }
 
 bool UGridComponent::RotateTo(float NewRotation) {
@@ -215,36 +273,33 @@ TArray<UGridCell*> UGridComponent::GetTargetCells(FVector2D NewPosition, float N
 }
 
 FTransform UGridComponent::GetTargetWorldTransform(FVector2D NewPosition, float NewRotation) const {
+  if (Grid == nullptr) {
+    return FTransform();
+  }
   // get the target cells
-  TArray<UGridCell*> TargetCells = GetTargetCells(NewPosition, NewRotation);
+  FIntRect TargetFootprint = Grid->GetFootprint(NewPosition, GetSizeAtRotation(NewRotation));
   // return the transform
-  return MakeTransform(NewRotation, TargetCells);
+  return MakeTransform(NewRotation, TargetFootprint);
 }
 
 FTransform UGridComponent::GetWorldTransform() const
 {
-  return MakeTransform(Rotation, OccupiedCells);
+  return MakeTransform(Rotation, OccupiedFootprint);
 }
 
-FTransform UGridComponent::MakeTransform(float AtRotation, const TArray<UGridCell*> &Cells) const {
+FTransform UGridComponent::MakeTransform(float AtRotation, const FIntRect &Footprint) const {
   if (Grid == nullptr) {
     return FTransform();
   }
-  if (Cells.Num() == 0) {
-    return FTransform();
-  }
-  UGridCell* Cell = Cells[0];
-  if (Cell == nullptr) {
+  if (Footprint.Area() <= 0) {
     return FTransform();
   }
-  FVector Location = Cell->GetWorldPosition();
+  FVector Location = Grid->GridToWorld(FVector2D(Footprint.Min));
   // if the width > 1 or the height > 1, then the position is the center of the
   // cells, which is just midway between the first and last cells
-  if (Cells.Num() > 1) {
-    UGridCell* LastCell = Cells[Cells.Num() - 1];
-    if (LastCell != nullptr) {
-      Location = (Location + LastCell->GetWorldPosition()) / 2.0f;
-    }
+  if (Footprint.Area() > 1) {
+    FVector LastLocation = Grid->GridToWorld(FVector2D(Footprint.Max - FIntPoint(1, 1)));
+    Location = (Location + LastLocation) / 2.0f;
   }
   // the rotation will be the same as the grid's, but we need to add the item's
   // rotation to it
@@ -255,13 +310,13 @@ FTransform UGridComponent::MakeTransform(float AtRotation, const TArray<UGridCel
   //    - ComposeRotators
 
   // Grid rotation
-  FRotator Rotator = Grid->GetActorRotation();
+  const FQuat& GridRotation = Grid->GetGridRotation();
   // Item is rotated along its z-axis
   FVector WorldZ = FVector(0.0f, 0.0f, 1.0f);
-  // make a rotator from the up vector and the rotation angle
-  FRotator RotationRotator = FQuat(WorldZ.GetSafeNormal(), FMath::DegreesToRadians(AtRotation)).Rotator();
-  // combine the two rotators (order is important here!)
-  Rotator = FRotator(FQuat(Rotator)*FQuat(RotationRotator));
+  // make a rotation from the up vector and the rotation angle
+  FQuat ItemRotation = FQuat(WorldZ, FMath::DegreesToRadians(AtRotation));
+  // combine the two rotations (order is important here!)
+  FRotator Rotator = FRotator(GridRotation * ItemRotation);
 
   // we don't want to change any scaling that may have been applied, so we get
   // our owner's scale and apply it
@@ -0,0 +1,100 @@
+#include "GridItemRegistry.h"
+
+FGridItemHandle FGridItemRegistry::Add(AActor* Item) {
+  if (!Item) {
+    return FGridItemHandle();
+  }
+
+  int32& Slot = SlotLookup.FindOrAdd(Item, INDEX_NONE);
+  if (Slot == INDEX_NONE) {
+    // reuse a free slot if we have one
+    if (FreeSlots.Num() > 0) {
+      Slot = FreeSlots.Pop(EAllowShrinking::No);
+    } else {
+      Slot = SlotDenseIndices.Add(INDEX_NONE);
+      SlotGenerations.Add(0);
+    }
+    SlotDenseIndices[Slot] = Items.Add(Item);
+    ItemSlots.Add(Slot);
+  }
+
+  FGridItemHandle Handle;
+  Handle.Slot = Slot;
+  Handle.Generation = SlotGenerations[Slot];
+  return Handle;
+}
+
+bool FGridItemRegistry::Remove(const AActor* Item) {
+  int32 Slot = INDEX_NONE;
+  if (!SlotLookup.RemoveAndCopyValue(Item, Slot)) {
+    return false;
+  }
+
+  // move the last item into the freed dense index
+  int32 DenseIndex = SlotDenseIndices[Slot];
+  int32 LastIndex = Items.Num() - 1;
+  if (DenseIndex != LastIndex) {
+    Items[DenseIndex] = Items[LastIndex];
+    ItemSlots[DenseIndex] = ItemSlots[LastIndex];
+    SlotDenseIndices[ItemSlots[DenseIndex]] = DenseIndex;
+  }
+  Items.Pop(EAllowShrinking::No);
+  ItemSlots.Pop(EAllowShrinking::No);
+
+  SlotDenseIndices[Slot] = INDEX_NONE;
+  ++SlotGenerations[Slot];
+  FreeSlots.Push(Slot);
+  return true;
+}
+
+FGridItemHandle FGridItemRegistry::Find(const AActor* Item) const {
+  FGridItemHandle Handle;
+  const int32* Slot = SlotLookup.Find(Item);
+  if (Slot) {
+    Handle.Slot = *Slot;
+    Handle.Generation = SlotGenerations[*Slot];
+  }
+  return Handle;
+}
+
+int32 FGridItemRegistry::FindSlot(const AActor* Item) const {
+  const int32* Slot = SlotLookup.Find(Item);
+  return Slot ? *Slot : INDEX_NONE;
+}
+
+AActor* FGridItemRegistry::Get(const FGridItemHandle& Handle) const {
+  if (!SlotGenerations.IsValidIndex(Handle.Slot) || SlotGenerations[Handle.Slot] != Handle.Generation) {
+    return nullptr;
+  }
+  return GetBySlot(Handle.Slot);
+}
+
+AActor* FGridItemRegistry::GetBySlot(int32 Slot) const {
+  if (!SlotDenseIndices.IsValidIndex(Slot)) {
+    return nullptr;
+  }
+  int32 DenseIndex = SlotDenseIndices[Slot];
+  return DenseIndex != INDEX_NONE ? Items[DenseIndex] : nullptr;
+}
+
+void FGridItemRegistry::Empty() {
+  Items.Empty();
+  ItemSlots.Empty();
+  SlotDenseIndices.Empty();
+  SlotGenerations.Empty();
+  FreeSlots.Empty();
+  SlotLookup.Empty();
+}
+
+void FGridItemRegistry::RebuildLookup() {
+  SlotLookup.Reset();
+  SlotLookup.Reserve(Items.Num());
+  for (int32 i = 0; i < Items.Num(); ++i) {
+    SlotLookup.Add(Items[i], ItemSlots[i]);
+  }
+}
+
+SIZE_T FGridItemRegistry::GetAllocatedSize() const {
+  return Items.GetAllocatedSize() + ItemSlots.GetAllocatedSize() + SlotDenseIndices.GetAllocatedSize()
+    + SlotGenerations.GetAllocatedSize() + FreeSlots.GetAllocatedSize() + SlotLookup.GetAllocatedSize();
+}
@@ -0,0 +1,118 @@
+#include "GridItemSleepIndex.h"
+
+void FGridItemSleepIndex::Empty() {
+  Records.Empty();
+  for (TArray<FTimerEntry>& Bucket : Buckets) {
+    Bucket.Empty();
+  }
+  CellSubscribers.Empty();
+  AttributeWatchers.Empty();
+}
+
+void FGridItemSleepIndex::Sleep(int32 Slot, const FGridWakeCondition& Condition, double Now, TConstArrayView<int32> NeighborCells,
+  int32 AttributeCell) {
+  if (Slot < 0) {
+    return;
+  }
+  // going back to sleep replaces the previous condition
+  Wake(Slot);
+  if (Slot >= Records.Num()) {
+    Records.SetNum(Slot + 1);
+  }
+
+  FSleepRecord& Record = Records[Slot];
+  Record.bSleeping = true;
+
+  if (Condition.WakeAfterSeconds > 0.0f) {
+    // round up, an item never wakes before its time
+    int64 DeadlineTick = FMath::Max(CurrentTick + 1, int64(FMath::CeilToDouble((Now + Condition.WakeAfterSeconds) / WheelResolution)));
+    Buckets[DeadlineTick % WheelSize].Add({Slot, Record.Generation, DeadlineTick});
+  }
+
+  if (Condition.bWakeOnNeighborChange) {
+    Record.WatchedCells.Append(NeighborCells.GetData(), NeighborCells.Num());
+    for (int32 CellIndex : NeighborCells) {
+      CellSubscribers.FindOrAdd(CellIndex).Add(Slot);
+    }
+  }
+
+  if (Condition.bWakeOnAttribute && AttributeCell != INDEX_NONE) {
+    Record.bWatchAttribute = true;
+    Record.AttributeCell = AttributeCell;
+    Record.Attribute = Condition.Attribute;
+    Record.Threshold = Condition.Threshold;
+    Record.bWakeWhenAbove = Condition.bWakeWhenAbove;
+    AttributeWatchers.Add(Slot);
+  }
+}
+
+bool FGridItemSleepIndex::Wake(int32 Slot) {
+  if (!IsSleeping(Slot)) {
+    return false;
+  }
+
+  FSleepRecord& Record = Records[Slot];
+  Record.bSleeping = false;
+  // any timer of this sleep is stale now
+  ++Record.Generation;
+
+  for (int32 CellIndex : Record.WatchedCells) {
+    if (TArray<int32, TInlineAllocator<2>>* Subscribers = CellSubscribers.Find(CellIndex)) {
+      Subscribers->RemoveSingleSwap(Slot, EAllowShrinking::No);
+      if (Subscribers->Num() == 0) {
+        CellSubscribers.Remove(CellIndex);
+      }
+    }
+  }
+  Record.WatchedCells.Reset();
+
+  if (Record.bWatchAttribute) {
+    AttributeWatchers.RemoveSingleSwap(Slot, EAllowShrinking::No);
+    Record.bWatchAttribute = false;
+  }
+  return true;
+}
+
+void FGridItemSleepIndex::AdvanceTime(double Now, TArray<int32>& OutWoken) {
+  const int64 TargetTick = int64(FMath::FloorToDouble(Now / WheelResolution));
+  if (TargetTick <= CurrentTick) {
+    return;
+  }
+
+  // past a full revolution every bucket has been visited once
+  const int64 FirstTick = FMath::Max(CurrentTick + 1, TargetTick - WheelSize + 1);
+  for (int64 Tick = FirstTick; Tick <= TargetTick; ++Tick) {
+    TArray<FTimerEntry>& Bucket = Buckets[Tick % WheelSize];
+    for (int32 i = Bucket.Num() - 1; i >= 0; --i) {
+      const FTimerEntry& Entry = Bucket[i];
+      const bool bStale = !Records.IsValidIndex(Entry.Slot) || Records[Entry.Slot].Generation != Entry.Generation;
+      if (bStale || Entry.DeadlineTick <= TargetTick) {
+        if (!bStale) {
+          OutWoken.Add(Entry.Slot);
+        }
+        Bucket.RemoveAtSwap(i, 1, EAllowShrinking::No);
+      }
+    }
+  }
+  CurrentTick = TargetTick;
+}
+
+void FGridItemSleepIndex::CollectCellSubscribers(int32 CellIndex, TArray<int32>& OutWoken) const {
+  if (const TArray<int32, TInlineAllocator<2>>* Subscribers = CellSubscribers.Find(CellIndex)) {
+    OutWoken.Append(*Subscribers);
+  }
+}
+
+SIZE_T FGridItemSleepIndex::GetAllocatedSize() const {
+  SIZE_T Size = Records.GetAllocatedSize() + CellSubscribers.GetAllocatedSize() + AttributeWatchers.GetAllocatedSize();
+  for (const FSleepRecord& Record : Records) {
+    Size += Record.WatchedCells.GetAllocatedSize();
+  }
+  for (const TArray<FTimerEntry>& Bucket : Buckets) {
+    Size += Bucket.GetAllocatedSize();
+  }
+  for (const auto& Pair : CellSubscribers) {
+    Size += Pair.Value.GetAllocatedSize();
+  }
+  return Size;
+}
@@ -0,0 +1,195 @@
+#include "GridJournal.h"
+#include "GridManager.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+// [size][crc] in front of every frame
+static constexpr int64 FrameHeaderSize = 2 * sizeof(uint32);
+
+FArchive& operator<<(FArchive& Ar, FGridJournalRecord& Record) {
+  uint8 Op = uint8(Record.Op);
+  Ar << Op;
+  Record.Op = EGridJournalOp(Op);
+  Ar << Record.Cell;
+
+  uint8 CellType = uint8(Record.CellType);
+  switch (Record.Op) {
+  case EGridJournalOp::Initialize:
+    Ar << Record.Target;
+    Ar << Record.Value;
+    Ar << CellType;
+    break;
+  case EGridJournalOp::PlaceItem:
+    Ar << Record.ItemClass;
+    Ar << Record.Value;
+    break;
+  case EGridJournalOp::RemoveItem:
+    break;
+  case EGridJournalOp::MoveItem:
+    Ar << Record.Target;
+    Ar << Record.Value;
+    break;
+  case EGridJournalOp::CellType:
+    Ar << CellType;
+    break;
+  case EGridJournalOp::WaterLevel:
+  case EGridJournalOp::SoilQuality:
+    Ar << Record.Value;
+    break;
+  default:
+    Ar.SetError();
+    break;
+  }
+  Record.CellType = EGridCellType(CellType);
+  return Ar;
+}
+
+FGridJournal::FGridJournal(const FString& InBaseFilename)
+  : BaseFilename(InBaseFilename)
+  , Generation(FDateTime::UtcNow().GetTicks()) {
+}
+
+FGridJournal::~FGridJournal() {
+  WaitForWrites();
+}
+
+void FGridJournal::Append(FGridJournalRecord& Record) {
+  const int64 OldNum = PendingRecords.Num();
+  FMemoryWriter Writer(PendingRecords, false, true);
+  Writer << Record;
+  JournalSize += PendingRecords.Num() - OldNum;
+}
+
+void FGridJournal::Flush() {
+  if (PendingRecords.Num() == 0) {
+    return;
+  }
+  Pipe.Launch(TEXT("GridJournalFlush"), [this, Records = MoveTemp(PendingRecords)]() {
+    WriteFrame(Records);
+  });
+  PendingRecords.Reset();
+}
+
+void FGridJournal::Compact(FGridSnapshot&& Snapshot) {
+  // the records so far still belong to the old journal, they are written (and
+  // then discarded with it) in case the compaction doesn't make it to disk
+  Flush();
+  const uint64 NewGeneration = ++Generation;
+  Pipe.Launch(TEXT("GridJournalCompact"), [this, Snapshot = MoveTemp(Snapshot), NewGeneration]() mutable {
+    WriteSnapshot(Snapshot, NewGeneration);
+  });
+  JournalSize = 0;
+}
+
+void FGridJournal::WaitForWrites() {
+  Pipe.WaitUntilEmpty();
+}
+
+void FGridJournal::WriteFrame(const TArray<uint8>& Records) {
+  if (!JournalFile) {
+    // the compaction which opens the journal failed
+    return;
+  }
+  uint32 Header[2] = {uint32(Records.Num()), FCrc::MemCrc32(Records.GetData(), Records.Num())};
+  bool bWritten = JournalFile->Write(reinterpret_cast<const uint8*>(Header), FrameHeaderSize);
+  bWritten = bWritten && JournalFile->Write(Records.GetData(), Records.Num());
+  bWritten = bWritten && JournalFile->Flush();
+  if (!bWritten) {
+    UE_LOG(LogGridManager, Warning, TEXT("Could not write to the grid journal %s"), *GetJournalFilename(BaseFilename));
+  }
+}
+
+void FGridJournal::WriteSnapshot(FGridSnapshot& Snapshot, uint64 NewGeneration) {
+  const double StartTime = FPlatformTime::Seconds();
+  const FString SnapshotFilename = GetSnapshotFilename(BaseFilename);
+  const FString TempFilename = SnapshotFilename + TEXT(".tmp");
+
+  TArray<uint8> Data;
+  FMemoryWriter Writer(Data);
+  Writer << NewGeneration;
+  Snapshot.Serialize(Writer);
+  // the old snapshot stays until the new one is complete
+  if (!FFileHelper::SaveArrayToFile(Data, *TempFilename) || !IFileManager::Get().Move(*SnapshotFilename, *TempFilename, true)) {
+    UE_LOG(LogGridManager, Warning, TEXT("Could not write the grid snapshot %s, the journal keeps growing"), *SnapshotFilename);
+    return;
+  }
+
+  // start the journal of the new snapshot
+  JournalFile.Reset();
+  JournalFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*GetJournalFilename(BaseFilename)));
+  if (!JournalFile) {
+    UE_LOG(LogGridManager, Warning, TEXT("Could not open the grid journal %s"), *GetJournalFilename(BaseFilename));
+    return;
+  }
+  TArray<uint8> Header;
+  FMemoryWriter HeaderWriter(Header);
+  uint32 FileMagic = Magic;
+  uint32 FileVersion = Version;
+  HeaderWriter << FileMagic;
+  HeaderWriter << FileVersion;
+  HeaderWriter << NewGeneration;
+  JournalFile->Write(Header.GetData(), Header.Num());
+  JournalFile->Flush();
+
+  UE_LOG(LogGridManager, Log, TEXT("Compacted the grid journal %s into a %d byte snapshot in %.2f ms"), *BaseFilename, Data.Num(),
+    (FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
+bool FGridJournal::Load(const FString& BaseFilename, FGridSnapshot& OutSnapshot, TArray<FGridJournalRecord>& OutRecords) {
+  OutRecords.Reset();
+
+  TArray<uint8> Data;
+  if (!FFileHelper::LoadFileToArray(Data, *GetSnapshotFilename(BaseFilename))) {
+    return false;
+  }
+  FMemoryReader SnapshotReader(Data);
+  uint64 SnapshotGeneration = 0;
+  SnapshotReader << SnapshotGeneration;
+  if (!OutSnapshot.Serialize(SnapshotReader)) {
+    return false;
+  }
+
+  if (!FFileHelper::LoadFileToArray(Data, *GetJournalFilename(BaseFilename))) {
+    return true;
+  }
+  FMemoryReader Reader(Data);
+  uint32 FileMagic = 0;
+  uint32 FileVersion = 0;
+  uint64 JournalGeneration = 0;
+  Reader << FileMagic;
+  Reader << FileVersion;
+  Reader << JournalGeneration;
+  if (Reader.IsError() || FileMagic != Magic || FileVersion != Version || JournalGeneration != SnapshotGeneration) {
+    // written before the snapshot was, everything in it is in the snapshot
+    return true;
+  }
+
+  // replay up to the first incomplete or damaged frame
+  int64 Offset = Reader.Tell();
+  while (Offset + FrameHeaderSize <= Data.Num()) {
+    uint32 FrameHeader[2];
+    FMemory::Memcpy(FrameHeader, Data.GetData() + Offset, FrameHeaderSize);
+    const int64 FrameStart = Offset + FrameHeaderSize;
+    if (FrameStart + FrameHeader[0] > Data.Num() || FCrc::MemCrc32(Data.GetData() + FrameStart, FrameHeader[0]) != FrameHeader[1]) {
+      UE_LOG(LogGridManager, Warning, TEXT("Grid journal %s ends with a damaged frame, it is skipped"), *GetJournalFilename(BaseFilename));
+      break;
+    }
+    TArrayView<const uint8> Frame(Data.GetData() + FrameStart, FrameHeader[0]);
+    FMemoryReaderView FrameReader(Frame);
+    const int32 FirstRecord = OutRecords.Num();
+    while (!FrameReader.AtEnd() && !FrameReader.IsError()) {
+      FrameReader << OutRecords.AddDefaulted_GetRef();
+    }
+    if (FrameReader.IsError()) {
+      // a frame is all or nothing
+      OutRecords.SetNum(FirstRecord);
+      break;
+    }
+    Offset = FrameStart + FrameHeader[0];
+  }
+  return true;
+}
@@ -4,6 +4,8 @@
 
 #define LOCTEXT_NAMESPACE "FGridManagerModule"
 
+DEFINE_LOG_CATEGORY(LogGridManager);
+
 void FGridManagerModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
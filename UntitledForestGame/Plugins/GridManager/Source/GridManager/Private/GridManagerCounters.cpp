@@ -0,0 +1,40 @@
+#include "GridManagerCounters.h"
+#include "GridManager.h"
+#include "HAL/IConsoleManager.h"
+
+std::atomic<int64> FGridManagerCounters::Values[FGridManagerCounters::NumCounters];
+
+const TCHAR* FGridManagerCounters::GetName(ECounter Counter) {
+  switch (Counter) {
+    case NeighborQueries: return TEXT("NeighborQueries");
+    case ItemsPlaced: return TEXT("ItemsPlaced");
+    case PlacementsRejected: return TEXT("PlacementsRejected");
+    case ItemsRemoved: return TEXT("ItemsRemoved");
+    case ItemUpdates: return TEXT("ItemUpdates");
+    case ItemUpdateOverruns: return TEXT("ItemUpdateOverruns");
+    case PathQueries: return TEXT("PathQueries");
+    case FlowFieldBuilds: return TEXT("FlowFieldBuilds");
+    default: return TEXT("Unknown");
+  }
+}
+
+void FGridManagerCounters::Reset() {
+  for (std::atomic<int64>& Value : Values) {
+    Value.store(0, std::memory_order_relaxed);
+  }
+}
+
+#if GRID_MANAGER_COUNTERS
+static FAutoConsoleCommand GridCountersCommand(
+  TEXT("grid.Counters"),
+  TEXT("Print the grid manager counters. Pass 'reset' to reset them afterwards."),
+  FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args) {
+    for (int32 i = 0; i < FGridManagerCounters::NumCounters; ++i) {
+      FGridManagerCounters::ECounter Counter = FGridManagerCounters::ECounter(i);
+      UE_LOG(LogGridManager, Display, TEXT("%s: %lld"), FGridManagerCounters::GetName(Counter), FGridManagerCounters::Get(Counter));
+    }
+    if (Args.Num() > 0 && Args[0] == TEXT("reset")) {
+      FGridManagerCounters::Reset();
+    }
+  }));
+#endif
@@ -0,0 +1,48 @@
+#include "GridManagerStats.h"
+#include "Grid.h"
+#include "GridManager.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/UObjectIterator.h"
+
+DEFINE_STAT(STAT_GridPlacements);
+DEFINE_STAT(STAT_GridOccupancyChecks);
+DEFINE_STAT(STAT_GridCellsVisited);
+DEFINE_STAT(STAT_GridNeighborQueries);
+DEFINE_STAT(STAT_GridLiveCellObjects);
+DEFINE_STAT(STAT_GridMemory);
+
+DEFINE_STAT(STAT_GridInitialize);
+DEFINE_STAT(STAT_GridPlaceItems);
+DEFINE_STAT(STAT_GridRemoveItems);
+DEFINE_STAT(STAT_GridSetPlacement);
+DEFINE_STAT(STAT_GridCheckCells);
+DEFINE_STAT(STAT_GridPlacementSearch);
+DEFINE_STAT(STAT_GridNeighbors);
+DEFINE_STAT(STAT_GridUpdateItems);
+DEFINE_STAT(STAT_GridAttributeSimulation);
+DEFINE_STAT(STAT_GridPathfinding);
+DEFINE_STAT(STAT_GridSnapshots);
+DEFINE_STAT(STAT_GridJournal);
+DEFINE_STAT(STAT_GridDebugDrawing);
+DEFINE_STAT(STAT_GridWorldLookups);
+DEFINE_STAT(STAT_GridQuerySnapshots);
+
+CSV_DEFINE_CATEGORY_MODULE(GRIDMANAGER_API, GridManager, true);
+
+// The stat only has the total, this breaks it down by grid
+static FAutoConsoleCommand GridMemoryCommand(
+  TEXT("grid.Memory"),
+  TEXT("Print the memory used by each grid."),
+  FConsoleCommandDelegate::CreateLambda([]() {
+    int64 Total = 0;
+    for (TObjectIterator<AGrid> It; It; ++It) {
+      if (It->IsTemplate()) {
+        continue;
+      }
+      const int64 Bytes = It->GetMemoryUsage();
+      UE_LOG(LogGridManager, Display, TEXT("%s (%dx%d): %.1f KiB, %d cell objects"), *It->GetPathName(), It->GridWidth, It->GridHeight, Bytes / 1024.0,
+        It->GetNumCellObjects());
+      Total += Bytes;
+    }
+    UE_LOG(LogGridManager, Display, TEXT("Total: %.1f KiB"), Total / 1024.0);
+  }));
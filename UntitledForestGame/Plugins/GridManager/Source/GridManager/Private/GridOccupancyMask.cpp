@@ -0,0 +1,140 @@
+#include "GridOccupancyMask.h"
+
+// Wide footprints test their whole middle words two at a time with SSE2, which
+// every x86-64 target we ship on has. Other CPUs use the scalar loop.
+#if PLATFORM_ENABLE_VECTORINTRINSICS && PLATFORM_CPU_X86_FAMILY
+#include <emmintrin.h>
+#define GRID_OCCUPANCY_SSE 1
+#else
+#define GRID_OCCUPANCY_SSE 0
+#endif
+
+void FGridOccupancyMask::Init(int32 InWidth, int32 InHeight) {
+  Width = FMath::Max(0, InWidth);
+  Height = FMath::Max(0, InHeight);
+  WordsPerRow = (Width + 63) / 64;
+
+  Words.Init(0, WordsPerRow * Height);
+}
+
+void FGridOccupancyMask::Empty() {
+  Width = 0;
+  Height = 0;
+  WordsPerRow = 0;
+  Words.Empty();
+}
+
+bool FGridOccupancyMask::Get(int32 X, int32 Y) const {
+  return (Words[Y * WordsPerRow + (X >> 6)] >> (X & 63)) & 1;
+}
+
+void FGridOccupancyMask::Set(int32 X, int32 Y, bool bOccupied) {
+  uint64& Word = Words[Y * WordsPerRow + (X >> 6)];
+  uint64 Bit = uint64(1) << (X & 63);
+  Word = bOccupied ? (Word | Bit) : (Word & ~Bit);
+}
+
+void FGridOccupancyMask::SetRect(int32 X, int32 Y, int32 W, int32 H, bool bOccupied) {
+  if (W <= 0 || H <= 0) {
+    return;
+  }
+  check(X >= 0 && Y >= 0 && X + W <= Width && Y + H <= Height);
+
+  int32 End = X + W;
+  int32 FirstWord = X >> 6;
+  int32 LastWord = (End - 1) >> 6;
+  for (int32 y = Y; y < Y + H; ++y) {
+    uint64* Row = &Words[y * WordsPerRow];
+    for (int32 w = FirstWord; w <= LastWord; ++w) {
+      uint64 Mask = WordRangeMask(w, X, End);
+      Row[w] = bOccupied ? (Row[w] | Mask) : (Row[w] & ~Mask);
+    }
+  }
+}
+
+uint64 FGridOccupancyMask::WordRangeMask(int32 WordIndex, int32 Begin, int32 End) {
+  int32 WordBegin = WordIndex * 64;
+  int32 Lo = FMath::Max(Begin - WordBegin, 0);
+  int32 Hi = FMath::Min(End - WordBegin, 64);
+  if (Hi <= Lo) {
+    return 0;
+  }
+
+  uint64 HiMask = Hi == 64 ? ~uint64(0) : ((uint64(1) << Hi) - 1);
+  uint64 LoMask = (uint64(1) << Lo) - 1;
+  return HiMask & ~LoMask;
+}
+
+bool FGridOccupancyMask::AnyBitSet(const uint64* RowWords, int32 Num) {
+  int32 i = 0;
+#if GRID_OCCUPANCY_SSE
+  __m128i Acc = _mm_setzero_si128();
+  for (; i + 2 <= Num; i += 2) {
+    Acc = _mm_or_si128(Acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(RowWords + i)));
+  }
+  // all 16 bytes compare equal to zero if nothing is set
+  if (_mm_movemask_epi8(_mm_cmpeq_epi8(Acc, _mm_setzero_si128())) != 0xFFFF) {
+    return true;
+  }
+#endif
+  uint64 Bits = 0;
+  for (; i < Num; ++i) {
+    Bits |= RowWords[i];
+  }
+  return Bits != 0;
+}
+
+bool FGridOccupancyMask::IsRectFree(int32 X, int32 Y, int32 W, int32 H) const {
+  if (W <= 0 || H <= 0) {
+    return true;
+  }
+  check(X >= 0 && Y >= 0 && X + W <= Width && Y + H <= Height);
+
+  int32 End = X + W;
+  int32 FirstWord = X >> 6;
+  int32 LastWord = (End - 1) >> 6;
+  // the masks of the partial words at either end are the same for every row
+  uint64 FirstMask = WordRangeMask(FirstWord, X, End);
+  uint64 LastMask = WordRangeMask(LastWord, X, End);
+  int32 NumMiddleWords = LastWord - FirstWord - 1;
+
+  for (int32 y = Y; y < Y + H; ++y) {
+    const uint64* Row = &Words[y * WordsPerRow];
+    if (Row[FirstWord] & FirstMask) {
+      return false;
+    }
+    if (LastWord != FirstWord && (Row[LastWord] & LastMask)) {
+      return false;
+    }
+    if (NumMiddleWords > 0 && AnyBitSet(Row + FirstWord + 1, NumMiddleWords)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool FGridOccupancyMask::IsRectFree(int32 X, int32 Y, int32 W, int32 H, const FIntRect& Ignore) const {
+  if (W <= 0 || H <= 0) {
+    return true;
+  }
+  check(X >= 0 && Y >= 0 && X + W <= Width && Y + H <= Height);
+
+  int32 End = X + W;
+  int32 FirstWord = X >> 6;
+  int32 LastWord = (End - 1) >> 6;
+
+  for (int32 y = Y; y < Y + H; ++y) {
+    const uint64* Row = &Words[y * WordsPerRow];
+    bool bIgnoreRow = y >= Ignore.Min.Y && y < Ignore.Max.Y;
+    for (int32 w = FirstWord; w <= LastWord; ++w) {
+      uint64 Mask = WordRangeMask(w, X, End);
+      if (bIgnoreRow) {
+        Mask &= ~WordRangeMask(w, Ignore.Min.X, Ignore.Max.X);
+      }
+      if (Row[w] & Mask) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
@@ -0,0 +1,451 @@
+#include "GridPathfinding.h"
+#include "GridManagerCounters.h"
+#include "GridManagerStats.h"
+#include "Misc/ScopeExit.h"
+#include "Algo/Reverse.h"
+
+// Past this many dirty cells re-reading the whole grid is as cheap
+static constexpr int32 MaxDirtyCells = 4096;
+
+const FIntPoint FGridPathfinder::NeighborOffsets[8] = {
+  {1, 0}, {-1, 0}, {0, 1}, {0, -1},
+  {1, 1}, {-1, -1}, {1, -1}, {-1, 1},
+};
+
+bool FGridFlowField::GetNextCell(const FIntPoint& Cell, FIntPoint& OutNextCell) const {
+  const uint8 Direction = Directions[Cell.Y * Width + Cell.X];
+  if (Direction == NoDirection) {
+    return false;
+  }
+  OutNextCell = Cell + FGridPathfinder::NeighborOffsets[Direction];
+  return true;
+}
+
+void FGridPathfinder::Init(int32 InWidth, int32 InHeight) {
+  Width = FMath::Max(0, InWidth);
+  Height = FMath::Max(0, InHeight);
+  Blocked.Init(Width, Height);
+  FlowFields.Empty();
+  OpenNodes.Empty();
+  Costs.Empty();
+  Parents.Empty();
+  SearchStamps.Empty();
+  SearchStamp = 0;
+  MarkAllDirty();
+}
+
+void FGridPathfinder::Empty() {
+  Width = 0;
+  Height = 0;
+  Blocked.Empty();
+  DirtyCells.Empty();
+  bAllDirty = true;
+  FlowFields.Empty();
+  OpenNodes.Empty();
+  Costs.Empty();
+  Parents.Empty();
+  SearchStamps.Empty();
+  SearchStamp = 0;
+}
+
+void FGridPathfinder::MarkDirty(int32 X, int32 Y) {
+  if (bAllDirty) {
+    return;
+  }
+  if (DirtyCells.Num() >= MaxDirtyCells) {
+    MarkAllDirty();
+    return;
+  }
+  DirtyCells.Add(Y * Width + X);
+}
+
+SIZE_T FGridPathfinder::GetAllocatedSize() const {
+  SIZE_T Size = Blocked.GetAllocatedSize() + DirtyCells.GetAllocatedSize() + FlowFields.GetAllocatedSize();
+  for (const FGridFlowField& Field : FlowFields) {
+    Size += Field.Costs.GetAllocatedSize() + Field.Directions.GetAllocatedSize();
+  }
+  Size += OpenNodes.GetAllocatedSize() + Costs.GetAllocatedSize() + Parents.GetAllocatedSize() + SearchStamps.GetAllocatedSize();
+  return Size;
+}
+
+///////// Searches /////////
+
+void FGridPathfinder::BeginSearch() {
+  const int32 NumCells = Width * Height;
+  if (SearchStamps.Num() != NumCells) {
+    Costs.SetNumUninitialized(NumCells);
+    Parents.SetNumUninitialized(NumCells);
+    SearchStamps.Init(0, NumCells);
+    SearchStamp = 0;
+  }
+  // stamps wrapped around, the old ones could look current again
+  if (++SearchStamp == 0) {
+    FMemory::Memzero(SearchStamps.GetData(), SearchStamps.Num() * sizeof(uint32));
+    SearchStamp = 1;
+  }
+  OpenNodes.Reset();
+}
+
+bool FGridPathfinder::Relax(int32 Index, uint32 Cost, int32 Parent) {
+  if (IsVisited(Index) && Costs[Index] <= Cost) {
+    return false;
+  }
+  SearchStamps[Index] = SearchStamp;
+  Costs[Index] = Cost;
+  Parents[Index] = Parent;
+  return true;
+}
+
+// Lowest estimate first, and among those the one closest to the goal
+static bool OpenNodeLess(uint32 EstimateA, uint32 CostA, uint32 EstimateB, uint32 CostB) {
+  return EstimateA != EstimateB ? EstimateA < EstimateB : CostA > CostB;
+}
+
+bool FGridPathfinder::FindPath(const FIntPoint& Start, const FIntPoint& Goal, EGridPathAlgorithm Algorithm, TArray<FIntPoint>& OutPath) {
+  OutPath.Reset();
+  GRID_COUNTER_INC(PathQueries);
+  if (Start.X < 0 || Start.X >= Width || Start.Y < 0 || Start.Y >= Height) {
+    return false;
+  }
+  if (!IsWalkable(Goal.X, Goal.Y)) {
+    return false;
+  }
+  if (Start == Goal) {
+    OutPath.Add(Start);
+    return true;
+  }
+
+  switch (Algorithm) {
+  case EGridPathAlgorithm::JumpPoint:
+    return FindPathJumpPoint(Start, Goal, OutPath);
+  case EGridPathAlgorithm::AStar:
+  default:
+    return FindPathAStar(Start, Goal, OutPath);
+  }
+}
+
+bool FGridPathfinder::FindPathAStar(const FIntPoint& Start, const FIntPoint& Goal, TArray<FIntPoint>& OutPath) {
+  auto Less = [](const FOpenNode& A, const FOpenNode& B) { return OpenNodeLess(A.Estimate, A.Cost, B.Estimate, B.Cost); };
+
+  BeginSearch();
+  const int32 StartIndex = Start.Y * Width + Start.X;
+  const int32 GoalIndex = Goal.Y * Width + Goal.X;
+  Relax(StartIndex, 0, INDEX_NONE);
+  OpenNodes.HeapPush({OctileDistance(Start, Goal), 0, StartIndex}, Less);
+  int32 NumExpanded = 0;
+  ON_SCOPE_EXIT { INC_DWORD_STAT_BY(STAT_GridCellsVisited, NumExpanded); };
+
+  while (OpenNodes.Num() > 0) {
+    FOpenNode Node;
+    OpenNodes.HeapPop(Node, Less, EAllowShrinking::No);
+    ++NumExpanded;
+    // a cheaper way to the cell was found after this node was queued
+    if (Node.Cost > Costs[Node.Index]) {
+      continue;
+    }
+    if (Node.Index == GoalIndex) {
+      BuildPath(GoalIndex, OutPath);
+      return true;
+    }
+
+    const int32 X = Node.Index % Width;
+    const int32 Y = Node.Index / Width;
+    for (int32 Direction = 0; Direction < 8; ++Direction) {
+      const FIntPoint& Offset = NeighborOffsets[Direction];
+      if (!CanStep(X, Y, Offset.X, Offset.Y)) {
+        continue;
+      }
+      const FIntPoint Next(X + Offset.X, Y + Offset.Y);
+      const int32 NextIndex = Next.Y * Width + Next.X;
+      const uint32 NextCost = Node.Cost + (Direction < 4 ? StraightCost : DiagonalCost);
+      if (Relax(NextIndex, NextCost, Node.Index)) {
+        OpenNodes.HeapPush({NextCost + OctileDistance(Next, Goal), NextCost, NextIndex}, Less);
+      }
+    }
+  }
+  return false;
+}
+
+// Jump point search, in the variant where diagonal steps may not cut corners:
+// a straight run stops where an obstacle beside it ends (the cell beyond it
+// can only be reached optimally through here), a diagonal run stops where
+// one of its straight runs finds a jump point. Diagonal runs have no forced
+// neighbors of their own, a corner they could cut is not walkable.
+
+bool FGridPathfinder::JumpStraight(int32 X, int32 Y, int32 DX, int32 DY, const FIntPoint& Goal, FIntPoint& OutJumpPoint) const {
+  while (IsWalkable(X, Y)) {
+    if (X == Goal.X && Y == Goal.Y) {
+      OutJumpPoint = Goal;
+      return true;
+    }
+    bool bForced;
+    if (DX != 0) {
+      bForced = (IsWalkable(X, Y - 1) && !IsWalkable(X - DX, Y - 1)) || (IsWalkable(X, Y + 1) && !IsWalkable(X - DX, Y + 1));
+    } else {
+      bForced = (IsWalkable(X - 1, Y) && !IsWalkable(X - 1, Y - DY)) || (IsWalkable(X + 1, Y) && !IsWalkable(X + 1, Y - DY));
+    }
+    if (bForced) {
+      OutJumpPoint = FIntPoint(X, Y);
+      return true;
+    }
+    X += DX;
+    Y += DY;
+  }
+  return false;
+}
+
+bool FGridPathfinder::Jump(int32 X, int32 Y, int32 DX, int32 DY, const FIntPoint& Goal, FIntPoint& OutJumpPoint) const {
+  if (DX == 0 || DY == 0) {
+    return JumpStraight(X, Y, DX, DY, Goal, OutJumpPoint);
+  }
+  while (IsWalkable(X, Y)) {
+    if (X == Goal.X && Y == Goal.Y) {
+      OutJumpPoint = Goal;
+      return true;
+    }
+    FIntPoint Unused;
+    if (JumpStraight(X + DX, Y, DX, 0, Goal, Unused) || JumpStraight(X, Y + DY, 0, DY, Goal, Unused)) {
+      OutJumpPoint = FIntPoint(X, Y);
+      return true;
+    }
+    // the next diagonal step would cut a corner
+    if (!IsWalkable(X + DX, Y) || !IsWalkable(X, Y + DY)) {
+      return false;
+    }
+    X += DX;
+    Y += DY;
+  }
+  return false;
+}
+
+bool FGridPathfinder::FindPathJumpPoint(const FIntPoint& Start, const FIntPoint& Goal, TArray<FIntPoint>& OutPath) {
+  auto Less = [](const FOpenNode& A, const FOpenNode& B) { return OpenNodeLess(A.Estimate, A.Cost, B.Estimate, B.Cost); };
+
+  BeginSearch();
+  const int32 StartIndex = Start.Y * Width + Start.X;
+  const int32 GoalIndex = Goal.Y * Width + Goal.X;
+  Relax(StartIndex, 0, INDEX_NONE);
+  OpenNodes.HeapPush({OctileDistance(Start, Goal), 0, StartIndex}, Less);
+  // only the jump points are counted, not the cells the jumps scan
+  int32 NumExpanded = 0;
+  ON_SCOPE_EXIT { INC_DWORD_STAT_BY(STAT_GridCellsVisited, NumExpanded); };
+
+  // directions to jump in from the current node
+  FIntPoint Directions[8];
+  while (OpenNodes.Num() > 0) {
+    FOpenNode Node;
+    OpenNodes.HeapPop(Node, Less, EAllowShrinking::No);
+    ++NumExpanded;
+    if (Node.Cost > Costs[Node.Index]) {
+      continue;
+    }
+    if (Node.Index == GoalIndex) {
+      BuildPath(GoalIndex, OutPath);
+      return true;
+    }
+
+    const FIntPoint Cell(Node.Index % Width, Node.Index / Width);
+    const int32 X = Cell.X;
+    const int32 Y = Cell.Y;
+    int32 NumDirections = 0;
+    const int32 Parent = Parents[Node.Index];
+    if (Parent == INDEX_NONE) {
+      // the start: every way out
+      for (const FIntPoint& Offset : NeighborOffsets) {
+        if (CanStep(X, Y, Offset.X, Offset.Y)) {
+          Directions[NumDirections++] = Offset;
+        }
+      }
+    } else {
+      // prune the neighbors reached at least as cheaply without this node
+      const int32 DX = FMath::Sign(X - Parent % Width);
+      const int32 DY = FMath::Sign(Y - Parent / Width);
+      if (DX != 0 && DY != 0) {
+        const bool bVertical = IsWalkable(X, Y + DY);
+        const bool bHorizontal = IsWalkable(X + DX, Y);
+        if (bVertical) {
+          Directions[NumDirections++] = FIntPoint(0, DY);
+        }
+        if (bHorizontal) {
+          Directions[NumDirections++] = FIntPoint(DX, 0);
+        }
+        if (bVertical && bHorizontal && IsWalkable(X + DX, Y + DY)) {
+          Directions[NumDirections++] = FIntPoint(DX, DY);
+        }
+      } else if (DX != 0) {
+        const bool bAhead = IsWalkable(X + DX, Y);
+        const bool bAbove = IsWalkable(X, Y + 1);
+        const bool bBelow = IsWalkable(X, Y - 1);
+        if (bAhead) {
+          Directions[NumDirections++] = FIntPoint(DX, 0);
+          if (bAbove && IsWalkable(X + DX, Y + 1)) {
+            Directions[NumDirections++] = FIntPoint(DX, 1);
+          }
+          if (bBelow && IsWalkable(X + DX, Y - 1)) {
+            Directions[NumDirections++] = FIntPoint(DX, -1);
+          }
+        }
+        if (bAbove) {
+          Directions[NumDirections++] = FIntPoint(0, 1);
+        }
+        if (bBelow) {
+          Directions[NumDirections++] = FIntPoint(0, -1);
+        }
+      } else {
+        const bool bAhead = IsWalkable(X, Y + DY);
+        const bool bRight = IsWalkable(X + 1, Y);
+        const bool bLeft = IsWalkable(X - 1, Y);
+        if (bAhead) {
+          Directions[NumDirections++] = FIntPoint(0, DY);
+          if (bRight && IsWalkable(X + 1, Y + DY)) {
+            Directions[NumDirections++] = FIntPoint(1, DY);
+          }
+          if (bLeft && IsWalkable(X - 1, Y + DY)) {
+            Directions[NumDirections++] = FIntPoint(-1, DY);
+          }
+        }
+        if (bRight) {
+          Directions[NumDirections++] = FIntPoint(1, 0);
+        }
+        if (bLeft) {
+          Directions[NumDirections++] = FIntPoint(-1, 0);
+        }
+      }
+    }
+
+    for (int32 i = 0; i < NumDirections; ++i) {
+      FIntPoint JumpPoint;
+      if (!Jump(X + Directions[i].X, Y + Directions[i].Y, Directions[i].X, Directions[i].Y, Goal, JumpPoint)) {
+        continue;
+      }
+      const int32 JumpIndex = JumpPoint.Y * Width + JumpPoint.X;
+      const uint32 JumpCost = Node.Cost + OctileDistance(Cell, JumpPoint);
+      if (Relax(JumpIndex, JumpCost, Node.Index)) {
+        OpenNodes.HeapPush({JumpCost + OctileDistance(JumpPoint, Goal), JumpCost, JumpIndex}, Less);
+      }
+    }
+  }
+  return false;
+}
+
+void FGridPathfinder::BuildPath(int32 GoalIndex, TArray<FIntPoint>& OutPath) const {
+  OutPath.Reset();
+  int32 Index = GoalIndex;
+  FIntPoint Cell(Index % Width, Index / Width);
+  OutPath.Add(Cell);
+  while (Parents[Index] != INDEX_NONE) {
+    const int32 ParentIndex = Parents[Index];
+    const FIntPoint ParentCell(ParentIndex % Width, ParentIndex / Width);
+    // A* parents are adjacent, jump points are a straight or diagonal run apart
+    const FIntPoint Step(FMath::Sign(ParentCell.X - Cell.X), FMath::Sign(ParentCell.Y - Cell.Y));
+    while (Cell != ParentCell) {
+      Cell += Step;
+      OutPath.Add(Cell);
+    }
+    Index = ParentIndex;
+  }
+  Algo::Reverse(OutPath);
+}
+
+///////// Flow Fields /////////
+
+const FGridFlowField* FGridPathfinder::GetFlowField(const FIntPoint& Target) {
+  if (!IsWalkable(Target.X, Target.Y)) {
+    return nullptr;
+  }
+
+  FGridFlowField* Field = FlowFields.FindByPredicate([&Target](const FGridFlowField& Existing) { return Existing.Target == Target; });
+  if (Field == nullptr) {
+    if (FlowFields.Num() < MaxFlowFields) {
+      Field = &FlowFields.AddDefaulted_GetRef();
+    } else {
+      Field = &FlowFields[0];
+      for (FGridFlowField& Existing : FlowFields) {
+        if (Existing.LastUsed < Field->LastUsed) {
+          Field = &Existing;
+        }
+      }
+    }
+    Field->Target = Target;
+    Field->bStale = true;
+  }
+
+  Field->LastUsed = ++FlowFieldUseCount;
+  if (Field->bStale) {
+    ComputeFlowField(*Field);
+  }
+  return Field;
+}
+
+void FGridPathfinder::ComputeFlowField(FGridFlowField& Field) const {
+  // Dijkstra outwards from the target. Steps are symmetric, so the cheapest
+  // way back to the target is the reverse of the step that reached a cell.
+  GRID_COUNTER_INC(FlowFieldBuilds);
+  const int32 NumCells = Width * Height;
+  Field.Width = Width;
+  Field.Costs.Init(FGridFlowField::Unreachable, NumCells);
+  Field.Directions.Init(FGridFlowField::NoDirection, NumCells);
+  Field.bStale = false;
+
+  struct FQueued
+  {
+    uint32 Cost;
+    int32 Index;
+  };
+  auto Less = [](const FQueued& A, const FQueued& B) { return A.Cost < B.Cost; };
+  TArray<FQueued> Queue;
+  const int32 TargetIndex = Field.Target.Y * Width + Field.Target.X;
+  Field.Costs[TargetIndex] = 0;
+  Queue.HeapPush({0, TargetIndex}, Less);
+  int32 NumExpanded = 0;
+
+  while (Queue.Num() > 0) {
+    FQueued Node;
+    Queue.HeapPop(Node, Less, EAllowShrinking::No);
+    if (Node.Cost > Field.Costs[Node.Index]) {
+      continue;
+    }
+    ++NumExpanded;
+    const int32 X = Node.Index % Width;
+    const int32 Y = Node.Index / Width;
+    for (int32 Direction = 0; Direction < 8; ++Direction) {
+      const FIntPoint& Offset = NeighborOffsets[Direction];
+      if (!CanStep(X, Y, Offset.X, Offset.Y)) {
+        continue;
+      }
+      const int32 NextIndex = (Y + Offset.Y) * Width + X + Offset.X;
+      const uint32 NextCost = Node.Cost + (Direction < 4 ? StraightCost : DiagonalCost);
+      if (NextCost < Field.Costs[NextIndex]) {
+        Field.Costs[NextIndex] = NextCost;
+        // opposite directions are next to each other in NeighborOffsets
+        Field.Directions[NextIndex] = uint8(Direction ^ 1);
+        Queue.HeapPush({NextCost, NextIndex}, Less);
+      }
+    }
+  }
+  INC_DWORD_STAT_BY(STAT_GridCellsVisited, NumExpanded);
+}
+
+bool FGridPathfinder::AffectsFlowField(const FGridFlowField& Field, int32 X, int32 Y, bool bNowBlocked) const {
+  if (bNowBlocked) {
+    // a wall where no path went changes nothing
+    return Field.Costs[Y * Width + X] != FGridFlowField::Unreachable;
+  }
+  // a newly open cell only matters if a path can get to it
+  for (const FIntPoint& Offset : NeighborOffsets) {
+    const int32 NX = X + Offset.X;
+    const int32 NY = Y + Offset.Y;
+    if (NX >= 0 && NX < Width && NY >= 0 && NY < Height && Field.Costs[NY * Width + NX] != FGridFlowField::Unreachable) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void FGridPathfinder::OnCellChanged(int32 X, int32 Y, bool bNowBlocked) {
+  for (FGridFlowField& Field : FlowFields) {
+    if (!Field.bStale && AffectsFlowField(Field, X, Y, bNowBlocked)) {
+      Field.bStale = true;
+    }
+  }
+}
@@ -0,0 +1,76 @@
+#include "GridQuerySnapshot.h"
+
+// Offsets of the neighbors, in the order AGrid::ForEachPerimeterCell visits
+// them: the row above, the row below, then the left and right cells
+static const FIntPoint NeighborOffsets[] = {
+  {-1, -1}, {0, -1}, {1, -1},
+  {-1, 1}, {0, 1}, {1, 1},
+  {-1, 0}, {1, 0},
+};
+
+EGridCellType FGridQuerySnapshot::GetCellType(int32 X, int32 Y) const {
+  if (!IsCellValid(X, Y)) {
+    return EGridCellType::Unusable;
+  }
+
+  return (*CellTypes)[Y * Width + X];
+}
+
+bool FGridQuerySnapshot::CheckIfCellsAreFree(const FVector2D& GridPosition, const FVector2D& ItemSize) const {
+  int32 X = GridPosition.X;
+  int32 Y = GridPosition.Y;
+  if (!IsCellValid(X, Y)) {
+    return false;
+  }
+
+  // the origin cell is always checked, even for an item with no size
+  int32 ItemWidth = FMath::Max(1, int32(ItemSize.X));
+  int32 ItemHeight = FMath::Max(1, int32(ItemSize.Y));
+  if (!IsCellValid(X + ItemWidth - 1, Y + ItemHeight - 1)) {
+    return false;
+  }
+
+  return Occupancy->IsRectFree(X, Y, ItemWidth, ItemHeight);
+}
+
+FVector FGridQuerySnapshot::GridToWorld(const FVector2D& GridPosition) const {
+  FVector WorldPosition = FVector(GridPosition.X * CellSize, GridPosition.Y * CellSize, 0);
+  return GridRotation.RotateVector(WorldPosition) + GridLocation;
+}
+
+FVector2D FGridQuerySnapshot::WorldToGrid(const FVector& WorldPosition) const {
+  FVector RelativePosition = WorldToLocal.TransformPosition(WorldPosition);
+
+  // above or below the grid
+  if (RelativePosition.Z > CellSize || RelativePosition.Z < 0) {
+    return FVector2D(-1, -1);
+  }
+
+  return FVector2D(FMath::RoundToInt(RelativePosition.X / CellSize), FMath::RoundToInt(RelativePosition.Y / CellSize));
+}
+
+int32 FGridQuerySnapshot::GetNeighborCellIndices(const FIntPoint& Cell, TArrayView<int32> OutIndices, bool IncludeOccupied) const {
+  int32 Num = 0;
+  for (const FIntPoint& Offset : NeighborOffsets) {
+    const FIntPoint Neighbor = Cell + Offset;
+    if (Num < OutIndices.Num() && IsCellValid(Neighbor.X, Neighbor.Y) && (IncludeOccupied || !IsCellOccupied(Neighbor))) {
+      OutIndices[Num++] = Neighbor.Y * Width + Neighbor.X;
+    }
+  }
+  return Num;
+}
+
+int32 FGridQuerySnapshot::GetNeighborCells(const FIntPoint& Cell, TArrayView<FIntPoint> OutCells, bool IncludeOccupied) const {
+  int32 Num = 0;
+  for (const FIntPoint& Offset : NeighborOffsets) {
+    const FIntPoint Neighbor = Cell + Offset;
+    if (Num < OutCells.Num() && IsCellValid(Neighbor.X, Neighbor.Y) && (IncludeOccupied || !IsCellOccupied(Neighbor))) {
+      OutCells[Num++] = Neighbor;
+    }
+  }
+  return Num;
+}
+
+SIZE_T FGridQuerySnapshot::GetAllocatedSize() const {
+  return (Occupancy ? Occupancy->GetAllocatedSize() : 0) + (CellTypes ? CellTypes->GetAllocatedSize() : 0);
+}
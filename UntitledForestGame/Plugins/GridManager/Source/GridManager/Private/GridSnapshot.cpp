@@ -0,0 +1,92 @@
+#include "GridSnapshot.h"
+
+// Every cell type fits in the 2 bits a cell gets
+static_assert(uint8(EGridCellType::Unusable) < 4, "EGridCellType no longer fits in 2 bits");
+
+void FGridSnapshot::InitCells() {
+  const int32 NumCells = this->NumCells();
+  // 4 cells of the default type per byte
+  const uint8 DefaultBits = uint8(DefaultType) & 3;
+  PackedTypes.Init(uint8(DefaultBits | (DefaultBits << 2) | (DefaultBits << 4) | (DefaultBits << 6)), (NumCells + 3) / 4);
+  OccupancyRuns.Reset();
+  if (NumCells > 0) {
+    OccupancyRuns.Add(INDEX_NONE);
+    OccupancyRuns.Add(NumCells);
+  }
+}
+
+void FGridSnapshot::SetOccupancy(TConstArrayView<int32> CellItems) {
+  OccupancyRuns.Reset();
+  int32 RunStart = 0;
+  for (int32 Cell = 1; Cell <= CellItems.Num(); ++Cell) {
+    if (Cell == CellItems.Num() || CellItems[Cell] != CellItems[RunStart]) {
+      OccupancyRuns.Add(CellItems[RunStart]);
+      OccupancyRuns.Add(Cell - RunStart);
+      RunStart = Cell;
+    }
+  }
+}
+
+bool FGridSnapshot::Serialize(FArchive& Ar) {
+  uint32 FileMagic = Magic;
+  uint32 FileVersion = Version;
+  Ar << FileMagic;
+  Ar << FileVersion;
+  if (FileMagic != Magic || FileVersion != Version) {
+    Ar.SetError();
+    return false;
+  }
+
+  uint8 DefaultTypeValue = uint8(DefaultType);
+  Ar << Width;
+  Ar << Height;
+  Ar << CellSize;
+  Ar << DefaultTypeValue;
+  DefaultType = EGridCellType(DefaultTypeValue);
+  if (Width < 0 || Height < 0 || int64(Width) * Height > MAX_int32) {
+    Ar.SetError();
+    return false;
+  }
+
+  // the columns are read and written in one go each
+  PackedTypes.BulkSerialize(Ar);
+  WaterLevels.BulkSerialize(Ar);
+  SoilQualities.BulkSerialize(Ar);
+
+  Ar << ItemClasses;
+  int32 NumItems = Items.Num();
+  Ar << NumItems;
+  if (Ar.IsLoading()) {
+    if (NumItems < 0 || NumItems > NumCells()) {
+      Ar.SetError();
+      return false;
+    }
+    Items.SetNum(NumItems);
+  }
+  for (FGridSnapshotItem& Item : Items) {
+    Ar << Item.ClassIndex;
+    Ar << Item.Position;
+    Ar << Item.Rotation;
+  }
+
+  OccupancyRuns.BulkSerialize(Ar);
+
+  if (Ar.IsLoading()) {
+    // check everything a restore relies on, so that it doesn't have to
+    bool bValid = !Ar.IsError() && PackedTypes.Num() == (NumCells() + 3) / 4 && (OccupancyRuns.Num() % 2) == 0;
+    bValid = bValid && (WaterLevels.Num() == 0 || WaterLevels.Num() == NumCells()) && SoilQualities.Num() == WaterLevels.Num();
+    for (int32 i = 0; bValid && i < Items.Num(); ++i) {
+      bValid = ItemClasses.IsValidIndex(Items[i].ClassIndex);
+    }
+    int64 CoveredCells = 0;
+    for (int32 i = 0; bValid && i < OccupancyRuns.Num(); i += 2) {
+      bValid = (OccupancyRuns[i] == INDEX_NONE || Items.IsValidIndex(OccupancyRuns[i])) && OccupancyRuns[i + 1] > 0;
+      CoveredCells += OccupancyRuns[i + 1];
+    }
+    if (!bValid || CoveredCells != NumCells()) {
+      Ar.SetError();
+      return false;
+    }
+  }
+  return !Ar.IsError();
+}
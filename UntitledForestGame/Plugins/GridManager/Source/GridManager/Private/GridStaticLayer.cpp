@@ -0,0 +1,121 @@
+#include "GridStaticLayer.h"
+#include "GridManager.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+
+// Columns start on a 16 byte boundary
+static int64 AlignColumn(int64 Offset) {
+  return Align(Offset, 16);
+}
+
+FGridStaticLayer::FGridStaticLayer() = default;
+
+FGridStaticLayer::~FGridStaticLayer() {
+  Unmap();
+}
+
+bool FGridStaticLayer::Map(const FString& InFilename) {
+  Unmap();
+
+  const double StartTime = FPlatformTime::Seconds();
+  IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+  MappedFile.Reset(PlatformFile.OpenMapped(*InFilename));
+  if (MappedFile) {
+    MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+  }
+
+  const uint8* FileData = nullptr;
+  int64 FileSize = 0;
+  if (MappedRegion) {
+    FileData = MappedRegion->GetMappedPtr();
+    FileSize = MappedRegion->GetMappedSize();
+  } else {
+    // e.g. the file is inside a pak file
+    MappedFile.Reset();
+    if (!FFileHelper::LoadFileToArray(LoadedData, *InFilename, FILEREAD_Silent)) {
+      return false;
+    }
+    FileData = LoadedData.GetData();
+    FileSize = LoadedData.Num();
+  }
+
+  if (!BindColumns(FileData, FileSize)) {
+    UE_LOG(LogGridManager, Warning, TEXT("%s is not a valid grid static layer"), *InFilename);
+    Unmap();
+    return false;
+  }
+  Filename = InFilename;
+  UE_LOG(LogGridManager, Log, TEXT("%s static layer %s (%dx%d) in %.2f ms"), MappedRegion ? TEXT("Mapped") : TEXT("Loaded"), *Filename, Width,
+    Height, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+  return true;
+}
+
+void FGridStaticLayer::Unmap() {
+  Data = nullptr;
+  GroundTypes = nullptr;
+  UnusableBits = nullptr;
+  BaseSoilQualities = nullptr;
+  Width = 0;
+  Height = 0;
+  Filename.Reset();
+  // the region has to go before the file
+  MappedRegion.Reset();
+  MappedFile.Reset();
+  LoadedData.Empty();
+}
+
+bool FGridStaticLayer::BindColumns(const uint8* FileData, int64 FileSize) {
+  if (FileData == nullptr || FileSize < int64(sizeof(FHeader))) {
+    return false;
+  }
+  FHeader Header;
+  FMemory::Memcpy(&Header, FileData, sizeof(FHeader));
+  if (Header.Magic != Magic || Header.Version != Version || Header.Width <= 0 || Header.Height <= 0
+    || int64(Header.Width) * Header.Height > MAX_int32) {
+    return false;
+  }
+
+  const int64 NumCells = int64(Header.Width) * Header.Height;
+  auto ColumnFits = [FileSize](uint64 Offset, int64 Size, int64 Alignment) {
+    return Offset % Alignment == 0 && Offset <= uint64(FileSize) && uint64(Size) <= uint64(FileSize) - Offset;
+  };
+  if (!ColumnFits(Header.GroundTypesOffset, NumCells, 1) || !ColumnFits(Header.UnusableOffset, (NumCells + 7) / 8, 1)
+    || !ColumnFits(Header.BaseSoilOffset, NumCells * sizeof(float), alignof(float))) {
+    return false;
+  }
+
+  Width = Header.Width;
+  Height = Header.Height;
+  Data = FileData;
+  GroundTypes = FileData + Header.GroundTypesOffset;
+  UnusableBits = FileData + Header.UnusableOffset;
+  BaseSoilQualities = reinterpret_cast<const float*>(FileData + Header.BaseSoilOffset);
+  return true;
+}
+
+bool FGridStaticLayer::Write(const FString& Filename, int32 Width, int32 Height, TConstArrayView<uint8> GroundTypes, TConstArrayView<uint8> UnusableCells,
+  TConstArrayView<float> BaseSoilQualities) {
+  const int64 NumCells = int64(Width) * Height;
+  if (Width <= 0 || Height <= 0 || NumCells > MAX_int32 || GroundTypes.Num() != NumCells || UnusableCells.Num() != (NumCells + 7) / 8
+    || BaseSoilQualities.Num() != NumCells) {
+    return false;
+  }
+
+  FHeader Header;
+  Header.Magic = Magic;
+  Header.Version = Version;
+  Header.Width = Width;
+  Header.Height = Height;
+  Header.GroundTypesOffset = AlignColumn(sizeof(FHeader));
+  Header.UnusableOffset = AlignColumn(Header.GroundTypesOffset + NumCells);
+  Header.BaseSoilOffset = AlignColumn(Header.UnusableOffset + UnusableCells.Num());
+
+  TArray64<uint8> FileData;
+  FileData.SetNumZeroed(Header.BaseSoilOffset + NumCells * sizeof(float));
+  FMemory::Memcpy(FileData.GetData(), &Header, sizeof(FHeader));
+  FMemory::Memcpy(FileData.GetData() + Header.GroundTypesOffset, GroundTypes.GetData(), NumCells);
+  FMemory::Memcpy(FileData.GetData() + Header.UnusableOffset, UnusableCells.GetData(), UnusableCells.Num());
+  FMemory::Memcpy(FileData.GetData() + Header.BaseSoilOffset, BaseSoilQualities.GetData(), NumCells * sizeof(float));
+  return FFileHelper::SaveArrayToFile(FileData, *Filename);
+}
@@ -0,0 +1,23 @@
+#include "GridSummedAreaTable.h"
+
+void FGridSummedAreaTable::Init(int32 InWidth, int32 InHeight) {
+  Width = FMath::Max(0, InWidth);
+  Height = FMath::Max(0, InHeight);
+
+  // allocated by the first Update, grids that are never searched don't pay
+  // for the table
+  Sums.Empty();
+  MarkAllDirty();
+}
+
+void FGridSummedAreaTable::Empty() {
+  Width = 0;
+  Height = 0;
+  DirtyMin = FIntPoint(MAX_int32, MAX_int32);
+  Sums.Empty();
+}
+
+void FGridSummedAreaTable::MarkDirty(int32 X, int32 Y) {
+  DirtyMin.X = FMath::Min(DirtyMin.X, X);
+  DirtyMin.Y = FMath::Min(DirtyMin.Y, Y);
+}
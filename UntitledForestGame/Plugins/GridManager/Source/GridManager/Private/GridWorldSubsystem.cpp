@@ -0,0 +1,170 @@
+#include "GridWorldSubsystem.h"
+#include "Grid.h"
+#include "GridManagerStats.h"
+#include "EngineUtils.h"
+
+void UGridWorldSubsystem::PostInitialize() {
+  Super::PostInitialize();
+
+  // grids registered before the subsystem existed
+  for (TActorIterator<AGrid> It(GetWorld()); It; ++It) {
+    UpdateGrid(*It);
+  }
+}
+
+void UGridWorldSubsystem::Deinitialize() {
+  Entries.Empty();
+  EntryIndices.Empty();
+  Buckets.Empty();
+  LargeEntries.Empty();
+
+  Super::Deinitialize();
+}
+
+void UGridWorldSubsystem::UpdateGrid(AGrid* Grid) {
+  if (Grid == nullptr || Grid->GetWorld() != GetWorld()) {
+    return;
+  }
+
+  int32 EntryIndex;
+  if (const int32* Found = EntryIndices.Find(Grid)) {
+    EntryIndex = *Found;
+    RemoveFromBuckets(EntryIndex);
+  } else {
+    EntryIndex = Entries.Add(FIndexedGrid());
+    EntryIndices.Add(Grid, EntryIndex);
+  }
+
+  FIndexedGrid& Entry = Entries[EntryIndex];
+  Entry.Grid = Grid;
+  Entry.WorldToCell = Grid->GetWorldToCellMatrix();
+  Entry.Width = Grid->GridWidth;
+  Entry.Height = Grid->GridHeight;
+
+  // world bounds of the box of cells: half a cell around the cell centers,
+  // one cell up from the plane
+  const FMatrix CellToWorld = Entry.WorldToCell.Inverse();
+  FBox WorldBounds(ForceInit);
+  for (int32 Corner = 0; Corner < 8; ++Corner) {
+    FVector LocalCorner((Corner & 1) ? Entry.Width - 0.5 : -0.5, (Corner & 2) ? Entry.Height - 0.5 : -0.5, (Corner & 4) ? 1.0 : 0.0);
+    WorldBounds += CellToWorld.TransformPosition(LocalCorner);
+  }
+  Entry.Buckets = FIntRect(GetBucket(WorldBounds.Min), GetBucket(WorldBounds.Max));
+  const int64 NumBuckets = int64(Entry.Buckets.Width() + 1) * (Entry.Buckets.Height() + 1);
+  Entry.bLarge = NumBuckets > MaxBucketsPerGrid;
+
+  AddToBuckets(EntryIndex);
+}
+
+void UGridWorldSubsystem::RemoveGrid(const AGrid* Grid) {
+  int32 EntryIndex;
+  if (!EntryIndices.RemoveAndCopyValue(Grid, EntryIndex)) {
+    return;
+  }
+  RemoveFromBuckets(EntryIndex);
+  Entries.RemoveAt(EntryIndex);
+}
+
+void UGridWorldSubsystem::AddToBuckets(int32 EntryIndex) {
+  const FIndexedGrid& Entry = Entries[EntryIndex];
+  if (Entry.bLarge) {
+    LargeEntries.Add(EntryIndex);
+    return;
+  }
+  for (int32 Y = Entry.Buckets.Min.Y; Y <= Entry.Buckets.Max.Y; ++Y) {
+    for (int32 X = Entry.Buckets.Min.X; X <= Entry.Buckets.Max.X; ++X) {
+      Buckets.FindOrAdd(FIntPoint(X, Y)).Add(EntryIndex);
+    }
+  }
+}
+
+void UGridWorldSubsystem::RemoveFromBuckets(int32 EntryIndex) {
+  const FIndexedGrid& Entry = Entries[EntryIndex];
+  if (Entry.bLarge) {
+    LargeEntries.RemoveSingleSwap(EntryIndex, EAllowShrinking::No);
+    return;
+  }
+  for (int32 Y = Entry.Buckets.Min.Y; Y <= Entry.Buckets.Max.Y; ++Y) {
+    for (int32 X = Entry.Buckets.Min.X; X <= Entry.Buckets.Max.X; ++X) {
+      const FIntPoint Bucket(X, Y);
+      TArray<int32>* BucketEntries = Buckets.Find(Bucket);
+      if (BucketEntries == nullptr) {
+        continue;
+      }
+      BucketEntries->RemoveSingleSwap(EntryIndex, EAllowShrinking::No);
+      if (BucketEntries->Num() == 0) {
+        Buckets.Remove(Bucket);
+      }
+    }
+  }
+}
+
+bool UGridWorldSubsystem::ResolveInEntry(const FIndexedGrid& Entry, const FVector& WorldPosition, FIntPoint& OutCell, double& OutHeight) {
+  // same rules as AGrid::WorldToGrid, in cell units
+  const FVector CellPosition = Entry.WorldToCell.TransformPosition(WorldPosition);
+  if (CellPosition.Z > 1.0 || CellPosition.Z < 0.0) {
+    return false;
+  }
+  const int32 X = FMath::RoundToInt(CellPosition.X);
+  const int32 Y = FMath::RoundToInt(CellPosition.Y);
+  if (X < 0 || X >= Entry.Width || Y < 0 || Y >= Entry.Height) {
+    return false;
+  }
+  OutCell = FIntPoint(X, Y);
+  OutHeight = CellPosition.Z;
+  return true;
+}
+
+AGrid* UGridWorldSubsystem::FindGridAt(const FVector& WorldPosition, FIntPoint& OutCell) const {
+  GRID_SCOPE_CYCLE_COUNTER(STAT_GridWorldLookups);
+  const FIndexedGrid* Best = nullptr;
+  double BestHeight = TNumericLimits<double>::Max();
+  auto TestEntry = [&](int32 EntryIndex) {
+    const FIndexedGrid& Entry = Entries[EntryIndex];
+    FIntPoint Cell;
+    double Height;
+    if (ResolveInEntry(Entry, WorldPosition, Cell, Height) && Height < BestHeight && Entry.Grid.IsValid()) {
+      Best = &Entry;
+      BestHeight = Height;
+      OutCell = Cell;
+    }
+  };
+
+  if (const TArray<int32>* BucketEntries = Buckets.Find(GetBucket(WorldPosition))) {
+    for (int32 EntryIndex : *BucketEntries) {
+      TestEntry(EntryIndex);
+    }
+  }
+  for (int32 EntryIndex : LargeEntries) {
+    TestEntry(EntryIndex);
+  }
+  return Best ? Best->Grid.Get() : nullptr;
+}
+
+bool UGridWorldSubsystem::ResolveWorldPosition(const FVector& WorldPosition, AGrid*& OutGrid, FVector2D& OutGridPosition) const {
+  FIntPoint Cell;
+  OutGrid = FindGridAt(WorldPosition, Cell);
+  if (OutGrid == nullptr) {
+    OutGridPosition = FVector2D(-1, -1);
+    return false;
+  }
+  OutGridPosition = FVector2D(Cell);
+  return true;
+}
+
+UGridCell* UGridWorldSubsystem::GetCellAtWorldPosition(const FVector& WorldPosition) const {
+  FIntPoint Cell;
+  AGrid* Grid = FindGridAt(WorldPosition, Cell);
+  return Grid ? Grid->GetGridCellAtXY(Cell.X, Cell.Y) : nullptr;
+}
+
+TArray<AGrid*> UGridWorldSubsystem::GetGrids() const {
+  TArray<AGrid*> Grids;
+  Grids.Reserve(Entries.Num());
+  for (const FIndexedGrid& Entry : Entries) {
+    if (AGrid* Grid = Entry.Grid.Get()) {
+      Grids.Add(Grid);
+    }
+  }
+  return Grids;
+}
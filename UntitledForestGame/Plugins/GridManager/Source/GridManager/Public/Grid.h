@@ -2,9 +2,79 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "Components/LineBatchComponent.h"
+#include "HAL/CriticalSection.h"
+#include "GridAttributeField.h"
 #include "GridCell.h"
+#include "GridCellStore.h"
+#include "GridItemRegistry.h"
+#include "GridItemSleepIndex.h"
+#include "GridJournal.h"
+#include "GridOccupancyMask.h"
+#include "GridPathfinding.h"
+#include "GridQuerySnapshot.h"
+#include "GridSnapshot.h"
+#include "GridStaticLayer.h"
+#include "GridSummedAreaTable.h"
 #include "Grid.generated.h"
 
+// An item and where to put it on the grid, for AGrid::PlaceItems
+USTRUCT(BlueprintType)
+struct GRIDMANAGER_API FGridItemPlacement
+{
+    GENERATED_BODY()
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid")
+    AActor* Item{nullptr};
+
+    // Grid position of the item's origin cell, rounded up like
+    // PlaceItemAtGridPosition does
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid")
+    FVector2D GridPosition{FVector2D::ZeroVector};
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid")
+    float Rotation{0.0f};
+};
+
+// What the item update scheduler did, see AGrid::UpdateAllItems
+USTRUCT(BlueprintType)
+struct GRIDMANAGER_API FGridItemUpdateStats
+{
+    GENERATED_BODY()
+
+    // Items updated in the last call
+    UPROPERTY(BlueprintReadOnly, Category = "Grid")
+    int32 ItemsUpdated = 0;
+
+    // Time the last call took, in microseconds
+    UPROPERTY(BlueprintReadOnly, Category = "Grid")
+    float Microseconds = 0.0f;
+
+    // Calls which went over the budget
+    UPROPERTY(BlueprintReadOnly, Category = "Grid")
+    int32 Overruns = 0;
+
+    // Game time the last complete pass over all the items took, i.e. how
+    // stale an item's update can get
+    UPROPERTY(BlueprintReadOnly, Category = "Grid")
+    float LastPassDuration = 0.0f;
+};
+
+// Broadcast once per placement / removal operation with all the items it changed
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnGridItemsChanged, const TArray<AActor*>&, PlacedItems, const TArray<AActor*>&, RemovedItems);
+
+// Broadcast when an InitializeGridAsync build has been published
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnGridReady, AGrid*, Grid);
+
+// Broadcast after a resize which kept the cells, and after any other
+// (re)initialization which removed items, with the items removed because they
+// no longer fit
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnGridResized, AGrid*, Grid, const TArray<AActor*>&, EvictedItems);
+
+// The cells of a grid being built on a worker thread, see
+// AGrid::InitializeGridAsync
+struct FGridInitBuild;
+
 UCLASS(BlueprintType, Blueprintable)
 class GRIDMANAGER_API AGrid : public AActor
 {
@@ -20,8 +90,19 @@ public:
 
     // Called when a property is changed in the editor
     void PostEditChangeProperty(FPropertyChangedEvent& e);
+
+    // Called after undo / redo restored the cell storage
+    virtual void PostEditUndo() override;
 #endif
 
+    virtual void PostLoad() override;
+    virtual void PreSave(FObjectPreSaveContext SaveContext) override;
+    virtual void PostActorCreated() override;
+    virtual void PostRegisterAllComponents() override;
+    virtual void PostUnregisterAllComponents() override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+    virtual void OnConstruction(const FTransform& Transform) override;
+
     /** Tick that runs ONLY in the editor viewport.*/
     UFUNCTION(BlueprintImplementableEvent, CallInEditor, Category = "Events")
     void BlueprintEditorTick(float DeltaTime);
@@ -50,18 +131,129 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid Settings")
     TSubclassOf<UGridCell> GridCellClass = UGridCell::StaticClass();
 
-    // Grid cells
-    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Instanced)
-    TArray<UGridCell*> GridCells;
+    // How the cells are stored. Sparse grids only store the cells which differ
+    // from DefaultCellType, use it for large grids where few cells are used.
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Grid Settings")
+    EGridStorageMode StorageMode = EGridStorageMode::Chunked;
 
-    // List of all items managed by this grid
+    // Type of the cells of a freshly initialized grid
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Grid Settings")
+    EGridCellType DefaultCellType = EGridCellType::Ground;
+
+    // Cooked column file of the authored, read-only cell data (ground type,
+    // base soil quality, unusable cells), relative to the project directory.
+    // Mapped when the grid is loaded, see FGridStaticLayer.
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Grid Settings")
+    FString StaticLayerFile;
+
+    // Switch the cell storage mode, keeping the cells
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    void SetStorageMode(EGridStorageMode NewStorageMode);
+
+    //// Static layer ////
+
+    // Is the static layer file mapped
+    UFUNCTION(BlueprintCallable, Category = "Grid Static Layer")
+    bool HasStaticLayer() const { return StaticLayer.IsMapped(); }
+
+    // Authored ground type of the cell (row of the ground type table), 0
+    // without a static layer
+    UFUNCTION(BlueprintCallable, Category = "Grid Static Layer")
+    uint8 GetGroundType(int32 X, int32 Y) const;
+
+    // Cook the authored data into StaticLayerFile and map it: the ground type
+    // and base soil quality of every cell by cell index (empty for 0 / the
+    // simulation's initial soil quality), and the cells which are currently
+    // Unusable. The unusable cells then come from the static layer and are
+    // reset to the default type in the cell storage.
+    UFUNCTION(BlueprintCallable, Category = "Grid Static Layer")
+    bool CookStaticLayer(const TArray<uint8>& GroundTypes, const TArray<float>& BaseSoilQualities);
+
+    // Cell storage: type, occupant and attribute index of every cell, in
+    // lazily allocated chunks or a sparse table, indexed by GetGridCellIndex
+    UPROPERTY()
+    FGridCellStore CellStore;
+
+    // Cells of grids saved before the cell storage existed, moved into
+    // CellStore and CellAttributes when the grid is loaded
+    UPROPERTY(Instanced, meta = (DeprecatedProperty, DeprecationMessage = "Use GetGridCell / GetAllCells, the cells are now in CellStore"))
+    TArray<UGridCell*> GridCells_DEPRECATED;
+
+    // Attributes of the cells, referenced by the cells' attribute index
     UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Instanced)
-    TArray<AActor*> ManagedItems;
+    TArray<UGridCellAttributes*> CellAttributes;
+
+    // All items managed by this grid
+    UPROPERTY()
+    FGridItemRegistry ItemRegistry;
+
+    // Items of grids saved before the item registry existed, moved into
+    // ItemRegistry and the cells when the grid is loaded
+    UPROPERTY(meta = (DeprecatedProperty, DeprecationMessage = "Use GetManagedItems, the items are now in ItemRegistry"))
+    TArray<AActor*> ManagedItems_DEPRECATED;
+
+    // Get all of the items managed by this grid, in no particular order. Takes
+    // the place of the old ManagedItems property in Blueprints.
+    UFUNCTION(BlueprintPure, Category = "Grid")
+    TArray<AActor*> GetManagedItems() const;
+
+    // Is the item managed by this grid
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    bool IsManagedItem(const AActor* Item) const;
 
-    // Initialize the grid
+    // Get the handle of a managed item, unset if the item is not managed
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    FGridItemHandle GetItemHandle(const AActor* Item) const;
+
+    // Get the item of a handle, nullptr if it is no longer on this grid
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    AActor* GetItemFromHandle(const FGridItemHandle& Handle) const;
+
+    // Initialize the grid: every cell goes back to DefaultCellType, without
+    // attributes. The managed items are put back on their cells, those which
+    // no longer fit are removed from the grid (not destroyed) and reported by
+    // OnGridResized.
     UFUNCTION(BlueprintCallable, Category = "Grid")
     void InitializeGrid();
 
+    // Initialize the grid on a worker thread. Until the build is published
+    // the grid is not ready: queries find no valid cells, and mutations wait
+    // for the build. With bPreserveCells the grid is resized from its current
+    // cells around ResizeAnchor, like ResizeGrid does.
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    void InitializeGridAsync(bool bPreserveCells = false);
+
+    // Resize the grid to NewWidth x NewHeight keeping its cells, in a single
+    // pass over the populated cells. Anchor is the point of the grid that
+    // stays put, in fractions of its size: (0, 0) keeps cell (0, 0), (0.5,
+    // 0.5) grows or shrinks every side evenly, (1, 1) keeps the far corner.
+    // The actor moves to keep the cells where they are in the world. Items
+    // which no longer fit are removed from the grid (not destroyed) and
+    // returned in OutEvictedItems.
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    void ResizeGrid(int32 NewWidth, int32 NewHeight, FVector2D Anchor, TArray<AActor*>& OutEvictedItems);
+
+    // Anchor of the resizes made by editing GridWidth / GridHeight, see
+    // ResizeGrid
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid Settings", meta = (ClampMin = "0", ClampMax = "1"))
+    FVector2D ResizeAnchor = FVector2D::ZeroVector;
+
+    UPROPERTY(BlueprintAssignable, Category = "Grid")
+    FOnGridResized OnGridResized;
+
+    // False while an InitializeGridAsync build is in flight
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    bool IsGridReady() const { return !PendingBuild.IsValid(); }
+
+    // Block until a pending build is done and publish it
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    void WaitForGridReady();
+
+    // Broadcast on the game thread when an InitializeGridAsync build is
+    // published
+    UPROPERTY(BlueprintAssignable, Category = "Grid")
+    FOnGridReady OnGridReady;
+
     // Get the size of the grid
     UFUNCTION(BlueprintCallable, Category = "Grid")
     FVector2D GetGridSize() const;
@@ -76,6 +268,21 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Grid")
     FVector2D WorldToGrid(const FVector& WorldPosition) const;
 
+    // Convert many grid cells to world positions at once
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    void GridToWorldBatch(const TArray<FVector2D>& GridPositions, TArray<FVector>& OutWorldPositions) const;
+    // Convert many world positions to grid cells at once, positions which are
+    // not on the grid give (-1, -1) like WorldToGrid
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    void WorldToGridBatch(const TArray<FVector>& WorldPositions, TArray<FVector2D>& OutGridPositions) const;
+
+    // Rotation of the grid in the world, cached
+    const FQuat& GetGridRotation() const { return CachedGridRotation; }
+
+    // World space to grid space in cell units: cell (X, Y) is centered on
+    // (X, Y, 0)
+    FMatrix GetWorldToCellMatrix() const;
+
     // Check if a cell is valid
     UFUNCTION(BlueprintCallable, Category = "Grid")
     bool IsCellValid(int32 X, int32 Y) const;
@@ -85,12 +292,219 @@ public:
     UGridCell* GetGridCellAtGridPosition(const FVector2D& GridPosition) const;
     UGridCell* GetGridCellAtIndex(int32 Index) const;
 
+    // Get views of all the cells in the grid. Note: this creates a UGridCell
+    // for every cell, prefer the per-cell getters on large grids.
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    TArray<UGridCell*> GetAllCells() const;
+
+    // Rebuild the occupancy bitmask from the cell storage
+    void RebuildOccupancyMask();
+
+    // Move the cells of a grid saved with GridCells into the cell storage
+    void MigrateDeprecatedCells();
+
+    // Move the items of a grid saved with ManagedItems into the item registry
+    // and occupy their cells
+    void MigrateDeprecatedItems();
+
+    // Drop the cached UGridCell views, they will be recreated on demand
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    void ReleaseCellViews();
+
+    // Keep only the chunks of cells within ChunkRadius chunks of the world
+    // position uncompressed: chunks further away are paged out (compressed in
+    // memory), paged out chunks within the radius are paged back in. Paged out
+    // cells are still valid, reading one decompresses a copy, writing one
+    // pages its chunk back in. Tick calls this around the player's view when
+    // ResidentChunkRadius is set.
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    void UpdateResidentChunks(const FVector& WorldPosition, int32 ChunkRadius = 2);
+
+    // Page out the chunks of cells further than this many chunks from the
+    // player's view while the game runs, see UpdateResidentChunks. 0 keeps
+    // every chunk resident.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid Settings", meta = (ClampMin = "0"))
+    int32 ResidentChunkRadius = 0;
+
+    // Number of chunks of cells currently in memory
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    int32 GetNumResidentChunks() const;
+
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    EGridCellType GetCellType(int32 X, int32 Y) const;
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    void SetCellType(int32 X, int32 Y, EGridCellType NewCellType);
+
+    // Get the item occupying the cell at the given index, or nullptr
+    AActor* GetCellOccupant(int32 Index) const;
+    // Set the item occupying the cell at the given index
+    void SetCellOccupant(int32 Index, AActor* Item);
+
+    // Get the rectangle of cells (Max exclusive) covered by an item of the
+    // given size at the given grid position, clipped to the grid
+    FIntRect GetFootprint(const FVector2D& GridPosition, const FVector2D& ItemSize) const;
+    // Mark all the cells of the footprint as occupied by the item
+    void OccupyFootprint(const FIntRect& Footprint, AActor* Item);
+    // Free the cells of the footprint which are occupied by the item
+    void ReleaseFootprint(const FIntRect& Footprint, const AActor* Item);
+    // Journal the placement of the item by its grid component: a new
+    // placement if it had no cells before, a move / rotation otherwise
+    void RecordItemPlacement(const AActor* Item, bool bWasPlaced, const FVector2D& OldPosition);
+
     UFUNCTION(BlueprintCallable, Category = "Grid")
     UGridCellAttributes* GetGridCellAttributes(int32 X, int32 Y);
     UFUNCTION(BlueprintCallable, Category = "Grid")
     UGridCellAttributes* GetGridCellAttributesAtGridPosition(const FVector2D& GridPosition);
     UFUNCTION(BlueprintCallable, Category = "Grid")
     UGridCellAttributes* GetGridCellAttributesAtWorldPosition(const FVector& WorldPosition);
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    void SetGridCellAttributes(int32 X, int32 Y, UGridCellAttributes* Attributes);
+
+    //// Item updates ////
+
+    // Update the managed items from Tick while the game runs
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid Updates")
+    bool bUpdateItems = false;
+
+    // Time UpdateAllItems may spend per call, in microseconds
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid Updates", meta = (ClampMin = "1"))
+    float ItemUpdateBudgetMicroseconds = 500.0f;
+
+    // Advance the managed items by DeltaTime. Items are updated round-robin
+    // until the budget is spent, the rest continue where this call stopped on
+    // the next one. Every item gets the time since its own last update, so
+    // items updated less often catch up.
+    UFUNCTION(BlueprintCallable, Category = "Grid Updates")
+    void UpdateAllItems(float DeltaTime);
+
+    UFUNCTION(BlueprintCallable, Category = "Grid Updates")
+    FGridItemUpdateStats GetItemUpdateStats() const { return ItemUpdateStats; }
+
+    // Put a managed item to sleep: UpdateAllItems skips it until the wake
+    // condition happens or WakeItem is called. Timers count world time and
+    // run out from Tick whether or not the items are updated.
+    UFUNCTION(BlueprintCallable, Category = "Grid Updates")
+    bool SleepItem(AActor* Item, const FGridWakeCondition& WakeCondition);
+
+    // Wake a sleeping item, returns whether it was asleep
+    UFUNCTION(BlueprintCallable, Category = "Grid Updates")
+    bool WakeItem(AActor* Item);
+
+    UFUNCTION(BlueprintCallable, Category = "Grid Updates")
+    bool IsItemSleeping(const AActor* Item) const;
+
+    //// Attribute simulation ////
+
+    // Run the water / soil simulation while the game runs
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid Simulation")
+    bool bSimulateAttributes = false;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid Simulation")
+    FGridAttributeSimulationSettings SimulationSettings;
+
+    UFUNCTION(BlueprintCallable, Category = "Grid Simulation")
+    float GetWaterLevel(int32 X, int32 Y) const;
+    UFUNCTION(BlueprintCallable, Category = "Grid Simulation")
+    void SetWaterLevel(int32 X, int32 Y, float WaterLevel);
+    // Add (or with a negative amount remove) water to a cell
+    UFUNCTION(BlueprintCallable, Category = "Grid Simulation")
+    void AddWater(int32 X, int32 Y, float Amount);
+
+    UFUNCTION(BlueprintCallable, Category = "Grid Simulation")
+    float GetSoilQuality(int32 X, int32 Y) const;
+    UFUNCTION(BlueprintCallable, Category = "Grid Simulation")
+    void SetSoilQuality(int32 X, int32 Y, float SoilQuality);
+
+    // Advance the simulation by one fixed time step
+    UFUNCTION(BlueprintCallable, Category = "Grid Simulation")
+    void StepAttributeSimulation();
+
+    //// Snapshots ////
+
+    // Write the grid's state (cells, simulated attributes, items) into a
+    // compact binary snapshot. A pending InitializeGridAsync build is
+    // published first, its cells are part of the state.
+    UFUNCTION(BlueprintCallable, Category = "Grid Snapshot")
+    void SaveSnapshot(TArray<uint8>& OutData);
+
+    // Replace the grid's state with the snapshot's. The current items are
+    // removed and destroyed, the snapshot's items are spawned and put back
+    // where they were without any placement checks. Returns false (leaving
+    // the grid untouched) if the data is not a valid snapshot.
+    UFUNCTION(BlueprintCallable, Category = "Grid Snapshot")
+    bool LoadSnapshot(const TArray<uint8>& Data);
+
+    UFUNCTION(BlueprintCallable, Category = "Grid Snapshot")
+    bool SaveSnapshotToFile(const FString& Filename);
+    UFUNCTION(BlueprintCallable, Category = "Grid Snapshot")
+    bool LoadSnapshotFromFile(const FString& Filename);
+
+    // Same as above, without the binary encoding
+    void CaptureSnapshot(FGridSnapshot& OutSnapshot);
+    bool RestoreSnapshot(const FGridSnapshot& Snapshot);
+
+    //// Journal ////
+    // Incremental autosave: every placement, removal, move / rotation, cell
+    // type change and attribute write is appended to a journal which a
+    // background writer flushes to disk, and which is compacted into a fresh
+    // snapshot once it grows large. The steps of the attribute simulation are
+    // not journaled, only the compactions capture them.
+
+    // Seconds between two flushes of the journal
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid Journal", meta = (ClampMin = "0"))
+    float JournalFlushInterval = 1.0f;
+
+    // Size the journal may grow to before it is compacted into a snapshot, in
+    // bytes. 0 never compacts on its own.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid Journal", meta = (ClampMin = "0"))
+    int32 JournalCompactionBytes = 4 * 1024 * 1024;
+
+    // Start journaling into <BaseFilename>.gridsnap / .gridjournal, which are
+    // overwritten with a snapshot of the current state
+    UFUNCTION(BlueprintCallable, Category = "Grid Journal")
+    void StartJournal(const FString& BaseFilename);
+
+    // Flush the journal, wait for it to be written and stop journaling
+    UFUNCTION(BlueprintCallable, Category = "Grid Journal")
+    void StopJournal();
+
+    UFUNCTION(BlueprintCallable, Category = "Grid Journal")
+    bool IsJournaling() const { return Journal.IsValid(); }
+
+    // Write a fresh snapshot of the current state and start an empty journal
+    UFUNCTION(BlueprintCallable, Category = "Grid Journal")
+    void CompactJournal();
+
+    // Restore the grid from the snapshot written by a journal, then replay
+    // the journal on top of it. Call StartJournal afterwards to keep
+    // journaling. Returns false if there is no valid snapshot.
+    UFUNCTION(BlueprintCallable, Category = "Grid Journal")
+    bool RecoverFromJournal(const FString& BaseFilename);
+
+    //// Pathfinding ////
+    // Agents walk in 8 directions over the cells which are neither occupied
+    // nor Unusable, without cutting corners.
+
+    UFUNCTION(BlueprintCallable, Category = "Grid Pathfinding")
+    bool IsCellWalkable(int32 X, int32 Y) const;
+
+    // Find a shortest path of cells from Start to Goal, both included. The
+    // start cell may be blocked (the agent is standing there), the goal must
+    // be walkable. Returns false if there is no path.
+    UFUNCTION(BlueprintCallable, Category = "Grid Pathfinding")
+    bool FindPath(const FVector2D& Start, const FVector2D& Goal, TArray<FVector2D>& OutPath, EGridPathAlgorithm Algorithm = EGridPathAlgorithm::JumpPoint) const;
+    bool FindPathCells(const FIntPoint& Start, const FIntPoint& Goal, TArray<FIntPoint>& OutPath, EGridPathAlgorithm Algorithm = EGridPathAlgorithm::JumpPoint) const;
+
+    // Next cell to move to from the cell on the way to the target. Uses the
+    // flow field of the target, which is computed once and shared by all the
+    // agents heading there. Returns false if From is the target or the target
+    // can't be reached from it.
+    UFUNCTION(BlueprintCallable, Category = "Grid Pathfinding")
+    bool GetFlowFieldStep(const FVector2D& Target, const FVector2D& From, FVector2D& OutNextCell) const;
+
+    // The flow field towards the target, nullptr if the target is not
+    // walkable. Only valid until the next pathfinding call.
+    const FGridFlowField* GetFlowField(const FIntPoint& Target) const;
 
     // Get the grid component of an item
     UFUNCTION(BlueprintCallable, Category = "Grid")
@@ -102,6 +516,40 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Grid")
     TArray<UGridCell*> GetCells(const FVector2D& GridPosition, const FVector2D& GridSize) const;
 
+    //// Iteration ////
+    // Allocation free alternatives to the functions above, for code that runs
+    // in tight loops. The visitors call Func(const FIntPoint& Cell, int32 Index)
+    // for every cell, cells outside of the grid are skipped.
+
+    // Most cells in the neighborhood of a single cell
+    static constexpr int32 MaxNeighborCells = 8;
+
+    // Visit the cells of a rectangle (Max is exclusive)
+    template <typename FuncType>
+    void ForEachCellInRect(const FIntRect& Rect, FuncType&& Func) const;
+
+    // Visit the cells of the one cell wide ring around a rectangle (Max is
+    // exclusive), each cell once
+    template <typename FuncType>
+    void ForEachPerimeterCell(const FIntRect& Rect, FuncType&& Func) const;
+
+    // Visit the (up to 8) cells around a cell
+    template <typename FuncType>
+    void ForEachNeighborCell(const FIntPoint& Cell, FuncType&& Func) const;
+
+    // Write the indices of the cells around a cell / around a rectangle / in a
+    // rectangle into OutIndices, skipping occupied cells unless
+    // IncludeOccupied. Returns the number of indices written, which is at most
+    // the size of OutIndices, e.g.
+    //   int32 Indices[AGrid::MaxNeighborCells];
+    //   int32 Num = Grid->GetNeighborCellIndices(Cell, Indices);
+    int32 GetNeighborCellIndices(const FIntPoint& Cell, TArrayView<int32> OutIndices, bool IncludeOccupied = false) const;
+    int32 GetPerimeterCellIndices(const FIntRect& Rect, TArrayView<int32> OutIndices, bool IncludeOccupied = false) const;
+    int32 GetRectCellIndices(const FIntRect& Rect, TArrayView<int32> OutIndices) const;
+
+    // Is the cell occupied by an item, the cell must be valid
+    bool IsCellOccupied(const FIntPoint& Cell) const { return OccupancyMask.Get(Cell.X, Cell.Y); }
+
     // Is this actor a placeable item
     UFUNCTION(BlueprintCallable, Category = "Grid")
     bool IsPlaceableItem(const AActor* Item) const;
@@ -117,6 +565,24 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Grid")
     bool CheckIfCellsAreFree(const FVector2D &GridPosition, const FVector2D &ItemSize, const AActor *Item=nullptr) const;
 
+    // Is the cell blocked for placement, i.e. occupied or Unusable
+    bool IsCellBlocked(int32 X, int32 Y) const;
+
+    // Are all the cells in [X, X+Width) x [Y, Y+Height) on the grid, free and
+    // not Unusable? This is a constant time lookup, whatever the size.
+    bool IsAreaPlaceable(int32 X, int32 Y, int32 Width, int32 Height) const;
+
+    // Get all the grid positions where an item of the given size, at the given
+    // rotation, fits on free cells which are not Unusable
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    TArray<FVector2D> GetValidPlacementPositions(const FVector2D& ItemSize, float Rotation = 0.0f) const;
+
+    // Find the valid placement position (see GetValidPlacementPositions) for
+    // which the center of the item is closest to the world position. Returns
+    // false if the item does not fit anywhere.
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    bool FindNearestValidPlacementPosition(const FVector2D& ItemSize, float Rotation, const FVector& WorldPosition, FVector2D& OutGridPosition) const;
+
     // Can an item of the given size be placed in the given cell?
     UFUNCTION(BlueprintCallable, Category = "Grid")
     bool CanPlaceInCell(const FVector2D &ItemSize, const UGridCell *Cell) const;
@@ -151,10 +617,29 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Grid")
     bool PlaceItemAtGridPosition(AActor* Item, const FVector2D& GridPosition);
 
+    // Place all of the items, or none of them. Every placement is checked
+    // against the grid and against the other placements of the batch in a
+    // single pass before anything is changed. The items are then placed
+    // together and announced with one OnItemsChanged broadcast, their own
+    // OnPlacedInGrid / OnGridPositionRotationChanged events are not
+    // broadcast. Returns false with the indices of the placements that failed
+    // if any of them cannot be placed.
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    bool PlaceItems(const TArray<FGridItemPlacement>& Placements, TArray<int32>& OutFailedPlacements);
+
     // Remove an item
     UFUNCTION(BlueprintCallable, Category = "Grid")
     bool RemoveItem(AActor* Item);
 
+    // Remove all of the items, or none of them if any of them is not on this
+    // grid. Announced with one OnItemsChanged broadcast.
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    bool RemoveItems(const TArray<AActor*>& Items);
+
+    // Broadcast whenever items are placed on or removed from this grid
+    UPROPERTY(BlueprintAssignable, Category = "Grid")
+    FOnGridItemsChanged OnItemsChanged;
+
     // Rotate an item
     UFUNCTION(BlueprintCallable, Category = "Grid")
     bool RotateItem(AActor* Item, float NewRotation);
@@ -205,4 +690,285 @@ public:
     void DebugDrawGrid(const FColor& EmptyColor = FColor::Green, const FColor& OccupiedColor = FColor::Red) const;
     UFUNCTION(BlueprintCallable, Category = "Grid")
     void DebugDrawItem(const AActor* Item, const FColor& ItemColor = FColor::Red) const;
+
+    // Update the persistent visualization of the grid (enabled by the
+    // grid.DebugDraw console variable). The lattice between the cells is drawn
+    // once, only the occupied and unusable cells get boxes of their own, and
+    // only the boxes of the cells which changed since the last update are
+    // replaced. Nothing is done if none did.
+    void UpdateDebugDrawing();
+
+    //// Worker thread queries ////
+
+    // Publish a query snapshot from Tick in the frames the grid changed, for
+    // AI, procedural placement and other work on worker threads. Off by
+    // default: a snapshot holds a copy of the cell types of the whole grid,
+    // only grids with workers querying them should pay for it.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid Settings")
+    bool bPublishQuerySnapshots = false;
+
+    // The last published snapshot of the grid, or null if there is none yet.
+    // Safe to call from any thread, the snapshot can be kept and queried there
+    // for as long as needed.
+    TSharedPtr<const FGridQuerySnapshot, ESPMode::ThreadSafe> GetQuerySnapshot() const;
+
+    // Publish a snapshot of the grid as it is now, if it changed since the
+    // last one. Game thread only, Tick calls it once per frame while
+    // bPublishQuerySnapshots is set; call it yourself to hand work off right
+    // after changing the grid. Does nothing while the grid isn't ready,
+    // workers keep the last snapshot until then.
+    void PublishQuerySnapshot();
+
+    //// Stats ////
+
+    // Memory used by the grid's cells, items and caches, in bytes. Shown per
+    // grid by the grid.Memory console command.
+    UFUNCTION(BlueprintCallable, Category = "Grid Stats")
+    int64 GetMemoryUsage() const;
+
+    // Number of UGridCell views the grid tracks, views which were garbage
+    // collected are dropped from it within a second
+    UFUNCTION(BlueprintCallable, Category = "Grid Stats")
+    int32 GetNumCellObjects() const { return CellViews.Num(); }
+
+protected:
+
+    // Get (creating it if needed) the UGridCell view of the cell at the index
+    UGridCell* GetCellView(int32 Index) const;
+    // Copy the stored state of the cell into its view, if it has one
+    void SyncCellView(int32 Index) const;
+
+    // Set the registry slot of the item occupying the cell at the index
+    void SetCellOccupantSlot(int32 Index, int32 Slot);
+
+    // Cell a grid position places an item at, rounded up the same way by
+    // every placement function
+    static FIntPoint GetPlacementCell(const FVector2D& GridPosition) {
+        return FIntPoint(FMath::CeilToInt(GridPosition.X), FMath::CeilToInt(GridPosition.Y));
+    }
+
+    bool CanPlaceItemAtXY(const AActor* Item, int32 X, int32 Y) const;
+    bool PlaceItemAtXY(AActor* Item, int32 X, int32 Y);
+    void DrawCellAtXY(int32 X, int32 Y, const FColor& Color, float Duration) const;
+
+    // One bit per cell, set when the cell is occupied. Kept in sync by
+    // SetCellOccupant and used by the placement checks.
+    FGridOccupancyMask OccupancyMask;
+
+    // Summed-area table of the blocked cells, updated lazily by the placement
+    // queries from the cells changed since the last query
+    mutable FGridSummedAreaTable PlacementTable;
+
+    // Walkable cells and cached flow fields, updated lazily by the
+    // pathfinding queries from the cells changed since the last query
+    mutable FGridPathfinder Pathfinder;
+
+    // The pathfinder, with the changed cells applied
+    FGridPathfinder& GetUpdatedPathfinder() const;
+
+    // Authored read-only cell data, mapped from StaticLayerFile. Cells the
+    // layer marks unusable are Unusable whatever the cell storage says.
+    FGridStaticLayer StaticLayer;
+
+    // Map StaticLayerFile if it isn't yet, or unmap it if it no longer
+    // matches the grid
+    void RefreshStaticLayer();
+
+    // Type of the cell at the index with the static layer applied
+    EGridCellType GetCellTypeAtIndex(int32 Index) const {
+        return StaticLayer.IsMapped() && StaticLayer.IsUnusable(Index) ? EGridCellType::Unusable : CellStore.GetType(Index);
+    }
+
+    // What changed since the last query snapshot
+    bool bQueryOccupancyDirty = true;
+    bool bQueryTypesDirty = true;
+
+    // The last published query snapshot and the lock of the pointer (not of
+    // the snapshot, which never changes). Only the game thread writes it.
+    TSharedPtr<const FGridQuerySnapshot, ESPMode::ThreadSafe> QuerySnapshot;
+    mutable FRWLock QuerySnapshotLock;
+    uint64 QuerySnapshotVersion = 0;
+
+    // Journal of the mutations, while journaling
+    TUniquePtr<FGridJournal> Journal;
+    float JournalFlushTimer = 0.0f;
+
+    // Chunk the resident chunks were last centered on, and the time since
+    int32 ResidencyCenterChunkX = INDEX_NONE;
+    int32 ResidencyCenterChunkY = INDEX_NONE;
+    float ResidencyTimer = 0.0f;
+
+    // Page the chunks in and out around the player's view, when it moved to
+    // another chunk or every now and then for the chunks written in the
+    // meantime
+    void TickChunkResidency(float DeltaTime);
+    // Set while restoring or replaying, whose changes are not journaled again
+    bool bSuppressJournal = false;
+
+    bool IsRecordingJournal() const { return Journal.IsValid() && !bSuppressJournal; }
+    void RecordMutation(FGridJournalRecord& Record);
+    void RecordItemRemoval(const UGridComponent* GridComponent);
+    // Flush / compact the journal when it is due
+    void TickJournal(float DeltaTime);
+    // Redo a journaled mutation, returns false if it no longer applies
+    bool ApplyJournalRecord(const FGridJournalRecord& Record);
+    // The item whose origin is the cell
+    AActor* FindItemAtOrigin(const FIntPoint& Cell) const;
+
+    // Water level and soil quality of every cell, allocated when first written
+    UPROPERTY()
+    FGridAttributeField AttributeField;
+
+    // Game time not simulated yet, less than one time step
+    float SimulationTimeAccumulator = 0.0f;
+
+    // Clock of the item updates, the sum of the UpdateAllItems delta times
+    double ItemUpdateTime = 0.0;
+    // Dense index in the item registry of the next item to update
+    int32 ItemUpdateCursor = 0;
+    // Items updated and time the current pass started
+    int32 ItemUpdatePassCount = 0;
+    double ItemUpdatePassStart = 0.0;
+    FGridItemUpdateStats ItemUpdateStats;
+
+    // Sleeping items and their wake conditions
+    FGridItemSleepIndex SleepIndex;
+    // Items woken since the last update, their OnGridItemWake is broadcast by
+    // the next update rather than in the middle of a grid change
+    TArray<FGridItemHandle> PendingWakes;
+    // Scratch list of the slots to wake
+    TArray<int32> WakeScratch;
+
+    // Clock of the sleep timers, the world's game time
+    double GetSleepTime() const;
+    // Wake the items whose sleep timers ran out
+    void WakeExpiredSleepers();
+    // Wake the items in the slots and queue their notification
+    void WakeSlots(const TArray<int32>& Slots);
+    // Wake the sleeping items watching the cell / its attributes
+    void WakeCellSubscribers(int32 Index);
+    void WakeAttributeWatchers(int32 CellIndex = INDEX_NONE);
+    // Broadcast OnGridItemWake for the queued items
+    void NotifyPendingWakes();
+
+    // Allocate the attribute field if it isn't yet
+    FGridAttributeField& GetWritableAttributeField();
+
+    // Run the fixed time steps that fit in the accumulated time
+    void TickAttributeSimulation(float DeltaTime);
+
+    // The InitializeGridAsync build in flight, it owns the cells until it is
+    // published
+    TSharedPtr<FGridInitBuild> PendingBuild;
+
+    // Hand the cells over to a new pending build of the current size
+    TSharedPtr<FGridInitBuild> PrepareBuild(bool bPreserveCells, const FVector2D& Anchor);
+
+    // Move the cells of the finished build in and broadcast OnGridReady.
+    // Ignored if the build is no longer the pending one.
+    void PublishBuild(const TSharedPtr<FGridInitBuild>& Build);
+
+    // Move the items by the offset of a rebuild and remove those which no
+    // longer fit. Unless the rebuild preserved the cells (and so the cells'
+    // occupants) the items occupy their cells again.
+    void RestoreItemsAfterRebuild(const FIntPoint& Offset, bool bCellsPreserved, TArray<AActor*>& OutEvictedItems);
+
+    // Refresh the cached transforms from the actor's transform
+    void UpdateCachedTransform();
+    // Refresh our entry in the world's grid index, after we moved or were
+    // resized
+    void UpdateWorldIndex();
+    // Keep the cached transforms up to date with the root component
+    void BindTransformUpdates();
+    void OnRootTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+
+    // The actor's transform, cached for the conversions between world and
+    // grid space. Refreshed whenever the root component moves.
+    FQuat CachedGridRotation{FQuat::Identity};
+    FVector CachedGridLocation{FVector::ZeroVector};
+    FVector CachedGridUpVector{FVector::UpVector};
+    FMatrix CachedWorldToLocal{FMatrix::Identity};
+    // Bumped every time the cached transform changes
+    uint32 TransformVersion = 0;
+
+    // Root component we listen to for transform updates
+    TWeakObjectPtr<USceneComponent> TransformSource;
+
+    // Draw the lines between the cells, the same for every cell
+    void DrawDebugLattice();
+    // Add the debug box of the cell at the index to OutLines if the cell is
+    // drawn with one (occupied or unusable), in the batch of the cell
+    void AddCellDebugBox(int32 Index, bool bOccupied, EGridCellType Type, TArray<FBatchedLine>& OutLines);
+
+    // Line batcher holding the persistent grid visualization
+    UPROPERTY(Transient)
+    ULineBatchComponent* DebugLineBatcher = nullptr;
+
+    // The cells which have a box in the line batcher, by cell index
+    TBitArray<> DebugBoxCells;
+
+    // Cells changed since the last visualization update, only tracked while
+    // the visualization is on
+    TArray<int32> DebugDirtyCells;
+    bool bDebugDrawActive = false;
+    bool bDebugDrawAllDirty = true;
+
+    // Transform version and cell size the visualization was built with
+    uint32 DebugDrawTransformVersion = 0;
+    float DebugDrawCellSize = 0.0f;
+
+    // UGridCell views handed out to callers, by cell index. The grid only
+    // keeps weak references: a view lives as long as a caller holds on to it,
+    // the entries of collected views are pruned from Tick.
+    TMap<int32, TWeakObjectPtr<UGridCell>> CellViews;
+    // Time since the cell views were last pruned
+    float CellViewsPruneTimer = 0.0f;
+
+    // Drop the entries of cell views which have been garbage collected, at
+    // most once a second
+    void PruneCellViews(float DeltaTime);
+
+    // Memory and cell views this grid last added to the STATGROUP_GridManager
+    // totals
+    int64 ReportedMemory = 0;
+    int32 ReportedCellObjects = 0;
+    // Time since the memory was last reported
+    float StatsMemoryTimer = 0.0f;
+
+    // Bring our share of the totals up to date / take it out again. Only
+    // while stats are collected, and the memory (which goes over all of the
+    // grid's storage) once a second at most.
+    void UpdateStats(float DeltaTime);
+    void ClearStats();
 };
+
+template <typename FuncType>
+void AGrid::ForEachCellInRect(const FIntRect& Rect, FuncType&& Func) const {
+    if (!IsGridReady()) {
+        return;
+    }
+    const int32 MinX = FMath::Max(Rect.Min.X, 0);
+    const int32 MaxX = FMath::Min(Rect.Max.X, GridWidth);
+    const int32 MinY = FMath::Max(Rect.Min.Y, 0);
+    const int32 MaxY = FMath::Min(Rect.Max.Y, GridHeight);
+    for (int32 y = MinY; y < MaxY; ++y) {
+        for (int32 x = MinX; x < MaxX; ++x) {
+            Func(FIntPoint(x, y), y * GridWidth + x);
+        }
+    }
+}
+
+template <typename FuncType>
+void AGrid::ForEachPerimeterCell(const FIntRect& Rect, FuncType&& Func) const {
+    // the rows above and below, corners included
+    ForEachCellInRect(FIntRect(Rect.Min.X - 1, Rect.Min.Y - 1, Rect.Max.X + 1, Rect.Min.Y), Func);
+    ForEachCellInRect(FIntRect(Rect.Min.X - 1, Rect.Max.Y, Rect.Max.X + 1, Rect.Max.Y + 1), Func);
+    // the columns to the left and right, between the rows
+    ForEachCellInRect(FIntRect(Rect.Min.X - 1, Rect.Min.Y, Rect.Min.X, Rect.Max.Y), Func);
+    ForEachCellInRect(FIntRect(Rect.Max.X, Rect.Min.Y, Rect.Max.X + 1, Rect.Max.Y), Func);
+}
+
+template <typename FuncType>
+void AGrid::ForEachNeighborCell(const FIntPoint& Cell, FuncType&& Func) const {
+    ForEachPerimeterCell(FIntRect(Cell, Cell + FIntPoint(1, 1)), Func);
+}
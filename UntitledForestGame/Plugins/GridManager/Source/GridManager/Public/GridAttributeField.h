@@ -0,0 +1,110 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GridAttributeField.generated.h"
+
+// Rates of the cell attribute simulation, all per second of game time
+USTRUCT(BlueprintType)
+struct GRIDMANAGER_API FGridAttributeSimulationSettings
+{
+    GENERATED_BODY()
+
+    // Simulated seconds per step, the simulation always advances in steps of
+    // this size
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid Simulation", meta = (ClampMin = "0.001"))
+    float TimeStep = 0.1f;
+
+    // Most steps run in a single frame, any time beyond that is dropped so a
+    // long frame can't snowball
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid Simulation", meta = (ClampMin = "1"))
+    int32 MaxStepsPerFrame = 4;
+
+    // Fraction of the difference in water level to each neighbor that flows
+    // over per second
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid Simulation", meta = (ClampMin = "0"))
+    float WaterDiffusionRate = 0.5f;
+
+    // Fraction of the water that evaporates per second
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid Simulation", meta = (ClampMin = "0"))
+    float EvaporationRate = 0.01f;
+
+    // Fraction of the soil quality that is lost per second
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid Simulation", meta = (ClampMin = "0"))
+    float SoilDecayRate = 0.001f;
+
+    // Values of cells that were never written
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid Simulation")
+    float InitialWaterLevel = 0.1f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid Simulation")
+    float InitialSoilQuality = 0.5f;
+};
+
+// Native per-cell water level and soil quality of a grid, indexed by the cell
+// index (Y * Width + X).
+//
+// The field is double buffered: a step reads only the current values and
+// writes the next ones, then the buffers are swapped. Every cell is a pure
+// function of the current buffer, so the rows can be split across threads and
+// the result is the same whatever the number of threads.
+USTRUCT()
+struct GRIDMANAGER_API FGridAttributeField
+{
+    GENERATED_BODY()
+
+public:
+
+    // (Re)allocate the field for a Width x Height grid with the given values
+    void Init(int32 InWidth, int32 InHeight, float WaterLevel, float SoilQuality);
+
+    // (Re)initialize the field for a Width x Height grid from whole columns
+    // of values, one per cell. Returns false (leaving the field untouched) if
+    // the columns don't have one value per cell.
+    bool InitFromColumns(int32 InWidth, int32 InHeight, TArray<float> InWaterLevels, TArray<float> InSoilQualities);
+
+    // Release all of the storage
+    void Empty();
+
+    bool IsInitialized() const { return WaterLevels.Num() > 0 && WaterLevels.Num() == Width * Height; }
+    int32 GetWidth() const { return Width; }
+    int32 GetHeight() const { return Height; }
+
+    float GetWaterLevel(int32 Index) const { return WaterLevels[Index]; }
+    void SetWaterLevel(int32 Index, float WaterLevel) { WaterLevels[Index] = FMath::Max(0.0f, WaterLevel); }
+
+    float GetSoilQuality(int32 Index) const { return SoilQualities[Index]; }
+    void SetSoilQuality(int32 Index, float SoilQuality) { SoilQualities[Index] = FMath::Max(0.0f, SoilQuality); }
+
+    // The values of all the cells, by cell index
+    const TArray<float>& GetWaterLevels() const { return WaterLevels; }
+    const TArray<float>& GetSoilQualities() const { return SoilQualities; }
+
+    // Advance the simulation by DeltaTime seconds: water diffuses to the 4
+    // neighbors and evaporates, soil quality decays
+    void Step(const FGridAttributeSimulationSettings& Settings, float DeltaTime);
+
+    // Memory used by the field, in bytes
+    SIZE_T GetAllocatedSize() const;
+
+private:
+
+    // Compute the next values of the rows [RowBegin, RowEnd)
+    void StepRows(int32 RowBegin, int32 RowEnd, float Diffusion, float WaterRetained, float SoilRetained);
+
+    UPROPERTY()
+    int32 Width = 0;
+
+    UPROPERTY()
+    int32 Height = 0;
+
+    // Current values
+    UPROPERTY()
+    TArray<float> WaterLevels;
+
+    UPROPERTY()
+    TArray<float> SoilQualities;
+
+    // Next values, only valid during a step
+    TArray<float> NextWaterLevels;
+    TArray<float> NextSoilQualities;
+};
@@ -41,7 +41,13 @@ public:
     // Fill out in blueprint or subclass
 };
 
-// Struct for grid cell
+// View of a single grid cell. The grid itself stores its cells in chunked
+// arrays (see FGridCellStore); UGridCell objects are only created on demand by
+// the AGrid getters so that Blueprints have something to hold on to. The
+// properties are a snapshot that the grid keeps in sync; setting CellType,
+// Attributes or OccupyingItem goes through their setters, which write to the
+// grid's storage. GridPosition and Grid are read-only: a view always shows the
+// same cell.
 UCLASS(BlueprintType, Blueprintable, EditInlineNew, DefaultToInstanced)
 class GRIDMANAGER_API UGridCell : public UObject
 {
@@ -59,13 +65,13 @@ public:
     UPROPERTY(Transient)
     UWorld* World;
 
-    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
     FVector2D GridPosition;
 
-    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    UPROPERTY(VisibleAnywhere, BlueprintReadWrite, BlueprintSetter = SetCellType)
     EGridCellType CellType;
 
-    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    UPROPERTY(VisibleAnywhere, BlueprintReadWrite, BlueprintSetter = SetAttributes)
     UGridCellAttributes* Attributes = nullptr;
 
     UFUNCTION(BlueprintCallable)
@@ -75,8 +81,17 @@ public:
     bool IsOccupied() const;
 
     UFUNCTION(BlueprintCallable)
+    AActor* GetOccupyingItem() const;
+
+    UFUNCTION(BlueprintCallable, BlueprintSetter)
     void SetOccupyingItem(AActor* Item);
 
+    UFUNCTION(BlueprintCallable, BlueprintSetter)
+    void SetCellType(EGridCellType NewCellType);
+
+    UFUNCTION(BlueprintCallable, BlueprintSetter)
+    void SetAttributes(UGridCellAttributes* NewAttributes);
+
     UFUNCTION(BlueprintCallable)
     FVector GetWorldPosition() const;
 
@@ -93,9 +108,9 @@ protected:
     friend class AGrid;
 
     // Pointer to the grid this cell belongs to
-    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
     AGrid* Grid;
 
-    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    UPROPERTY(VisibleAnywhere, BlueprintReadWrite, BlueprintSetter = SetOccupyingItem)
     AActor* OccupyingItem;
 };
@@ -0,0 +1,328 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GridCell.h"
+#include "GridCellStore.generated.h"
+
+// How FGridCellStore keeps its cells
+UENUM(BlueprintType)
+enum class EGridStorageMode : uint8
+{
+    // Lazily allocated 32x32 chunks, for grids where most cells are used
+    Chunked,
+    // Only the cells that differ from the default, in a hash table. For large
+    // grids where only a few cells are used.
+    Sparse,
+};
+
+// State of a chunk of cells in FGridCellStore
+UENUM()
+enum class EGridChunkState : uint8
+{
+    // Never written, every cell has the default values and nothing is allocated
+    Unallocated,
+    // The cells are in memory
+    Resident,
+    // The cells were unloaded, they only exist compressed in PagedData. The
+    // compressed cells stay in memory, paging out trades CPU time for a
+    // smaller footprint, it doesn't move anything to disk.
+    PagedOut,
+};
+
+// A ChunkSize x ChunkSize block of cells. Every cell attribute lives in its own
+// contiguous array (struct-of-arrays), indexed by the cell's position within
+// the chunk.
+USTRUCT()
+struct GRIDMANAGER_API FGridCellChunk
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    EGridChunkState State = EGridChunkState::Unallocated;
+
+    UPROPERTY()
+    TArray<EGridCellType> Types;
+
+    UPROPERTY()
+    TArray<int32> OccupantSlots;
+
+    UPROPERTY()
+    TArray<int32> AttributeIndices;
+
+    // The compressed cells while the chunk is paged out
+    UPROPERTY()
+    TArray<uint8> PagedData;
+
+    UPROPERTY()
+    int32 PagedDataUncompressedSize = 0;
+};
+
+// A non-default cell of a sparse FGridCellStore
+USTRUCT()
+struct GRIDMANAGER_API FGridSparseCell
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    EGridCellType Type = EGridCellType::Ground;
+
+    UPROPERTY()
+    int32 OccupantSlot = INDEX_NONE;
+
+    UPROPERTY()
+    int32 AttributeIndex = INDEX_NONE;
+};
+
+// Storage for the cells of an AGrid. The grid is split into fixed size chunks
+// which are only allocated once a cell in them is written, reads of cells in
+// an unallocated chunk return the default values. This avoids having a UObject
+// per cell and keeps huge, mostly untouched grids cheap; the occupants are
+// stored as their slot in the grid's FGridItemRegistry.
+//
+// Chunks can be paged out (compressed in memory, their cells freed) and are
+// paged back in when a cell in them is written, or ahead of time with PageIn.
+// Reading a cell of a paged out chunk decompresses the chunk into a scratch
+// copy and leaves it paged out, so read-only sweeps don't undo the paging;
+// which chunks are resident is up to the owner (see
+// AGrid::UpdateResidentChunks). Cells are
+// still addressed by their cell index (Y * Width + X), a lookup is a couple of
+// shifts and masks whatever chunk the cell is in.
+//
+// In Sparse mode there are no chunks: only the cells which differ from the
+// default are stored, in an open-addressing hash table (linear probing) keyed
+// by the packed cell coordinates, so memory scales with the number of
+// populated cells instead of the area of the grid.
+USTRUCT()
+struct GRIDMANAGER_API FGridCellStore
+{
+    GENERATED_BODY()
+
+public:
+
+    static constexpr int32 ChunkShift = 5;
+    static constexpr int32 ChunkSize = 1 << ChunkShift;
+    static constexpr int32 ChunkMask = ChunkSize - 1;
+    static constexpr int32 CellsPerChunk = ChunkSize * ChunkSize;
+
+    // (Re)initialize the store for a Width x Height grid of cells of the given
+    // type, with no occupant and no attributes. Nothing is allocated until the
+    // cells are written.
+    void Init(int32 InWidth, int32 InHeight, EGridCellType InDefaultType, EGridStorageMode InMode = EGridStorageMode::Chunked);
+
+    // Move the cells over to another storage mode, keeping their values
+    void SetMode(EGridStorageMode NewMode);
+    EGridStorageMode GetMode() const { return Mode; }
+    EGridCellType GetDefaultType() const { return DefaultType; }
+
+    // Release all of the storage
+    void Empty();
+
+    int32 Num() const { return Width * Height; }
+    bool IsValidIndex(int32 Index) const { return Index >= 0 && Index < Num(); }
+    int32 GetWidth() const { return Width; }
+    int32 GetHeight() const { return Height; }
+
+    EGridCellType GetType(int32 Index) const;
+    void SetType(int32 Index, EGridCellType Type);
+
+    // Registry slot of the occupying item, or INDEX_NONE if the cell is free
+    int32 GetOccupantSlot(int32 Index) const;
+    void SetOccupantSlot(int32 Index, int32 Slot);
+    bool IsOccupied(int32 Index) const { return GetOccupantSlot(Index) != INDEX_NONE; }
+
+    // Index into AGrid::CellAttributes, or INDEX_NONE if the cell has none
+    int32 GetAttributeIndex(int32 Index) const;
+    void SetAttributeIndex(int32 Index, int32 AttributeIndex);
+
+    // Call Func(CellIndex, Slot) for every occupied cell, without paging any
+    // chunks in
+    template <typename FuncType>
+    void ForEachOccupiedCell(FuncType&& Func) const;
+
+    // Call Func(CellIndex, Type, Slot, AttributeIndex) for every cell which
+    // differs from the default, without paging any chunks in
+    template <typename FuncType>
+    void ForEachNonDefaultCell(FuncType&& Func) const;
+
+    // Number of cells stored in the sparse table
+    int32 GetNumSparseCells() const { return NumSparseCells; }
+
+    //// Chunks ////
+
+    int32 GetNumChunksX() const { return NumChunksX; }
+    int32 GetNumChunksY() const { return NumChunksY; }
+    int32 GetChunkIndex(int32 ChunkX, int32 ChunkY) const { return ChunkY * NumChunksX + ChunkX; }
+    bool IsValidChunk(int32 ChunkX, int32 ChunkY) const { return ChunkX >= 0 && ChunkX < NumChunksX && ChunkY >= 0 && ChunkY < NumChunksY; }
+    EGridChunkState GetChunkState(int32 ChunkX, int32 ChunkY) const { return Chunks[GetChunkIndex(ChunkX, ChunkY)].State; }
+
+    // Compress the cells of a resident chunk and free them. Chunks with only
+    // default cells go back to being unallocated. Returns whether the chunk was
+    // resident.
+    bool PageOut(int32 ChunkX, int32 ChunkY);
+
+    // Decompress the cells of a paged out chunk. Returns whether the chunk was
+    // paged out.
+    bool PageIn(int32 ChunkX, int32 ChunkY);
+
+    // Number of chunks in the given state
+    int32 CountChunks(EGridChunkState State) const;
+
+    // Memory used by the store, in bytes
+    SIZE_T GetAllocatedSize() const;
+
+private:
+
+    // Chunk and position within the chunk of the cell at the index
+    FORCEINLINE void Locate(int32 Index, int32& OutChunk, int32& OutLocal) const {
+        const int32 X = Index % Width;
+        const int32 Y = Index / Width;
+        OutChunk = (Y >> ChunkShift) * NumChunksX + (X >> ChunkShift);
+        OutLocal = ((Y & ChunkMask) << ChunkShift) | (X & ChunkMask);
+    }
+
+    // The chunk for reading, nullptr if it is unallocated. A paged out chunk
+    // is decompressed into ReadScratch, not paged in.
+    const FGridCellChunk* GetChunkForRead(int32 ChunkIndex) const;
+    // The chunk for writing, allocated or paged in if needed
+    FGridCellChunk& GetChunkForWrite(int32 ChunkIndex);
+
+    void AllocateChunk(FGridCellChunk& Chunk) const;
+    bool IsChunkDefault(const FGridCellChunk& Chunk) const;
+    static void SerializeChunkCells(FArchive& Ar, FGridCellChunk& Chunk);
+    bool DecompressChunk(const FGridCellChunk& Chunk, FGridCellChunk& OutCells) const;
+
+    //// Sparse table ////
+
+    static constexpr uint64 EmptySparseKey = MAX_uint64;
+
+    static uint64 PackCoords(int32 X, int32 Y) { return (uint64(uint32(Y)) << 32) | uint32(X); }
+    uint64 PackIndex(int32 Index) const { return PackCoords(Index % Width, Index / Width); }
+    int32 UnpackIndex(uint64 Key) const { return int32(Key >> 32) * Width + int32(Key & MAX_uint32); }
+    int32 GetHomeSlot(uint64 Key) const {
+        // Fibonacci hashing, the high bits are the best mixed
+        return int32(((Key * 0x9E3779B97F4A7C15ull) >> 32) & uint64(SparseKeys.Num() - 1));
+    }
+
+    // Slot of the key in the table, or INDEX_NONE
+    int32 FindSparseSlot(uint64 Key) const;
+    // Slot of the key in the table, inserting a default cell if needed
+    int32 FindOrAddSparseSlot(uint64 Key);
+    // Remove the cell in the slot if it went back to the default values
+    void RemoveSparseSlotIfDefault(int32 Slot);
+    void RehashSparse(int32 NewCapacity);
+
+    UPROPERTY()
+    EGridStorageMode Mode = EGridStorageMode::Chunked;
+
+    UPROPERTY()
+    int32 Width = 0;
+
+    UPROPERTY()
+    int32 Height = 0;
+
+    UPROPERTY()
+    int32 NumChunksX = 0;
+
+    UPROPERTY()
+    int32 NumChunksY = 0;
+
+    UPROPERTY()
+    EGridCellType DefaultType = EGridCellType::Ground;
+
+    // NumChunksX x NumChunksY chunks
+    UPROPERTY()
+    TArray<FGridCellChunk> Chunks;
+
+    // Sparse hash table, a power of two number of slots. Free slots have the
+    // EmptySparseKey key.
+    UPROPERTY()
+    TArray<uint64> SparseKeys;
+
+    UPROPERTY()
+    TArray<FGridSparseCell> SparseCells;
+
+    UPROPERTY()
+    int32 NumSparseCells = 0;
+
+    // The cells of the paged out chunk read last, decompressed, so that reads
+    // of several cells of a paged out chunk decompress it once. Dropped
+    // whenever a chunk is paged in or out.
+    mutable FGridCellChunk ReadScratch;
+    mutable int32 ReadScratchChunk = INDEX_NONE;
+};
+
+template <typename FuncType>
+void FGridCellStore::ForEachOccupiedCell(FuncType&& Func) const {
+    if (Mode == EGridStorageMode::Sparse) {
+        for (int32 Slot = 0; Slot < SparseKeys.Num(); ++Slot) {
+            if (SparseKeys[Slot] != EmptySparseKey && SparseCells[Slot].OccupantSlot != INDEX_NONE) {
+                Func(UnpackIndex(SparseKeys[Slot]), SparseCells[Slot].OccupantSlot);
+            }
+        }
+        return;
+    }
+
+    FGridCellChunk Scratch;
+    for (int32 ChunkY = 0; ChunkY < NumChunksY; ++ChunkY) {
+        for (int32 ChunkX = 0; ChunkX < NumChunksX; ++ChunkX) {
+            const FGridCellChunk* Chunk = &Chunks[GetChunkIndex(ChunkX, ChunkY)];
+            if (Chunk->State == EGridChunkState::Unallocated) {
+                continue;
+            }
+            // look at the cells of paged out chunks without keeping them around
+            if (Chunk->State == EGridChunkState::PagedOut) {
+                if (!DecompressChunk(*Chunk, Scratch)) {
+                    continue;
+                }
+                Chunk = &Scratch;
+            }
+            const int32 MaxX = FMath::Min(ChunkSize, Width - ChunkX * ChunkSize);
+            const int32 MaxY = FMath::Min(ChunkSize, Height - ChunkY * ChunkSize);
+            for (int32 LocalY = 0; LocalY < MaxY; ++LocalY) {
+                for (int32 LocalX = 0; LocalX < MaxX; ++LocalX) {
+                    const int32 Slot = Chunk->OccupantSlots[(LocalY << ChunkShift) | LocalX];
+                    if (Slot != INDEX_NONE) {
+                        Func((ChunkY * ChunkSize + LocalY) * Width + ChunkX * ChunkSize + LocalX, Slot);
+                    }
+                }
+            }
+        }
+    }
+}
+
+template <typename FuncType>
+void FGridCellStore::ForEachNonDefaultCell(FuncType&& Func) const {
+    for (int32 Slot = 0; Slot < SparseKeys.Num(); ++Slot) {
+        if (SparseKeys[Slot] != EmptySparseKey) {
+            const FGridSparseCell& Cell = SparseCells[Slot];
+            Func(UnpackIndex(SparseKeys[Slot]), Cell.Type, Cell.OccupantSlot, Cell.AttributeIndex);
+        }
+    }
+
+    FGridCellChunk Scratch;
+    for (int32 ChunkIndex = 0; ChunkIndex < Chunks.Num(); ++ChunkIndex) {
+        const FGridCellChunk* Chunk = &Chunks[ChunkIndex];
+        if (Chunk->State == EGridChunkState::Unallocated) {
+            continue;
+        }
+        if (Chunk->State == EGridChunkState::PagedOut) {
+            if (!DecompressChunk(*Chunk, Scratch)) {
+                continue;
+            }
+            Chunk = &Scratch;
+        }
+        const int32 ChunkX = ChunkIndex % NumChunksX;
+        const int32 ChunkY = ChunkIndex / NumChunksX;
+        const int32 MaxX = FMath::Min(ChunkSize, Width - ChunkX * ChunkSize);
+        const int32 MaxY = FMath::Min(ChunkSize, Height - ChunkY * ChunkSize);
+        for (int32 LocalY = 0; LocalY < MaxY; ++LocalY) {
+            for (int32 LocalX = 0; LocalX < MaxX; ++LocalX) {
+                const int32 Local = (LocalY << ChunkShift) | LocalX;
+                if (Chunk->Types[Local] != DefaultType || Chunk->OccupantSlots[Local] != INDEX_NONE || Chunk->AttributeIndices[Local] != INDEX_NONE) {
+                    Func((ChunkY * ChunkSize + LocalY) * Width + ChunkX * ChunkSize + LocalX, Chunk->Types[Local], Chunk->OccupantSlots[Local],
+                        Chunk->AttributeIndices[Local]);
+                }
+            }
+        }
+    }
+}
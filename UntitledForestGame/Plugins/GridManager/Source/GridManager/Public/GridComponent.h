@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
 #include "GridInterface.h"
+#include "GridItemSleepIndex.h"
 #include "GridComponent.generated.h"
 
 // Forward declarations
@@ -16,6 +17,8 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnPlacedInGrid);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnRemovedFromGrid);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnGridChanged, AGrid*, NewGrid);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnGridPositionRotationChanged, FVector2D, NewPosition, float, NewRotation);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnGridItemUpdate, float, DeltaTime);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnGridItemWake);
 
 // This is the grid component class which an actor must have to be able to be
 // placed on the grid. It is responsible for handling the interaction with the
@@ -35,10 +38,10 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnGridPositionRotationChanged, FVe
 //             object is not on the grid, this will be FVector2D::ZeroVector.
 // - Rotation: The rotation of the object on the grid. This is the rotation of
 //             the object in degrees and is relative to the grid's rotation.
-// - OccupiedCells: A list of the grid cells that the object occupies. If the
-//                  object is larger than one grid square, it will occupy
-//                  multiple grid cells. If the object is not on the grid, this
-//                  list will be empty.
+// - OccupiedFootprint: The rectangle of grid cells that the object occupies.
+//                      If the object is larger than one grid square, it will
+//                      occupy multiple grid cells. If the object is not on the
+//                      grid, this rectangle will be empty.
 // - WorldLocation: The world location of the object. This is set by the grid
 //                 manager when the object is placed on the grid. If the object
 //                 is not on the grid, this will be FVector::ZeroVector. This is
@@ -72,8 +75,17 @@ public:
     // Sets default values for this actor's properties
     UGridComponent();
 
+    // Get the grid component of an actor. Components add themselves to a lookup
+    // when they are registered, so this is a map lookup instead of a search
+    // through all of the actor's components.
+    static UGridComponent* FindGridComponent(const AActor* Actor);
+
 protected:
 
+    // Called when the component is registered / unregistered with its actor
+    virtual void OnRegister() override;
+    virtual void OnUnregister() override;
+
     // Called on the actor's construction
     virtual void BeginPlay() override;
 
@@ -174,18 +186,68 @@ public:
     UPROPERTY(BlueprintAssignable, Category = "Grid")
     FOnGridPositionRotationChanged OnGridPositionRotationChanged;
 
-    // Function to make a transform from the occupied cells
-    FTransform MakeTransform(float AtRotation, const TArray<UGridCell*> &Cells) const;
+    // Broadcast when the grid updates the item (e.g. to grow a plant), with
+    // the time since the item's last update
+    UPROPERTY(BlueprintAssignable, Category = "Grid")
+    FOnGridItemUpdate OnGridItemUpdate;
+
+    // Called by the grid's item update scheduler, see AGrid::UpdateAllItems
+    virtual void UpdateOnGrid(float DeltaTime);
+
+    // Broadcast when the object wakes up after sleeping
+    UPROPERTY(BlueprintAssignable, Category = "Grid")
+    FOnGridItemWake OnGridItemWake;
+
+    // Function to stop the grid updating the object until the wake condition
+    // happens, e.g. a timer or a change in the neighboring cells.
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    bool Sleep(const FGridWakeCondition& WakeCondition);
+
+    // Function to wake the object up again.
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    bool Wake();
+
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    bool IsSleeping() const;
+
+    // Function to make a transform from a footprint of cells
+    FTransform MakeTransform(float AtRotation, const FIntRect &Footprint) const;
+
+    // The cells that the object occupies (Max is exclusive), for use with the
+    // grid's ForEachCellInRect / ForEachPerimeterCell
+    const FIntRect& GetOccupiedFootprint() const { return OccupiedFootprint; }
+
+    // The rectangle of cells covered by the object at its position and
+    // rotation, not clipped to the grid (Max is exclusive)
+    FIntRect GetItemRect() const;
 
  protected:
 
-    // The list of the grid cells that the object occupies.
+    // The cells that the object occupies (Max is exclusive).
     UPROPERTY(BlueprintReadOnly, Category = "Grid")
-    TArray<UGridCell*> OccupiedCells;
+    FIntRect OccupiedFootprint;
 
     // declare that AGrid is a friend class
     friend class AGrid;
 
+    // Grid update time of the last UpdateOnGrid, negative if the item was
+    // never updated
+    double LastGridUpdateTime = -1.0;
+
     // Function to update the occupied cells
     void UpdateOccupiedCells();
+
+    // Move the object to the position and rotation on its grid without
+    // broadcasting, used by Update and by the grid's batch placement
+    void SetPlacement(FVector2D NewPosition, float NewRotation);
+
+    // Put the object at the position and rotation on the grid without
+    // touching the grid's cells or broadcasting, used by the grid when it
+    // restores a snapshot and writes the cells itself
+    void RestorePlacement(AGrid* NewGrid, FVector2D NewPosition, float NewRotation);
+
+    // Broadcast what PlaceInGrid broadcasts, for an object the grid placed
+    // with SetPlacement or RestorePlacement. Called once the whole batch is
+    // in place, so the handlers see the grid with all of it.
+    void NotifyPlacedInGrid(bool bGridChanged);
 };
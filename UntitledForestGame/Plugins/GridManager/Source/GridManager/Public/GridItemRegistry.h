@@ -0,0 +1,99 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GridItemRegistry.generated.h"
+
+// Stable handle to an item registered with a grid. The slot stays the same for
+// as long as the item is on the grid; the generation is bumped every time a
+// slot is freed, so handles to items which have since been removed can be
+// detected.
+USTRUCT(BlueprintType)
+struct GRIDMANAGER_API FGridItemHandle
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly, Category = "Grid")
+    int32 Slot{INDEX_NONE};
+
+    UPROPERTY(BlueprintReadOnly, Category = "Grid")
+    int32 Generation{0};
+
+    bool IsSet() const { return Slot != INDEX_NONE; }
+
+    bool operator==(const FGridItemHandle& Other) const { return Slot == Other.Slot && Generation == Other.Generation; }
+    bool operator!=(const FGridItemHandle& Other) const { return !(*this == Other); }
+};
+
+// The items managed by a grid. Items are kept in a dense array for iteration
+// and are addressed by slot, with a slot table mapping to the dense index. Add,
+// remove and contains are all constant time: removal moves the last item into
+// the freed dense index.
+//
+// The grid cells only store the slot of their occupant (see FGridCellStore),
+// which is valid for as long as the item occupies them.
+USTRUCT()
+struct GRIDMANAGER_API FGridItemRegistry
+{
+    GENERATED_BODY()
+
+public:
+
+    // Register the item if it is not registered yet, returns its handle
+    FGridItemHandle Add(AActor* Item);
+
+    // Unregister the item, returns false if it was not registered
+    bool Remove(const AActor* Item);
+
+    bool Contains(const AActor* Item) const { return SlotLookup.Contains(Item); }
+
+    // Get the handle of the item, unset if it is not registered
+    FGridItemHandle Find(const AActor* Item) const;
+
+    // Get the slot of the item, INDEX_NONE if it is not registered
+    int32 FindSlot(const AActor* Item) const;
+
+    // Get the item of the handle, nullptr if the handle is stale
+    AActor* Get(const FGridItemHandle& Handle) const;
+
+    // Get the item currently in the slot, nullptr if the slot is free
+    AActor* GetBySlot(int32 Slot) const;
+
+    int32 Num() const { return Items.Num(); }
+
+    // The registered items, in no particular order
+    const TArray<AActor*>& GetItems() const { return Items; }
+
+    // Slot of the item at the index of GetItems
+    int32 GetSlotAt(int32 ItemIndex) const { return ItemSlots[ItemIndex]; }
+
+    void Empty();
+
+    // The item to slot lookup is not saved, rebuild it after loading
+    void RebuildLookup();
+
+    // Memory used by the registry, in bytes
+    SIZE_T GetAllocatedSize() const;
+
+private:
+
+    // Dense array of the registered items
+    UPROPERTY()
+    TArray<AActor*> Items;
+
+    // Slot of each of the dense items
+    UPROPERTY()
+    TArray<int32> ItemSlots;
+
+    // Dense index of the item in each slot, INDEX_NONE for free slots
+    UPROPERTY()
+    TArray<int32> SlotDenseIndices;
+
+    // Generation of each slot, bumped when the slot is freed
+    UPROPERTY()
+    TArray<int32> SlotGenerations;
+
+    UPROPERTY()
+    TArray<int32> FreeSlots;
+
+    TMap<const AActor*, int32> SlotLookup;
+};
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GridItemSleepIndex.generated.h"
+
+// Simulated attributes of a cell, see FGridAttributeField
+UENUM(BlueprintType)
+enum class EGridCellAttribute : uint8
+{
+    WaterLevel,
+    SoilQuality,
+};
+
+// When a sleeping grid item wakes up again. The item wakes on whichever of the
+// enabled conditions happens first.
+USTRUCT(BlueprintType)
+struct GRIDMANAGER_API FGridWakeCondition
+{
+    GENERATED_BODY()
+
+    // Wake after this many seconds of game time, 0 for no timer
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid", meta = (ClampMin = "0"))
+    float WakeAfterSeconds = 0.0f;
+
+    // Wake when a cell around the item changes: an item is placed, moved or
+    // removed there, or its type changes
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid")
+    bool bWakeOnNeighborChange = false;
+
+    // Wake when the attribute of the item's origin cell crosses the threshold
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid")
+    bool bWakeOnAttribute = false;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid", meta = (EditCondition = "bWakeOnAttribute"))
+    EGridCellAttribute Attribute = EGridCellAttribute::WaterLevel;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid", meta = (EditCondition = "bWakeOnAttribute"))
+    float Threshold = 0.0f;
+
+    // Wake when the attribute rises to the threshold, or else when it falls to it
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grid", meta = (EditCondition = "bWakeOnAttribute"))
+    bool bWakeWhenAbove = true;
+};
+
+// Which of the items of a grid are asleep and what wakes them, by item
+// registry slot. Nothing is polled per item:
+// - timers sit in a timing wheel, advancing time only looks at the buckets of
+//   the ticks that passed
+// - neighbor conditions subscribe the item to the cells around it, a cell
+//   change only looks at that cell's subscribers
+// - attribute conditions are only checked when the attributes change, against
+//   the items that watch one
+//
+// Timer entries are not removed when an item wakes early, they carry the
+// generation of the sleep they belong to and are dropped once stale.
+struct GRIDMANAGER_API FGridItemSleepIndex
+{
+public:
+
+    // Seconds per tick of the timing wheel, timers are rounded up to it
+    static constexpr double WheelResolution = 0.05;
+    static constexpr int32 WheelSize = 256;
+
+    void Empty();
+
+    bool IsSleeping(int32 Slot) const { return Records.IsValidIndex(Slot) && Records[Slot].bSleeping; }
+    bool HasCellSubscribers() const { return CellSubscribers.Num() > 0; }
+    bool HasAttributeWatchers() const { return AttributeWatchers.Num() > 0; }
+
+    // Put the item in the slot to sleep at time Now. NeighborCells are the
+    // cells to watch for bWakeOnNeighborChange, AttributeCell the cell to watch
+    // for bWakeOnAttribute.
+    void Sleep(int32 Slot, const FGridWakeCondition& Condition, double Now, TConstArrayView<int32> NeighborCells, int32 AttributeCell);
+
+    // Wake the item in the slot, dropping its subscriptions. Returns whether
+    // it was asleep.
+    bool Wake(int32 Slot);
+
+    // Advance the wheel to Now and append the slots whose timer expired
+    void AdvanceTime(double Now, TArray<int32>& OutWoken);
+
+    // Append the slots subscribed to the cell
+    void CollectCellSubscribers(int32 CellIndex, TArray<int32>& OutWoken) const;
+
+    // Append the slots whose attribute crossed its threshold. GetAttribute(
+    // CellIndex, Attribute) returns the current value. With CellIndex set only
+    // the watchers of that cell are checked.
+    template <typename FuncType>
+    void CollectAttributeWakes(FuncType&& GetAttribute, TArray<int32>& OutWoken, int32 CellIndex = INDEX_NONE) const;
+
+    // Memory used by the index, in bytes
+    SIZE_T GetAllocatedSize() const;
+
+private:
+
+    struct FSleepRecord
+    {
+        bool bSleeping = false;
+        uint32 Generation = 0;
+        // cells the item is subscribed to
+        TArray<int32, TInlineAllocator<8>> WatchedCells;
+        bool bWatchAttribute = false;
+        int32 AttributeCell = INDEX_NONE;
+        EGridCellAttribute Attribute = EGridCellAttribute::WaterLevel;
+        float Threshold = 0.0f;
+        bool bWakeWhenAbove = true;
+    };
+
+    struct FTimerEntry
+    {
+        int32 Slot;
+        uint32 Generation;
+        int64 DeadlineTick;
+    };
+
+    TArray<FSleepRecord> Records;
+
+    // Timing wheel, the timers of tick T are in bucket T % WheelSize. Timers
+    // more than a revolution away stay in their bucket until their tick.
+    TArray<FTimerEntry> Buckets[WheelSize];
+    int64 CurrentTick = 0;
+
+    TMap<int32, TArray<int32, TInlineAllocator<2>>> CellSubscribers;
+
+    // Slots of the sleeping items with an attribute condition
+    TArray<int32> AttributeWatchers;
+};
+
+template <typename FuncType>
+void FGridItemSleepIndex::CollectAttributeWakes(FuncType&& GetAttribute, TArray<int32>& OutWoken, int32 CellIndex) const {
+    for (int32 Slot : AttributeWatchers) {
+        const FSleepRecord& Record = Records[Slot];
+        if (CellIndex != INDEX_NONE && Record.AttributeCell != CellIndex) {
+            continue;
+        }
+        const float Value = GetAttribute(Record.AttributeCell, Record.Attribute);
+        if (Record.bWakeWhenAbove ? Value >= Record.Threshold : Value <= Record.Threshold) {
+            OutWoken.Add(Slot);
+        }
+    }
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GridCell.h"
+#include "GridSnapshot.h"
+#include "Tasks/Pipe.h"
+
+class IFileHandle;
+
+// What a journal record changed
+enum class EGridJournalOp : uint8
+{
+    // The grid was reinitialized: Target holds the dimensions, Value the cell
+    // size and CellType the default type
+    Initialize,
+    // An item of class ItemClass was placed with its origin at Cell, rotated
+    // by Value
+    PlaceItem,
+    // The item with its origin at Cell was removed
+    RemoveItem,
+    // The item with its origin at Cell was moved to Target and / or rotated
+    // to Value
+    MoveItem,
+    // The cell at Cell became CellType
+    CellType,
+    // The water level / soil quality of the cell at Cell became Value
+    WaterLevel,
+    SoilQuality,
+};
+
+// One mutation of a grid. Items are identified by their origin cell, which
+// is unique among the items of a grid.
+struct GRIDMANAGER_API FGridJournalRecord
+{
+    EGridJournalOp Op = EGridJournalOp::CellType;
+    FIntPoint Cell{0, 0};
+    FIntPoint Target{0, 0};
+    float Value = 0.0f;
+    EGridCellType CellType = EGridCellType::Ground;
+    FString ItemClass;
+
+    // Only the fields the op uses are written
+    friend FArchive& operator<<(FArchive& Ar, FGridJournalRecord& Record);
+};
+
+// Incremental autosave of a grid, see AGrid::StartJournal. On disk it is a
+// pair of files:
+// - <Base>.gridsnap: a generation number followed by an FGridSnapshot
+// - <Base>.gridjournal: a header with the generation of the snapshot it
+//   applies to, followed by frames of records, each [size][crc][records]
+//
+// The grid appends its mutations on the game thread, they are only encoded
+// into a buffer there. Flush hands the buffer to a background pipe which
+// appends it to the journal file as one frame. Compact hands over a snapshot
+// which the pipe writes next to the current one and swaps in, then it starts
+// a new journal with the new generation. A crash at any point leaves either
+// the old snapshot and its journal or the new snapshot and (at worst) the old
+// journal, which its generation no longer matches. A frame torn by a crash
+// fails its crc and ends the journal.
+class GRIDMANAGER_API FGridJournal
+{
+public:
+
+    static constexpr uint32 Magic = 0x4A445247; // "GRDJ"
+    static constexpr uint32 Version = 1;
+
+    explicit FGridJournal(const FString& InBaseFilename);
+    // Waits for the pending writes
+    ~FGridJournal();
+
+    FGridJournal(const FGridJournal&) = delete;
+    FGridJournal& operator=(const FGridJournal&) = delete;
+
+    static FString GetSnapshotFilename(const FString& BaseFilename) { return BaseFilename + TEXT(".gridsnap"); }
+    static FString GetJournalFilename(const FString& BaseFilename) { return BaseFilename + TEXT(".gridjournal"); }
+
+    const FString& GetBaseFilename() const { return BaseFilename; }
+
+    // Record a mutation, it is written by the next Flush
+    void Append(FGridJournalRecord& Record);
+
+    // Write the records appended since the last flush, in the background
+    void Flush();
+
+    // Flush, then replace the snapshot with this one and start an empty
+    // journal, in the background
+    void Compact(FGridSnapshot&& Snapshot);
+
+    // Block until everything handed to the background writer is on disk
+    void WaitForWrites();
+
+    // Bytes of records appended since the last compaction
+    int64 GetJournalSize() const { return JournalSize; }
+
+    // Read the snapshot and the records of the journal which apply to it.
+    // Returns false if there is no valid snapshot, a missing or outdated
+    // journal only means there are no records.
+    static bool Load(const FString& BaseFilename, FGridSnapshot& OutSnapshot, TArray<FGridJournalRecord>& OutRecords);
+
+private:
+
+    // Background side, only run on the pipe
+    void WriteFrame(const TArray<uint8>& Records);
+    void WriteSnapshot(FGridSnapshot& Snapshot, uint64 NewGeneration);
+
+    FString BaseFilename;
+
+    // Records appended since the last flush
+    TArray<uint8> PendingRecords;
+    int64 JournalSize = 0;
+    // Generation of the last compaction handed to the pipe
+    uint64 Generation = 0;
+
+    // Runs the writes one after the other, in order
+    UE::Tasks::FPipe Pipe{UE_SOURCE_LOCATION};
+
+    // The open journal file, only used on the pipe
+    TUniquePtr<IFileHandle> JournalFile;
+};
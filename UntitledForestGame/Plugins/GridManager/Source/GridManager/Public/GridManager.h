@@ -3,6 +3,15 @@
 #pragma once
 
 #include "Modules/ModuleManager.h"
+#include "Logging/LogMacros.h"
+
+// Log category of the grid manager. Shipping builds compile out everything
+// below Warning, so per-call logging in the hot paths costs nothing there.
+#if UE_BUILD_SHIPPING
+GRIDMANAGER_API DECLARE_LOG_CATEGORY_EXTERN(LogGridManager, Warning, Warning);
+#else
+GRIDMANAGER_API DECLARE_LOG_CATEGORY_EXTERN(LogGridManager, Log, All);
+#endif
 
 class FGridManagerModule : public IModuleInterface
 {
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+// Counters of the work the grids do, so hot paths can be profiled without
+// formatting log strings. Compiled out of shipping builds; print them with the
+// grid.Counters console command.
+#ifndef GRID_MANAGER_COUNTERS
+#define GRID_MANAGER_COUNTERS !UE_BUILD_SHIPPING
+#endif
+
+struct GRIDMANAGER_API FGridManagerCounters
+{
+    enum ECounter : uint8
+    {
+        NeighborQueries,
+        ItemsPlaced,
+        PlacementsRejected,
+        ItemsRemoved,
+        ItemUpdates,
+        ItemUpdateOverruns,
+        PathQueries,
+        FlowFieldBuilds,
+        NumCounters,
+    };
+
+    static void Increment(ECounter Counter, int64 Amount = 1) {
+        Values[Counter].fetch_add(Amount, std::memory_order_relaxed);
+    }
+    static int64 Get(ECounter Counter) { return Values[Counter].load(std::memory_order_relaxed); }
+    static const TCHAR* GetName(ECounter Counter);
+
+    static void Reset();
+
+private:
+
+    static std::atomic<int64> Values[NumCounters];
+};
+
+#if GRID_MANAGER_COUNTERS
+#define GRID_COUNTER_ADD(Counter, Amount) FGridManagerCounters::Increment(FGridManagerCounters::Counter, Amount)
+#else
+#define GRID_COUNTER_ADD(Counter, Amount)
+#endif
+#define GRID_COUNTER_INC(Counter) GRID_COUNTER_ADD(Counter, 1)
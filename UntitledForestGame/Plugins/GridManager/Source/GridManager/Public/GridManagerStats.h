@@ -0,0 +1,48 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+// Stats of the grids, shown with "stat GridManager". The per frame counters
+// complement the lifetime totals of FGridManagerCounters.
+DECLARE_STATS_GROUP(TEXT("GridManager"), STATGROUP_GridManager, STATCAT_Advanced);
+
+// Counted per frame
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Placements"), STAT_GridPlacements, STATGROUP_GridManager, GRIDMANAGER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Occupancy Checks"), STAT_GridOccupancyChecks, STATGROUP_GridManager, GRIDMANAGER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Cells Visited"), STAT_GridCellsVisited, STATGROUP_GridManager, GRIDMANAGER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Neighbor Queries"), STAT_GridNeighborQueries, STATGROUP_GridManager, GRIDMANAGER_API);
+
+// Totals over all the grids, refreshed by every grid's tick
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Live Cell Objects"), STAT_GridLiveCellObjects, STATGROUP_GridManager, GRIDMANAGER_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Grid Memory"), STAT_GridMemory, STATGROUP_GridManager, GRIDMANAGER_API);
+
+// Timed scopes
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Initialize Grid"), STAT_GridInitialize, STATGROUP_GridManager, GRIDMANAGER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Place Items"), STAT_GridPlaceItems, STATGROUP_GridManager, GRIDMANAGER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Remove Items"), STAT_GridRemoveItems, STATGROUP_GridManager, GRIDMANAGER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Set Placement"), STAT_GridSetPlacement, STATGROUP_GridManager, GRIDMANAGER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Occupancy Checks"), STAT_GridCheckCells, STATGROUP_GridManager, GRIDMANAGER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Placement Search"), STAT_GridPlacementSearch, STATGROUP_GridManager, GRIDMANAGER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Neighbor Queries"), STAT_GridNeighbors, STATGROUP_GridManager, GRIDMANAGER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Items"), STAT_GridUpdateItems, STATGROUP_GridManager, GRIDMANAGER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Attribute Simulation"), STAT_GridAttributeSimulation, STATGROUP_GridManager, GRIDMANAGER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Pathfinding"), STAT_GridPathfinding, STATGROUP_GridManager, GRIDMANAGER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Snapshots"), STAT_GridSnapshots, STATGROUP_GridManager, GRIDMANAGER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Journal"), STAT_GridJournal, STATGROUP_GridManager, GRIDMANAGER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Debug Drawing"), STAT_GridDebugDrawing, STATGROUP_GridManager, GRIDMANAGER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("World Lookups"), STAT_GridWorldLookups, STATGROUP_GridManager, GRIDMANAGER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Query Snapshots"), STAT_GridQuerySnapshots, STATGROUP_GridManager, GRIDMANAGER_API);
+
+// The per frame cost of the grids in CSV profiles
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(GRIDMANAGER_API, GridManager);
+
+// Time the scope under the stat. Cycle counters also show up in Insights, and
+// builds without stats (Test) still get a named Insights event.
+#if STATS
+#define GRID_SCOPE_CYCLE_COUNTER(Stat) SCOPE_CYCLE_COUNTER(Stat)
+#else
+#define GRID_SCOPE_CYCLE_COUNTER(Stat) TRACE_CPUPROFILER_EVENT_SCOPE(Stat)
+#endif
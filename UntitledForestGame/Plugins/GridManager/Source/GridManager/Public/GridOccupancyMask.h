@@ -0,0 +1,55 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Packed occupancy bitmask of a grid: one bit per cell, set when the cell is
+// occupied. Each row starts on a 64-bit word boundary, so testing whether a
+// WxH footprint is free takes H masked word tests (plus the whole words in
+// between for wide footprints) instead of W*H cell lookups.
+//
+// This is derived data: the grid rebuilds it from its cell storage and keeps it
+// up to date whenever a cell's occupant changes.
+struct GRIDMANAGER_API FGridOccupancyMask
+{
+public:
+
+    // (Re)allocate the mask for the given dimensions with every cell free
+    void Init(int32 InWidth, int32 InHeight);
+
+    // Release all of the storage
+    void Empty();
+
+    int32 GetWidth() const { return Width; }
+    int32 GetHeight() const { return Height; }
+
+    bool Get(int32 X, int32 Y) const;
+    void Set(int32 X, int32 Y, bool bOccupied);
+
+    // Set every cell of [X, X+W) x [Y, Y+H), which must lie within the mask
+    void SetRect(int32 X, int32 Y, int32 W, int32 H, bool bOccupied);
+
+    // Returns true if none of the cells in [X, X+W) x [Y, Y+H) is occupied. The
+    // rectangle must lie within the mask.
+    bool IsRectFree(int32 X, int32 Y, int32 W, int32 H) const;
+
+    // Same as above, but the cells inside Ignore count as free (e.g. the cells
+    // of the item that is being moved or rotated)
+    bool IsRectFree(int32 X, int32 Y, int32 W, int32 H, const FIntRect& Ignore) const;
+
+    // Memory used by the mask, in bytes
+    SIZE_T GetAllocatedSize() const { return Words.GetAllocatedSize(); }
+
+private:
+
+    // Bits of the column range [Begin, End) that fall in the given word of a row
+    static uint64 WordRangeMask(int32 WordIndex, int32 Begin, int32 End);
+
+    // Returns true if any bit is set in the Num whole words
+    static bool AnyBitSet(const uint64* RowWords, int32 Num);
+
+    int32 Width = 0;
+    int32 Height = 0;
+    int32 WordsPerRow = 0;
+
+    TArray<uint64> Words;
+};
@@ -0,0 +1,210 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GridOccupancyMask.h"
+#include "GridPathfinding.generated.h"
+
+// Search used by FGridPathfinder::FindPath
+UENUM(BlueprintType)
+enum class EGridPathAlgorithm : uint8
+{
+    // Plain A*, expands every cell on the way
+    AStar,
+    // Jump point search: A* which skips over the runs of open cells, much
+    // faster on open ground. Finds paths of the same length as AStar.
+    JumpPoint,
+};
+
+// Shared paths of all the agents heading to one target cell: the cost of the
+// shortest path from every cell to the target, and the direction of the first
+// step of that path.
+struct GRIDMANAGER_API FGridFlowField
+{
+public:
+
+    static constexpr uint32 Unreachable = MAX_uint32;
+    static constexpr uint8 NoDirection = 0xFF;
+
+    FIntPoint GetTarget() const { return Target; }
+
+    // Can the target be reached from the cell, the cell must be on the grid
+    bool IsReachable(const FIntPoint& Cell) const { return Costs[Cell.Y * Width + Cell.X] != Unreachable; }
+
+    // Cost of the shortest path from the cell to the target (10 per straight
+    // step, 14 per diagonal one), Unreachable if there is none
+    uint32 GetCost(const FIntPoint& Cell) const { return Costs[Cell.Y * Width + Cell.X]; }
+
+    // Next cell on the way to the target, false if the cell is the target or
+    // the target can't be reached from it
+    bool GetNextCell(const FIntPoint& Cell, FIntPoint& OutNextCell) const;
+
+private:
+
+    friend struct FGridPathfinder;
+
+    FIntPoint Target{0, 0};
+    int32 Width = 0;
+    TArray<uint32> Costs;
+    // Index into FGridPathfinder's neighbor offsets of the step to take
+    TArray<uint8> Directions;
+    // A cell changed in a way which may change the paths, the field is
+    // recomputed the next time it is used
+    bool bStale = false;
+    uint64 LastUsed = 0;
+};
+
+// Pathfinding over the walkable cells of a grid, for agents moving in 8
+// directions. Diagonal steps never cut a corner: both cells beside the step
+// must be walkable too.
+//
+// The walkable cells are kept in a bitmap. The grid marks the cells it changes
+// dirty, the next query re-reads only those, and only the flow fields a
+// changed cell can affect are recomputed (lazily, when they are next used).
+struct GRIDMANAGER_API FGridPathfinder
+{
+public:
+
+    static constexpr uint32 StraightCost = 10;
+    static constexpr uint32 DiagonalCost = 14;
+
+    // Flow fields kept around, the least recently used one is replaced
+    static constexpr int32 MaxFlowFields = 8;
+
+    // (Re)allocate for the given dimensions, fully dirty
+    void Init(int32 InWidth, int32 InHeight);
+
+    // Release all of the storage
+    void Empty();
+
+    // The walkability of the cell at (X, Y) may have changed
+    void MarkDirty(int32 X, int32 Y);
+    void MarkAllDirty() { bAllDirty = true; DirtyCells.Reset(); }
+
+    // Re-read the dirty cells. IsBlocked(X, Y) returns whether the cell is
+    // blocked.
+    template <typename FuncType>
+    void Update(FuncType&& IsBlocked);
+
+    // Is the cell on the grid and walkable, the pathfinder must be up to date
+    bool IsWalkable(int32 X, int32 Y) const {
+        return X >= 0 && X < Width && Y >= 0 && Y < Height && !Blocked.Get(X, Y);
+    }
+
+    // Find a shortest path from Start to Goal, both included. The start cell
+    // may be blocked (the agent is standing there), the goal must be walkable.
+    // Returns false if there is no path.
+    bool FindPath(const FIntPoint& Start, const FIntPoint& Goal, EGridPathAlgorithm Algorithm, TArray<FIntPoint>& OutPath);
+
+    // The flow field towards the target, computed if it isn't cached (or is
+    // stale). nullptr if the target is not walkable. The field stays valid
+    // until the next call.
+    const FGridFlowField* GetFlowField(const FIntPoint& Target);
+
+    // Memory used by the pathfinder, in bytes
+    SIZE_T GetAllocatedSize() const;
+
+    // The 8 steps indexed by direction: straight ones first, each followed by
+    // its opposite
+    static const FIntPoint NeighborOffsets[8];
+
+private:
+
+    // Can an agent step from the cell in the direction, i.e. the cell it
+    // steps to is walkable and, for diagonal steps, so are both cells beside
+    // the step
+    bool CanStep(int32 X, int32 Y, int32 DX, int32 DY) const {
+        if (!IsWalkable(X + DX, Y + DY)) {
+            return false;
+        }
+        return DX == 0 || DY == 0 || (IsWalkable(X + DX, Y) && IsWalkable(X, Y + DY));
+    }
+
+    static uint32 OctileDistance(const FIntPoint& A, const FIntPoint& B) {
+        const int32 DX = FMath::Abs(A.X - B.X);
+        const int32 DY = FMath::Abs(A.Y - B.Y);
+        return StraightCost * FMath::Max(DX, DY) + (DiagonalCost - StraightCost) * FMath::Min(DX, DY);
+    }
+
+    bool FindPathAStar(const FIntPoint& Start, const FIntPoint& Goal, TArray<FIntPoint>& OutPath);
+    bool FindPathJumpPoint(const FIntPoint& Start, const FIntPoint& Goal, TArray<FIntPoint>& OutPath);
+
+    // Jump from the cell in the direction, returns false if the jump runs into
+    // a wall before it finds a jump point
+    bool JumpStraight(int32 X, int32 Y, int32 DX, int32 DY, const FIntPoint& Goal, FIntPoint& OutJumpPoint) const;
+    bool Jump(int32 X, int32 Y, int32 DX, int32 DY, const FIntPoint& Goal, FIntPoint& OutJumpPoint) const;
+
+    // Start a search: the scratch cells from earlier searches become unvisited
+    void BeginSearch();
+    bool IsVisited(int32 Index) const { return SearchStamps[Index] == SearchStamp; }
+    // Record a cost and parent for the cell, returns false if it already had a
+    // lower one
+    bool Relax(int32 Index, uint32 Cost, int32 Parent);
+    // Walk the parents back from the goal, joining the straight / diagonal
+    // runs between jump points
+    void BuildPath(int32 GoalIndex, TArray<FIntPoint>& OutPath) const;
+
+    void ComputeFlowField(FGridFlowField& Field) const;
+    // Does the change of the cell's walkability affect the field
+    bool AffectsFlowField(const FGridFlowField& Field, int32 X, int32 Y, bool bNowBlocked) const;
+    void OnCellChanged(int32 X, int32 Y, bool bNowBlocked);
+
+    int32 Width = 0;
+    int32 Height = 0;
+
+    // One bit per cell, set when the cell can't be walked on
+    FGridOccupancyMask Blocked;
+
+    // Cells to re-read on the next update. Past a point it is cheaper to
+    // re-read everything.
+    TArray<int32> DirtyCells;
+    bool bAllDirty = true;
+
+    TArray<FGridFlowField> FlowFields;
+    uint64 FlowFieldUseCount = 0;
+
+    // Search scratch. A cell's cost and parent are only meaningful if its
+    // stamp is the current search's.
+    struct FOpenNode
+    {
+        uint32 Estimate;
+        uint32 Cost;
+        int32 Index;
+    };
+    TArray<FOpenNode> OpenNodes;
+    TArray<uint32> Costs;
+    TArray<int32> Parents;
+    TArray<uint32> SearchStamps;
+    uint32 SearchStamp = 0;
+};
+
+template <typename FuncType>
+void FGridPathfinder::Update(FuncType&& IsBlocked) {
+    if (bAllDirty) {
+        Blocked.Init(Width, Height);
+        for (int32 y = 0; y < Height; ++y) {
+            for (int32 x = 0; x < Width; ++x) {
+                if (IsBlocked(x, y)) {
+                    Blocked.Set(x, y, true);
+                }
+            }
+        }
+        for (FGridFlowField& Field : FlowFields) {
+            Field.bStale = true;
+        }
+        bAllDirty = false;
+        DirtyCells.Reset();
+        return;
+    }
+
+    for (int32 Index : DirtyCells) {
+        const int32 x = Index % Width;
+        const int32 y = Index / Width;
+        const bool bNowBlocked = IsBlocked(x, y);
+        // a cell changed back and forth, or changed twice
+        if (Blocked.Get(x, y) != bNowBlocked) {
+            Blocked.Set(x, y, bNowBlocked);
+            OnCellChanged(x, y, bNowBlocked);
+        }
+    }
+    DirtyCells.Reset();
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GridCell.h"
+#include "GridOccupancyMask.h"
+
+// Read-only copy of what the placement, conversion and neighbor queries of a
+// grid need: its occupancy, the cell types (with the static layer applied) and
+// its transform. The grid publishes a new one at most once per frame, from the
+// game thread, see AGrid::GetQuerySnapshot.
+//
+// A snapshot never changes once published, so any thread can query it without
+// locking while the game thread keeps changing the grid. It shows the grid as
+// it was when it was published: a worker's answers can be up to a frame old,
+// and whatever it decides has to be checked again against the live grid when
+// it is applied on the game thread.
+//
+// The occupancy and the cell types are shared between snapshots until they
+// change, so a frame in which only items moved copies only the occupancy bits.
+struct GRIDMANAGER_API FGridQuerySnapshot
+{
+public:
+
+    // Increases with every snapshot of the grid
+    uint64 GetVersion() const { return Version; }
+
+    int32 GetWidth() const { return Width; }
+    int32 GetHeight() const { return Height; }
+    float GetCellSize() const { return CellSize; }
+
+    bool IsCellValid(int32 X, int32 Y) const { return X >= 0 && X < Width && Y >= 0 && Y < Height; }
+
+    // Type of the cell, Unusable if it is not on the grid
+    EGridCellType GetCellType(int32 X, int32 Y) const;
+
+    // Is the cell occupied by an item, the cell must be valid
+    bool IsCellOccupied(const FIntPoint& Cell) const { return Occupancy->Get(Cell.X, Cell.Y); }
+
+    // Same as AGrid::CheckIfCellsAreFree without an item
+    bool CheckIfCellsAreFree(const FVector2D& GridPosition, const FVector2D& ItemSize) const;
+
+    // Same as AGrid::GridToWorld / AGrid::WorldToGrid
+    FVector GridToWorld(const FVector2D& GridPosition) const;
+    FVector2D WorldToGrid(const FVector& WorldPosition) const;
+
+    // Same as AGrid::GetNeighborCellIndices, in the same order
+    int32 GetNeighborCellIndices(const FIntPoint& Cell, TArrayView<int32> OutIndices, bool IncludeOccupied = false) const;
+
+    // Same as above, as cell positions
+    int32 GetNeighborCells(const FIntPoint& Cell, TArrayView<FIntPoint> OutCells, bool IncludeOccupied = false) const;
+
+    // Memory used by the occupancy and the cell types, in bytes. Parts shared
+    // with other snapshots are counted by each of them.
+    SIZE_T GetAllocatedSize() const;
+
+private:
+
+    friend class AGrid;
+
+    uint64 Version = 0;
+    int32 Width = 0;
+    int32 Height = 0;
+    float CellSize = 0.0f;
+
+    FQuat GridRotation{FQuat::Identity};
+    FVector GridLocation{FVector::ZeroVector};
+    FMatrix WorldToLocal{FMatrix::Identity};
+    // The grid's TransformVersion this was taken at
+    uint32 TransformVersion = 0;
+
+    // Shared with the snapshots before and after this one for as long as they
+    // don't change
+    TSharedPtr<const FGridOccupancyMask, ESPMode::ThreadSafe> Occupancy;
+    TSharedPtr<const TArray<EGridCellType>, ESPMode::ThreadSafe> CellTypes;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GridCell.h"
+
+// An item of a grid snapshot
+struct GRIDMANAGER_API FGridSnapshotItem
+{
+    // Index into FGridSnapshot::ItemClasses
+    int32 ClassIndex = INDEX_NONE;
+    FIntPoint Position{0, 0};
+    float Rotation = 0.0f;
+};
+
+// Compact binary snapshot of the state of an AGrid, see AGrid::SaveSnapshot:
+// - the cell types, packed 4 cells per byte
+// - the simulated attributes as raw columns of floats
+// - the items, as a table of (class, position, rotation) with the classes
+//   stored once
+// - which item occupies each cell, run-length encoded in cell index order
+//
+// Every column is written in one go, and a restore writes the cells directly
+// instead of placing the items one by one.
+struct GRIDMANAGER_API FGridSnapshot
+{
+public:
+
+    static constexpr uint32 Magic = 0x53445247; // "GRDS"
+    static constexpr uint32 Version = 1;
+
+    int32 Width = 0;
+    int32 Height = 0;
+    float CellSize = 100.0f;
+    EGridCellType DefaultType = EGridCellType::Ground;
+
+    // Empty if the grid had no simulated attributes
+    TArray<float> WaterLevels;
+    TArray<float> SoilQualities;
+
+    // Paths of the item classes
+    TArray<FString> ItemClasses;
+    TArray<FGridSnapshotItem> Items;
+
+    int32 NumCells() const { return Width * Height; }
+
+    // Allocate the cell columns for the dimensions: every cell of the
+    // default type and free
+    void InitCells();
+
+    EGridCellType GetCellType(int32 Index) const {
+        return EGridCellType((PackedTypes[Index >> 2] >> ((Index & 3) * 2)) & 3);
+    }
+    void SetCellType(int32 Index, EGridCellType Type) {
+        const int32 Shift = (Index & 3) * 2;
+        PackedTypes[Index >> 2] = uint8((PackedTypes[Index >> 2] & ~(3 << Shift)) | ((uint8(Type) & 3) << Shift));
+    }
+
+    // Run-length encode the occupancy: the index into Items of the item
+    // occupying each cell, INDEX_NONE for free cells
+    void SetOccupancy(TConstArrayView<int32> CellItems);
+
+    // Call Func(FirstCellIndex, NumCells, ItemIndex) for every run of cells
+    // occupied by the same item
+    template <typename FuncType>
+    void ForEachOccupiedRun(FuncType&& Func) const;
+
+    // Read or write the snapshot. Returns false if the data is not a valid
+    // snapshot.
+    bool Serialize(FArchive& Ar);
+
+private:
+
+    // 2 bits per cell
+    TArray<uint8> PackedTypes;
+
+    // (ItemIndex, NumCells) pairs covering every cell in order
+    TArray<int32> OccupancyRuns;
+};
+
+template <typename FuncType>
+void FGridSnapshot::ForEachOccupiedRun(FuncType&& Func) const {
+    int32 Cell = 0;
+    for (int32 i = 0; i + 1 < OccupancyRuns.Num(); i += 2) {
+        const int32 Item = OccupancyRuns[i];
+        const int32 Length = OccupancyRuns[i + 1];
+        if (Item != INDEX_NONE) {
+            Func(Cell, Length, Item);
+        }
+        Cell += Length;
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+// Authored, read-only data of the cells of a grid, which never changes at
+// runtime: the ground type (row of the ground type table), the base soil
+// quality and the cells which can't be used.
+//
+// The data is cooked into a column file per grid and memory-mapped, the grid
+// reads it in place. Nothing is copied, the OS pages the columns in as they
+// are read and can drop them again under memory pressure, so only the
+// runtime-mutable layer (FGridCellStore, FGridAttributeField) takes up memory.
+// Mapping needs the file to be loose on disk: stage the directory of the
+// column files with DirectoriesToAlwaysStageAsNonUFS. Where the file can't be
+// mapped it is read into memory instead.
+//
+// File layout, native endianness:
+// - header: magic, version, width, height, then the offset of each column
+// - ground types: one byte per cell
+// - unusable cells: one bit per cell
+// - base soil quality: one float per cell
+struct GRIDMANAGER_API FGridStaticLayer
+{
+public:
+
+    static constexpr uint32 Magic = 0x4C445247; // "GRDL"
+    static constexpr uint32 Version = 1;
+
+    FGridStaticLayer();
+    ~FGridStaticLayer();
+
+    FGridStaticLayer(const FGridStaticLayer&) = delete;
+    FGridStaticLayer& operator=(const FGridStaticLayer&) = delete;
+
+    // Map the column file. Returns false (leaving the layer unmapped) if the
+    // file is missing or not a valid column file.
+    bool Map(const FString& Filename);
+    void Unmap();
+
+    bool IsMapped() const { return Data != nullptr; }
+    const FString& GetFilename() const { return Filename; }
+    int32 GetWidth() const { return Width; }
+    int32 GetHeight() const { return Height; }
+
+    // The layer must be mapped and the index valid
+    uint8 GetGroundType(int32 Index) const { return GroundTypes[Index]; }
+    bool IsUnusable(int32 Index) const { return (UnusableBits[Index >> 3] >> (Index & 7)) & 1; }
+    float GetBaseSoilQuality(int32 Index) const { return BaseSoilQualities[Index]; }
+
+    // Cook a column file. UnusableCells has one bit per cell, packed 8 cells
+    // per byte.
+    static bool Write(const FString& Filename, int32 Width, int32 Height, TConstArrayView<uint8> GroundTypes, TConstArrayView<uint8> UnusableCells,
+        TConstArrayView<float> BaseSoilQualities);
+
+private:
+
+    struct FHeader
+    {
+        uint32 Magic;
+        uint32 Version;
+        int32 Width;
+        int32 Height;
+        uint64 GroundTypesOffset;
+        uint64 UnusableOffset;
+        uint64 BaseSoilOffset;
+    };
+
+    // Point the columns into the file's data, checking that they fit
+    bool BindColumns(const uint8* FileData, int64 FileSize);
+
+    FString Filename;
+    int32 Width = 0;
+    int32 Height = 0;
+
+    TUniquePtr<IMappedFileHandle> MappedFile;
+    TUniquePtr<IMappedFileRegion> MappedRegion;
+    // The file's data, where it can't be mapped
+    TArray64<uint8> LoadedData;
+
+    // Start of the file and of each column, nullptr while unmapped
+    const uint8* Data = nullptr;
+    const uint8* GroundTypes = nullptr;
+    const uint8* UnusableBits = nullptr;
+    const float* BaseSoilQualities = nullptr;
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Summed-area table over the blocked cells of a grid. Entry (X, Y) holds the
+// number of blocked cells in [0, X) x [0, Y), so the number of blocked cells in
+// any rectangle is four lookups, whatever the size of the rectangle.
+//
+// A change to cell (X, Y) only affects the entries below and to the right of
+// it, so changes just move the dirty corner and the table recomputes that
+// region the next time it is queried.
+struct GRIDMANAGER_API FGridSummedAreaTable
+{
+public:
+
+    // (Re)allocate the table for the given dimensions, fully dirty
+    void Init(int32 InWidth, int32 InHeight);
+
+    // Release all of the storage
+    void Empty();
+
+    // The cell at (X, Y) changed
+    void MarkDirty(int32 X, int32 Y);
+    void MarkAllDirty() { DirtyMin = FIntPoint::ZeroValue; }
+    bool IsDirty() const { return DirtyMin.X < Width && DirtyMin.Y < Height; }
+
+    // Recompute the dirty region. IsBlocked(X, Y) returns whether the cell is
+    // blocked.
+    template <typename FuncType>
+    void Update(FuncType&& IsBlocked);
+
+    // Number of blocked cells in [X, X+W) x [Y, Y+H). The table must be up to
+    // date and the rectangle must lie within the grid.
+    int32 CountInRect(int32 X, int32 Y, int32 W, int32 H) const {
+        const int32 Stride = Width + 1;
+        return Sums[(Y + H) * Stride + X + W] - Sums[Y * Stride + X + W] - Sums[(Y + H) * Stride + X] + Sums[Y * Stride + X];
+    }
+
+    // Memory used by the table, in bytes
+    SIZE_T GetAllocatedSize() const { return Sums.GetAllocatedSize(); }
+
+private:
+
+    int32 Width = 0;
+    int32 Height = 0;
+
+    // Top left corner of the region that needs to be recomputed, clean when it
+    // is outside of the grid
+    FIntPoint DirtyMin{MAX_int32, MAX_int32};
+
+    // (Width + 1) x (Height + 1) entries, the first row and column are zero
+    TArray<int32> Sums;
+};
+
+template <typename FuncType>
+void FGridSummedAreaTable::Update(FuncType&& IsBlocked) {
+    if (!IsDirty()) {
+        return;
+    }
+    if (Sums.Num() != (Width + 1) * (Height + 1)) {
+        Sums.Init(0, (Width + 1) * (Height + 1));
+        DirtyMin = FIntPoint::ZeroValue;
+    }
+
+    const int32 Stride = Width + 1;
+    const int32 StartX = FMath::Max(DirtyMin.X, 0);
+    for (int32 y = FMath::Max(DirtyMin.Y, 0); y < Height; ++y) {
+        int32* Row = &Sums[(y + 1) * Stride];
+        const int32* Above = &Sums[y * Stride];
+        // blocked cells of this row left of the dirty region
+        int32 RowSum = Row[StartX] - Above[StartX];
+        for (int32 x = StartX; x < Width; ++x) {
+            RowSum += IsBlocked(x, y) ? 1 : 0;
+            Row[x + 1] = Above[x + 1] + RowSum;
+        }
+    }
+    DirtyMin = FIntPoint(MAX_int32, MAX_int32);
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GridWorldSubsystem.generated.h"
+
+class AGrid;
+class UGridCell;
+
+// Index of all the grids of a world, to find the grid (and cell) at a world
+// position without knowing which grid to ask.
+//
+// The grids keep their entry up to date themselves: they register when their
+// components are registered and update their entry whenever they move or are
+// resized. The world space bounds of every grid are hashed into a uniform 2D
+// (world X / Y) hash of BucketSize buckets, so a lookup only tests the few
+// grids whose bounds overlap the bucket of the position.
+UCLASS()
+class GRIDMANAGER_API UGridWorldSubsystem : public UWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+
+    // Size of the hash buckets in cm
+    static constexpr float BucketSize = 2000.0f;
+
+    // Grids covering more buckets than this are tested on every lookup
+    // instead of being hashed
+    static constexpr int32 MaxBucketsPerGrid = 1024;
+
+    virtual void PostInitialize() override;
+    virtual void Deinitialize() override;
+
+    // Add the grid to the index or refresh its entry after it moved or was
+    // resized
+    void UpdateGrid(AGrid* Grid);
+    void RemoveGrid(const AGrid* Grid);
+
+    // Find the grid the world position is on, and the cell of that grid.
+    // Where grids overlap, the one whose plane is closest below the position
+    // wins. Returns nullptr if the position is not on any grid.
+    AGrid* FindGridAt(const FVector& WorldPosition, FIntPoint& OutCell) const;
+
+    // Find the grid the world position is on, and the grid position of the
+    // cell. Returns false if the position is not on any grid.
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    bool ResolveWorldPosition(const FVector& WorldPosition, AGrid*& OutGrid, FVector2D& OutGridPosition) const;
+
+    // Get the cell at the world position, of whichever grid it is on
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    UGridCell* GetCellAtWorldPosition(const FVector& WorldPosition) const;
+
+    // All the grids of the world, in no particular order
+    UFUNCTION(BlueprintCallable, Category = "Grid")
+    TArray<AGrid*> GetGrids() const;
+
+private:
+
+    struct FIndexedGrid
+    {
+        TWeakObjectPtr<AGrid> Grid;
+        // World space to cell units, cell (X, Y) is centered on (X, Y, 0) and
+        // the grid extends one cell up from its plane
+        FMatrix WorldToCell;
+        int32 Width = 0;
+        int32 Height = 0;
+        // Buckets the entry is in (Max inclusive), unused for large grids
+        FIntRect Buckets;
+        bool bLarge = false;
+    };
+
+    // Does the entry contain the position, and how high above its plane it is
+    static bool ResolveInEntry(const FIndexedGrid& Entry, const FVector& WorldPosition, FIntPoint& OutCell, double& OutHeight);
+
+    static FIntPoint GetBucket(const FVector& WorldPosition) {
+        return FIntPoint(FMath::FloorToInt(WorldPosition.X / BucketSize), FMath::FloorToInt(WorldPosition.Y / BucketSize));
+    }
+
+    void AddToBuckets(int32 EntryIndex);
+    void RemoveFromBuckets(int32 EntryIndex);
+
+    TSparseArray<FIndexedGrid> Entries;
+    TMap<TObjectKey<AGrid>, int32> EntryIndices;
+
+    // Entries overlapping each bucket
+    TMap<FIntPoint, TArray<int32>> Buckets;
+    // Entries too large to hash
+    TArray<int32> LargeEntries;
+};
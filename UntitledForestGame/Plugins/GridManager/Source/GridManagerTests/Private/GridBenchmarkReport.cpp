@@ -0,0 +1,99 @@
+#include "GridBenchmarkReport.h"
+#include "GridManager.h"
+#include "Dom/JsonObject.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+// Percentiles in the report
+static const double ReportedPercentiles[] = {50.0, 90.0, 99.0};
+
+double FGridBenchmarkResult::GetPercentile(double Percentile) const {
+  if (NanosecondsPerOperation.Num() == 0) {
+    return 0.0;
+  }
+  TArray<double> Sorted = NanosecondsPerOperation;
+  Sorted.Sort();
+  const int32 Rank = FMath::CeilToInt(Percentile / 100.0 * Sorted.Num());
+  return Sorted[FMath::Clamp(Rank - 1, 0, Sorted.Num() - 1)];
+}
+
+double FGridBenchmarkResult::GetMean() const {
+  double Sum = 0.0;
+  for (double Value : NanosecondsPerOperation) {
+    Sum += Value;
+  }
+  return NanosecondsPerOperation.Num() > 0 ? Sum / NanosecondsPerOperation.Num() : 0.0;
+}
+
+FGridBenchmarkReport& FGridBenchmarkReport::Get() {
+  static FGridBenchmarkReport Report;
+  return Report;
+}
+
+void FGridBenchmarkReport::Add(FGridBenchmarkResult&& Result) {
+  UE_LOG(LogGridManager, Display, TEXT("Benchmark %s: p50 %.1f ns, p90 %.1f ns, p99 %.1f ns per operation"), *Result.Name, Result.GetPercentile(50.0),
+    Result.GetPercentile(90.0), Result.GetPercentile(99.0));
+
+  const int32 Existing = Results.IndexOfByPredicate([&Result](const FGridBenchmarkResult& Other) { return Other.Name == Result.Name; });
+  if (Existing != INDEX_NONE) {
+    Results[Existing] = MoveTemp(Result);
+  } else {
+    Results.Add(MoveTemp(Result));
+  }
+  Write();
+}
+
+FString FGridBenchmarkReport::GetOutputBase() const {
+  FString OutputBase;
+  if (FParse::Value(FCommandLine::Get(), TEXT("GridBenchmarkOutput="), OutputBase)) {
+    return OutputBase;
+  }
+  return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Automation"), TEXT("GridBenchmarks"));
+}
+
+void FGridBenchmarkReport::Write() const {
+  const FString OutputBase = GetOutputBase();
+
+  // JSON: one object per benchmark, with the raw samples so runs can be
+  // compared with other statistics later
+  TArray<TSharedPtr<FJsonValue>> JsonResults;
+  FString Csv = TEXT("name,samples,operations_per_sample,min_ns,mean_ns,p50_ns,p90_ns,p99_ns,max_ns\n");
+  for (const FGridBenchmarkResult& Result : Results) {
+    TSharedRef<FJsonObject> JsonResult = MakeShared<FJsonObject>();
+    JsonResult->SetStringField(TEXT("name"), Result.Name);
+    JsonResult->SetNumberField(TEXT("samples"), Result.NanosecondsPerOperation.Num());
+    JsonResult->SetNumberField(TEXT("operations_per_sample"), Result.OperationsPerSample);
+    JsonResult->SetNumberField(TEXT("min_ns"), Result.GetPercentile(0.0));
+    JsonResult->SetNumberField(TEXT("mean_ns"), Result.GetMean());
+    for (double Percentile : ReportedPercentiles) {
+      JsonResult->SetNumberField(FString::Printf(TEXT("p%d_ns"), int32(Percentile)), Result.GetPercentile(Percentile));
+    }
+    JsonResult->SetNumberField(TEXT("max_ns"), Result.GetPercentile(100.0));
+    TArray<TSharedPtr<FJsonValue>> Samples;
+    for (double Value : Result.NanosecondsPerOperation) {
+      Samples.Add(MakeShared<FJsonValueNumber>(Value));
+    }
+    JsonResult->SetArrayField(TEXT("samples_ns"), Samples);
+    JsonResults.Add(MakeShared<FJsonValueObject>(JsonResult));
+
+    Csv += FString::Printf(TEXT("%s,%d,%d,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f\n"), *Result.Name, Result.NanosecondsPerOperation.Num(), Result.OperationsPerSample,
+      Result.GetPercentile(0.0), Result.GetMean(), Result.GetPercentile(50.0), Result.GetPercentile(90.0), Result.GetPercentile(99.0),
+      Result.GetPercentile(100.0));
+  }
+
+  TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+  Root->SetStringField(TEXT("build"), FString::Printf(TEXT("%s %s"), FPlatformProperties::PlatformName(), LexToString(FApp::GetBuildConfiguration())));
+  Root->SetStringField(TEXT("time"), FDateTime::UtcNow().ToIso8601());
+  Root->SetArrayField(TEXT("benchmarks"), JsonResults);
+  FString Json;
+  TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+  FJsonSerializer::Serialize(Root, Writer);
+
+  if (!FFileHelper::SaveStringToFile(Json, *(OutputBase + TEXT(".json"))) || !FFileHelper::SaveStringToFile(Csv, *(OutputBase + TEXT(".csv")))) {
+    UE_LOG(LogGridManager, Warning, TEXT("Could not write the benchmark report %s"), *OutputBase);
+  }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Timings of one benchmark: every sample is the time one batch of operations
+// took, divided by the operations in the batch
+struct FGridBenchmarkResult
+{
+    FString Name;
+    int32 OperationsPerSample = 1;
+    TArray<double> NanosecondsPerOperation;
+
+    // Nearest-rank percentile of the samples, 0 - 100
+    double GetPercentile(double Percentile) const;
+    double GetMean() const;
+};
+
+// Times a batch of operations. Run a few warmup batches first, then Samples
+// timed ones.
+template <typename FuncType>
+FGridBenchmarkResult RunGridBenchmark(const FString& Name, int32 Samples, int32 OperationsPerSample, FuncType&& Batch) {
+    FGridBenchmarkResult Result;
+    Result.Name = Name;
+    Result.OperationsPerSample = OperationsPerSample;
+    Result.NanosecondsPerOperation.Reserve(Samples);
+    for (int32 Warmup = 0; Warmup < FMath::Min(Samples, 3); ++Warmup) {
+        Batch();
+    }
+    for (int32 Sample = 0; Sample < Samples; ++Sample) {
+        const uint64 StartCycles = FPlatformTime::Cycles64();
+        Batch();
+        const double Seconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+        Result.NanosecondsPerOperation.Add(Seconds * 1e9 / OperationsPerSample);
+    }
+    return Result;
+}
+
+// Results of all the benchmarks run by this process, written out after each
+// benchmark as JSON and CSV to Saved/Automation/GridBenchmarks.json / .csv,
+// or to the path given with -GridBenchmarkOutput=<path without extension>.
+class FGridBenchmarkReport
+{
+public:
+
+    static FGridBenchmarkReport& Get();
+
+    // Add (or replace, by name) a result and rewrite the report files
+    void Add(FGridBenchmarkResult&& Result);
+
+    const TArray<FGridBenchmarkResult>& GetResults() const { return Results; }
+
+private:
+
+    void Write() const;
+    FString GetOutputBase() const;
+
+    TArray<FGridBenchmarkResult> Results;
+};
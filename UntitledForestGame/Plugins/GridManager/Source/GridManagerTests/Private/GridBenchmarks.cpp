@@ -0,0 +1,264 @@
+#include "GridBenchmarkReport.h"
+#include "GridTestItem.h"
+#include "GridTestWorld.h"
+#include "Grid.h"
+#include "GridComponent.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/CommandLine.h"
+
+// Benchmarks of the grid hot paths. They run headless, e.g.:
+//
+//   UnrealEditor-Cmd UntitledForestGame.uproject -nullrhi -unattended -nosplash
+//     -ExecCmds="Automation RunTests GridManager.Benchmarks; Quit"
+//     [-GridBenchmarkOutput=<path>] [-GridBenchmarkSamples=<n>]
+//
+// and write their percentiles to the report, see FGridBenchmarkReport.
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+static constexpr EAutomationTestFlags GridBenchmarkFlags = EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::PerfFilter;
+
+// Fixed seed, every run benchmarks the same layouts
+static constexpr int32 GridBenchmarkSeed = 0x6772;
+
+// Timed batches per benchmark, scaled down for the slow ones
+static int32 GetBenchmarkSamples(int32 Divisor = 1) {
+  int32 Samples = 50;
+  FParse::Value(FCommandLine::Get(), TEXT("GridBenchmarkSamples="), Samples);
+  return FMath::Max(1, Samples / Divisor);
+}
+
+// Place items of the given size at random free positions until the given
+// number are placed or there is no room left
+static TArray<AActor*> PlaceRandomItems(FGridTestWorld& TestWorld, AGrid* Grid, int32 NumItems, const FVector2D& Size, FRandomStream& Random) {
+  TArray<AActor*> Items;
+  const int32 MaxAttempts = NumItems * 20;
+  for (int32 Attempt = 0; Attempt < MaxAttempts && Items.Num() < NumItems; ++Attempt) {
+    const FVector2D Position(Random.RandRange(0, Grid->GridWidth - 1), Random.RandRange(0, Grid->GridHeight - 1));
+    if (!Grid->CheckIfCellsAreFree(Position, Size)) {
+      continue;
+    }
+    AActor* Item = TestWorld.SpawnItem(Size);
+    if (Grid->PlaceItemAtGridPosition(Item, Position)) {
+      Items.Add(Item);
+    } else {
+      Item->Destroy();
+    }
+  }
+  return Items;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGridInitializeBenchmark, "GridManager.Benchmarks.InitializeGrid", GridBenchmarkFlags)
+bool FGridInitializeBenchmark::RunTest(const FString& Parameters) {
+  FGridTestWorld TestWorld;
+  for (int32 Size : {64, 256, 1024}) {
+    AGrid* Grid = TestWorld.SpawnGrid(Size, Size);
+    // the big grids take longer per call, fewer samples keep the run short
+    const int32 Samples = GetBenchmarkSamples(Size / 64);
+    FGridBenchmarkReport::Get().Add(RunGridBenchmark(FString::Printf(TEXT("InitializeGrid.%d"), Size), Samples, 1, [Grid]() {
+      Grid->InitializeGrid();
+    }));
+    TestTrue(TEXT("Cells after InitializeGrid"), Grid->GetGridSize() == FVector2D(Size, Size));
+  }
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGridCellsFreeBenchmark, "GridManager.Benchmarks.CheckIfCellsAreFree", GridBenchmarkFlags)
+bool FGridCellsFreeBenchmark::RunTest(const FString& Parameters) {
+  FGridTestWorld TestWorld;
+  FRandomStream Random(GridBenchmarkSeed);
+  AGrid* Grid = TestWorld.SpawnGrid(256, 256);
+  // about a quarter of the cells occupied
+  PlaceRandomItems(TestWorld, Grid, 4096, FVector2D(2, 2), Random);
+
+  constexpr int32 QueriesPerSample = 1000;
+  TArray<FVector2D> Positions;
+  for (int32 i = 0; i < QueriesPerSample; ++i) {
+    Positions.Add(FVector2D(Random.RandRange(0, 253), Random.RandRange(0, 253)));
+  }
+
+  int32 NumFree = 0;
+  for (const FVector2D& ItemSize : {FVector2D(1, 1), FVector2D(3, 3), FVector2D(8, 8)}) {
+    const FString Name = FString::Printf(TEXT("CheckIfCellsAreFree.%dx%d"), int32(ItemSize.X), int32(ItemSize.Y));
+    FGridBenchmarkReport::Get().Add(RunGridBenchmark(Name, GetBenchmarkSamples(), QueriesPerSample, [Grid, &Positions, &ItemSize, &NumFree]() {
+      for (const FVector2D& Position : Positions) {
+        NumFree += Grid->CheckIfCellsAreFree(Position, ItemSize);
+      }
+    }));
+  }
+  TestTrue(TEXT("Some positions are free"), NumFree > 0);
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGridChurnBenchmark, "GridManager.Benchmarks.PlaceRemoveRotate", GridBenchmarkFlags)
+bool FGridChurnBenchmark::RunTest(const FString& Parameters) {
+  FGridTestWorld TestWorld;
+  FRandomStream Random(GridBenchmarkSeed);
+  AGrid* Grid = TestWorld.SpawnGrid(128, 128);
+  TArray<AActor*> Items = PlaceRandomItems(TestWorld, Grid, 1000, FVector2D(1, 2), Random);
+
+  // remove an item and put it back somewhere else, then rotate another: the
+  // mix the plant and building systems produce
+  constexpr int32 OperationsPerSample = 300;
+  int32 Next = 0;
+  int32 NumSucceeded = 0;
+  FGridBenchmarkReport::Get().Add(RunGridBenchmark(TEXT("PlaceRemoveRotate"), GetBenchmarkSamples(), OperationsPerSample, [&]() {
+    for (int32 i = 0; i < OperationsPerSample; i += 3) {
+      AActor* Removed = Items[Next++ % Items.Num()];
+      NumSucceeded += Grid->RemoveItem(Removed);
+      NumSucceeded += Grid->PlaceItemAtGridPosition(Removed, FVector2D(Random.RandRange(0, 127), Random.RandRange(0, 126)));
+
+      AActor* Rotated = Items[Next++ % Items.Num()];
+      const float Rotation = UGridComponent::FindGridComponent(Rotated)->Rotation;
+      NumSucceeded += Grid->RotateItem(Rotated, FMath::Fmod(Rotation + 90.0f, 360.0f));
+    }
+  }));
+  TestTrue(TEXT("Some operations succeeded"), NumSucceeded > 0);
+  return true;
+}
+
+// Placement throughput on items with many components, and the grid component
+// lookup behind it: the registered map AGrid uses against the
+// FindComponentByClass scan it used before
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGridComponentLookupBenchmark, "GridManager.Benchmarks.ComponentLookup", GridBenchmarkFlags)
+bool FGridComponentLookupBenchmark::RunTest(const FString& Parameters) {
+  FGridTestWorld TestWorld;
+  AGrid* Grid = TestWorld.SpawnGrid(64, 64);
+  constexpr int32 NumItems = 256;
+
+  int32 NumSucceeded = 0;
+  for (UClass* ItemClass : {AGridTestItem::StaticClass(), AGridTestClutteredItem::StaticClass()}) {
+    TArray<AActor*> Items;
+    for (int32 i = 0; i < NumItems; ++i) {
+      Items.Add(TestWorld.SpawnItem(FVector2D(1, 1), ItemClass));
+    }
+    const int32 NumComponents = Items[0]->GetComponents().Num();
+
+    // a place and a remove per item, each looks the component up
+    FGridBenchmarkReport::Get().Add(RunGridBenchmark(FString::Printf(TEXT("PlaceRemove.%dComponents"), NumComponents), GetBenchmarkSamples(),
+      NumItems * 2, [&]() {
+        for (int32 i = 0; i < NumItems; ++i) {
+          NumSucceeded += Grid->PlaceItemAtGridPosition(Items[i], FVector2D(i % 64, i / 64));
+        }
+        NumSucceeded += Grid->RemoveItems(Items);
+      }));
+
+    constexpr int32 LookupsPerItem = 16;
+    int32 NumFound = 0;
+    FGridBenchmarkReport::Get().Add(RunGridBenchmark(FString::Printf(TEXT("ComponentLookup.Map.%dComponents"), NumComponents), GetBenchmarkSamples(),
+      NumItems * LookupsPerItem, [&]() {
+        for (int32 Lookup = 0; Lookup < LookupsPerItem; ++Lookup) {
+          for (const AActor* Item : Items) {
+            NumFound += UGridComponent::FindGridComponent(Item) != nullptr;
+          }
+        }
+      }));
+    FGridBenchmarkReport::Get().Add(RunGridBenchmark(FString::Printf(TEXT("ComponentLookup.FindComponentByClass.%dComponents"), NumComponents),
+      GetBenchmarkSamples(), NumItems * LookupsPerItem, [&]() {
+        for (int32 Lookup = 0; Lookup < LookupsPerItem; ++Lookup) {
+          for (const AActor* Item : Items) {
+            NumFound += Item->FindComponentByClass<UGridComponent>() != nullptr;
+          }
+        }
+      }));
+    TestTrue(TEXT("Every lookup finds the component"), NumFound > 0);
+  }
+  TestTrue(TEXT("Placements succeeded"), NumSucceeded > 0);
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGridNeighborBenchmark, "GridManager.Benchmarks.GetNeighborCells", GridBenchmarkFlags)
+bool FGridNeighborBenchmark::RunTest(const FString& Parameters) {
+  FGridTestWorld TestWorld;
+  FRandomStream Random(GridBenchmarkSeed);
+  AGrid* Grid = TestWorld.SpawnGrid(256, 256);
+  TArray<UGridComponent*> Components;
+  for (AActor* Item : PlaceRandomItems(TestWorld, Grid, 500, FVector2D(2, 2), Random)) {
+    Components.Add(UGridComponent::FindGridComponent(Item));
+  }
+
+  int32 NumNeighbors = 0;
+  FGridBenchmarkReport::Get().Add(RunGridBenchmark(TEXT("GetNeighborCells"), GetBenchmarkSamples(), Components.Num(), [&]() {
+    for (const UGridComponent* Component : Components) {
+      NumNeighbors += Component->GetNeighborCells().Num();
+    }
+  }));
+  TestTrue(TEXT("Items have neighbors"), NumNeighbors > 0);
+  return true;
+}
+
+// The cost of logging in the neighbor query hot path: the query as it is now,
+// and with the three formatted lines per call it used to log. They are logged
+// at Log rather than Warning so that the automation framework doesn't collect
+// thousands of test warnings, the formatting and output cost the same.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGridNeighborLoggingBenchmark, "GridManager.Benchmarks.NeighborLogging", GridBenchmarkFlags)
+bool FGridNeighborLoggingBenchmark::RunTest(const FString& Parameters) {
+  FGridTestWorld TestWorld;
+  FRandomStream Random(GridBenchmarkSeed);
+  AGrid* Grid = TestWorld.SpawnGrid(256, 256);
+  TArray<UGridComponent*> Components;
+  for (AActor* Item : PlaceRandomItems(TestWorld, Grid, 100, FVector2D(2, 2), Random)) {
+    Components.Add(UGridComponent::FindGridComponent(Item));
+  }
+
+  // every logged line ends up in the log, keep the batches small
+  const int32 Samples = GetBenchmarkSamples(5);
+  FGridBenchmarkReport::Get().Add(RunGridBenchmark(TEXT("NeighborLogging.Counters"), Samples, Components.Num(), [&]() {
+    for (const UGridComponent* Component : Components) {
+      Component->GetNeighborCells();
+    }
+  }));
+  FGridBenchmarkReport::Get().Add(RunGridBenchmark(TEXT("NeighborLogging.PerCallWarnings"), Samples, Components.Num(), [&]() {
+    for (const UGridComponent* Component : Components) {
+      const FIntRect ItemRect = Component->GetItemRect();
+      UE_LOG(LogTemp, Log, TEXT("GetNeighborCells: %s"), *GetNameSafe(Component->GetOwner()));
+      UE_LOG(LogTemp, Log, TEXT("Position: %s, Size: %s"), *Component->Position.ToString(), *Component->GetRotatedSize().ToString());
+      UE_LOG(LogTemp, Log, TEXT("Perimeter: (%d, %d) - (%d, %d)"), ItemRect.Min.X - 1, ItemRect.Min.Y - 1, ItemRect.Max.X, ItemRect.Max.Y);
+      Component->GetNeighborCells();
+    }
+  }));
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGridConversionBenchmark, "GridManager.Benchmarks.Conversions", GridBenchmarkFlags)
+bool FGridConversionBenchmark::RunTest(const FString& Parameters) {
+  FGridTestWorld TestWorld;
+  FRandomStream Random(GridBenchmarkSeed);
+  AGrid* Grid = TestWorld.SpawnGrid(1024, 1024);
+  // a grid which is neither at the origin nor axis aligned
+  Grid->SetActorLocationAndRotation(FVector(1234.0, -567.0, 89.0), FRotator(0.0, 30.0, 0.0));
+
+  constexpr int32 ConversionsPerSample = 10000;
+  TArray<FVector2D> GridPositions;
+  TArray<FVector> WorldPositions;
+  for (int32 i = 0; i < ConversionsPerSample; ++i) {
+    GridPositions.Add(FVector2D(Random.RandRange(0, 1023), Random.RandRange(0, 1023)));
+    WorldPositions.Add(Grid->GridToWorld(GridPositions.Last()));
+  }
+
+  double Checksum = 0.0;
+  FGridBenchmarkReport::Get().Add(RunGridBenchmark(TEXT("GridToWorld"), GetBenchmarkSamples(), ConversionsPerSample, [&]() {
+    for (const FVector2D& GridPosition : GridPositions) {
+      Checksum += Grid->GridToWorld(GridPosition).X;
+    }
+  }));
+  FGridBenchmarkReport::Get().Add(RunGridBenchmark(TEXT("WorldToGrid"), GetBenchmarkSamples(), ConversionsPerSample, [&]() {
+    for (const FVector& WorldPosition : WorldPositions) {
+      Checksum += Grid->WorldToGrid(WorldPosition).X;
+    }
+  }));
+
+  TArray<FVector> BatchWorldPositions;
+  TArray<FVector2D> BatchGridPositions;
+  FGridBenchmarkReport::Get().Add(RunGridBenchmark(TEXT("GridToWorldBatch"), GetBenchmarkSamples(), ConversionsPerSample, [&]() {
+    Grid->GridToWorldBatch(GridPositions, BatchWorldPositions);
+  }));
+  FGridBenchmarkReport::Get().Add(RunGridBenchmark(TEXT("WorldToGridBatch"), GetBenchmarkSamples(), ConversionsPerSample, [&]() {
+    Grid->WorldToGridBatch(WorldPositions, BatchGridPositions);
+  }));
+  TestTrue(TEXT("Batch round trip"), BatchGridPositions == GridPositions);
+  AddInfo(FString::Printf(TEXT("Checksum %f"), Checksum));
+  return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
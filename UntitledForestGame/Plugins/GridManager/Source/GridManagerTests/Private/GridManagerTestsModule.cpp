@@ -0,0 +1,7 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Modules/ModuleManager.h"
+
+// Automation tests and benchmarks of the grid manager, see GridTests.cpp and
+// GridBenchmarks.cpp
+IMPLEMENT_MODULE(FDefaultModuleImpl, GridManagerTests)
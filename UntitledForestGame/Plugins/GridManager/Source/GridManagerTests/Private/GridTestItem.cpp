@@ -0,0 +1,18 @@
+#include "GridTestItem.h"
+#include "GridComponent.h"
+#include "Components/SceneComponent.h"
+
+AGridTestItem::AGridTestItem() {
+  // the grid moves its items around, they need something to move
+  RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+  GridComponent = CreateDefaultSubobject<UGridComponent>(TEXT("GridComponent"));
+}
+
+AGridTestClutteredItem::AGridTestClutteredItem() {
+  RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+  for (int32 i = 0; i < NumClutterComponents; ++i) {
+    USceneComponent* Clutter = CreateDefaultSubobject<USceneComponent>(*FString::Printf(TEXT("Clutter%d"), i));
+    Clutter->SetupAttachment(RootComponent);
+  }
+  GridComponent = CreateDefaultSubobject<UGridComponent>(TEXT("GridComponent"));
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "GridTestItem.generated.h"
+
+class UGridComponent;
+
+// Minimal grid item of the tests and benchmarks. A native class with its grid
+// component as a default subobject, so that snapshots can respawn it.
+UCLASS(NotBlueprintable)
+class AGridTestItem : public AActor
+{
+    GENERATED_BODY()
+
+public:
+
+    AGridTestItem();
+
+    UPROPERTY()
+    UGridComponent* GridComponent;
+};
+
+// Grid item with many components ahead of its grid component, like the
+// plants and buildings of the game: a FindComponentByClass on it walks all of
+// them before it gets to the grid component.
+UCLASS(NotBlueprintable)
+class AGridTestClutteredItem : public AActor
+{
+    GENERATED_BODY()
+
+public:
+
+    static constexpr int32 NumClutterComponents = 32;
+
+    AGridTestClutteredItem();
+
+    UPROPERTY()
+    UGridComponent* GridComponent;
+};
@@ -0,0 +1,35 @@
+#include "GridTestListener.h"
+#include "Grid.h"
+#include "GridComponent.h"
+
+void UGridTestListener::Listen(AGrid* Grid) {
+  Grid->OnGridReady.AddDynamic(this, &UGridTestListener::HandleGridReady);
+  Grid->OnGridResized.AddDynamic(this, &UGridTestListener::HandleGridResized);
+}
+
+void UGridTestListener::HandleGridReady(AGrid* Grid) {
+  ++NumGridReady;
+}
+
+void UGridTestListener::HandleGridResized(AGrid* Grid, const TArray<AActor*>& EvictedItems) {
+  ++NumGridResized;
+  LastEvictedItems = EvictedItems;
+}
+
+void UGridTestListener::ListenToItem(UGridComponent* GridComponent) {
+  GridComponent->OnPlacedInGrid.AddDynamic(this, &UGridTestListener::HandlePlacedInGrid);
+  GridComponent->OnGridChanged.AddDynamic(this, &UGridTestListener::HandleGridChanged);
+  GridComponent->OnGridPositionRotationChanged.AddDynamic(this, &UGridTestListener::HandlePositionRotationChanged);
+}
+
+void UGridTestListener::HandlePlacedInGrid() {
+  ++NumPlacedInGrid;
+}
+
+void UGridTestListener::HandleGridChanged(AGrid* NewGrid) {
+  ++NumGridChanged;
+}
+
+void UGridTestListener::HandlePositionRotationChanged(FVector2D NewPosition, float NewRotation) {
+  ++NumPositionRotationChanged;
+}
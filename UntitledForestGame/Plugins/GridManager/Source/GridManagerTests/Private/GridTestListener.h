@@ -0,0 +1,49 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "GridTestListener.generated.h"
+
+class AGrid;
+class UGridComponent;
+
+// Records the events a grid broadcasts, for the tests to check. The grid's
+// events are dynamic delegates, which need a UObject to call.
+UCLASS()
+class UGridTestListener : public UObject
+{
+    GENERATED_BODY()
+
+public:
+
+    // Listen to the grid's events
+    void Listen(AGrid* Grid);
+
+    int32 NumGridReady = 0;
+
+    UFUNCTION()
+    void HandleGridReady(AGrid* Grid);
+
+    int32 NumGridResized = 0;
+    TArray<AActor*> LastEvictedItems;
+
+    UFUNCTION()
+    void HandleGridResized(AGrid* Grid, const TArray<AActor*>& EvictedItems);
+
+    // Listen to the events of an item's grid component, the counts are
+    // over all of the items listened to
+    void ListenToItem(UGridComponent* GridComponent);
+
+    int32 NumPlacedInGrid = 0;
+    int32 NumGridChanged = 0;
+    int32 NumPositionRotationChanged = 0;
+
+    UFUNCTION()
+    void HandlePlacedInGrid();
+
+    UFUNCTION()
+    void HandleGridChanged(AGrid* NewGrid);
+
+    UFUNCTION()
+    void HandlePositionRotationChanged(FVector2D NewPosition, float NewRotation);
+};
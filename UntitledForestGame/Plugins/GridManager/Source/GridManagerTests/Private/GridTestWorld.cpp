@@ -0,0 +1,53 @@
+#include "GridTestWorld.h"
+#include "Grid.h"
+#include "GridComponent.h"
+#include "GridTestItem.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Components/SceneComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+
+FGridTestWorld::FGridTestWorld() {
+  World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("GridTestWorld"));
+  FWorldContext& Context = GEngine->CreateNewWorldContext(EWorldType::Game);
+  Context.SetCurrentWorld(World);
+  World->InitializeActorsForPlay(FURL());
+  World->BeginPlay();
+}
+
+FGridTestWorld::~FGridTestWorld() {
+  GEngine->DestroyWorldContext(World);
+  World->DestroyWorld(false);
+  // don't let the grids of one test add up with the next one's
+  CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+}
+
+AGrid* FGridTestWorld::SpawnGrid(int32 Width, int32 Height, float CellSize) {
+  // a native grid has no root component, give it one before its
+  // construction so that it follows its transform like a placed grid does
+  AGrid* Grid = World->SpawnActorDeferred<AGrid>(AGrid::StaticClass(), FTransform::Identity);
+  USceneComponent* Root = NewObject<USceneComponent>(Grid, TEXT("Root"));
+  Grid->SetRootComponent(Root);
+  Root->RegisterComponent();
+  Grid->FinishSpawning(FTransform::Identity);
+  Grid->GridWidth = Width;
+  Grid->GridHeight = Height;
+  Grid->CellSize = CellSize;
+  Grid->InitializeGrid();
+  return Grid;
+}
+
+void FGridTestWorld::PumpGameThreadTasks(float Seconds) {
+  // the worker tasks finish on their own time, keep going until the time is up
+  const double EndTime = FPlatformTime::Seconds() + Seconds;
+  do {
+    FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+    FPlatformProcess::Sleep(0.01f);
+  } while (FPlatformTime::Seconds() < EndTime);
+}
+
+AActor* FGridTestWorld::SpawnItem(const FVector2D& Size, UClass* ItemClass) {
+  AActor* Item = World->SpawnActor<AActor>(ItemClass ? ItemClass : AGridTestItem::StaticClass());
+  UGridComponent::FindGridComponent(Item)->Size = Size;
+  return Item;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AGrid;
+class UGridComponent;
+class UWorld;
+
+// A throwaway game world for the tests and benchmarks, which works without a
+// map or a renderer (-nullrhi). Destroyed with the object.
+class FGridTestWorld
+{
+public:
+
+    FGridTestWorld();
+    ~FGridTestWorld();
+
+    FGridTestWorld(const FGridTestWorld&) = delete;
+    FGridTestWorld& operator=(const FGridTestWorld&) = delete;
+
+    UWorld* GetWorld() const { return World; }
+
+    // Spawn a Width x Height grid, initialized
+    AGrid* SpawnGrid(int32 Width, int32 Height, float CellSize = 100.0f);
+
+    // Run the game thread tasks which are ready (e.g. the publication of an
+    // InitializeGridAsync build) for up to the given time
+    void PumpGameThreadTasks(float Seconds = 0.5f);
+
+    // Spawn an item of the given size in cells, not placed on any grid. The
+    // class defaults to AGridTestItem and must have a grid component.
+    AActor* SpawnItem(const FVector2D& Size, UClass* ItemClass = nullptr);
+
+private:
+
+    UWorld* World = nullptr;
+};
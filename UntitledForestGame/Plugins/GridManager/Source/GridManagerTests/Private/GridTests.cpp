@@ -0,0 +1,573 @@
+#include "GridTestWorld.h"
+#include "Grid.h"
+#include "GridCellStore.h"
+#include "GridComponent.h"
+#include "GridJournal.h"
+#include "GridTestListener.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/StrongObjectPtr.h"
+
+// Functional tests of AGrid and UGridComponent, run with
+// -ExecCmds="Automation RunTests GridManager.Tests; Quit", see
+// GridBenchmarks.cpp for the full command line
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+static constexpr EAutomationTestFlags GridTestFlags = EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter;
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGridPlaceRemoveTest, "GridManager.Tests.PlaceRemove", GridTestFlags)
+bool FGridPlaceRemoveTest::RunTest(const FString& Parameters) {
+  FGridTestWorld TestWorld;
+  AGrid* Grid = TestWorld.SpawnGrid(16, 16);
+  AActor* Item = TestWorld.SpawnItem(FVector2D(2, 3));
+
+  TestTrue(TEXT("Place on free cells"), Grid->PlaceItemAtGridPosition(Item, FVector2D(4, 5)));
+  TestTrue(TEXT("Item is managed"), Grid->IsManagedItem(Item));
+  TestTrue(TEXT("Footprint is occupied"), Grid->GetItemAtXY(4, 5) == Item && Grid->GetItemAtXY(5, 7) == Item);
+  TestFalse(TEXT("Cells past the footprint are free"), Grid->IsCellOccupied(FIntPoint(6, 5)) || Grid->IsCellOccupied(FIntPoint(4, 8)));
+  TestFalse(TEXT("Overlapping cells are not free"), Grid->CheckIfCellsAreFree(FVector2D(3, 4), FVector2D(2, 2)));
+
+  AActor* Other = TestWorld.SpawnItem(FVector2D(1, 1));
+  TestFalse(TEXT("Place on occupied cells"), Grid->PlaceItemAtGridPosition(Other, FVector2D(5, 6)));
+  TestFalse(TEXT("Place off the grid"), Grid->PlaceItemAtGridPosition(Other, FVector2D(16, 0)));
+
+  TestTrue(TEXT("Remove"), Grid->RemoveItem(Item));
+  TestFalse(TEXT("Item is not managed"), Grid->IsManagedItem(Item));
+  TestTrue(TEXT("Footprint is free"), Grid->CheckIfCellsAreFree(FVector2D(4, 5), FVector2D(2, 3)));
+  TestTrue(TEXT("Place on the freed cells"), Grid->PlaceItemAtGridPosition(Other, FVector2D(5, 6)));
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGridRotateTest, "GridManager.Tests.Rotate", GridTestFlags)
+bool FGridRotateTest::RunTest(const FString& Parameters) {
+  FGridTestWorld TestWorld;
+  AGrid* Grid = TestWorld.SpawnGrid(8, 8);
+  AActor* Item = TestWorld.SpawnItem(FVector2D(1, 3));
+  UGridComponent* GridComponent = UGridComponent::FindGridComponent(Item);
+  TestTrue(TEXT("Place"), Grid->PlaceItemAtGridPosition(Item, FVector2D(2, 2)));
+
+  TestTrue(TEXT("Rotate"), Grid->RotateItem(Item, 90.0f));
+  TestEqual(TEXT("Rotation"), GridComponent->Rotation, 90.0f);
+  TestTrue(TEXT("Rotated footprint"), GridComponent->GetOccupiedFootprint() == FIntRect(2, 2, 5, 3));
+  TestFalse(TEXT("Cells of the old footprint are freed"), Grid->IsCellOccupied(FIntPoint(2, 4)));
+
+  // a blocker where the item would swing into
+  AActor* Blocker = TestWorld.SpawnItem(FVector2D(1, 1));
+  TestTrue(TEXT("Place the blocker"), Grid->PlaceItemAtGridPosition(Blocker, FVector2D(2, 4)));
+  TestFalse(TEXT("Rotate into an occupied cell"), Grid->RotateItem(Item, 0.0f));
+  TestEqual(TEXT("Rotation is unchanged"), GridComponent->Rotation, 90.0f);
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGridBatchPlacementTest, "GridManager.Tests.BatchPlacement", GridTestFlags)
+bool FGridBatchPlacementTest::RunTest(const FString& Parameters) {
+  FGridTestWorld TestWorld;
+  AGrid* Grid = TestWorld.SpawnGrid(8, 8);
+  TStrongObjectPtr<UGridTestListener> Listener(NewObject<UGridTestListener>());
+
+  TArray<FGridItemPlacement> Placements;
+  for (int32 i = 0; i < 3; ++i) {
+    FGridItemPlacement& Placement = Placements.AddDefaulted_GetRef();
+    Placement.Item = TestWorld.SpawnItem(FVector2D(2, 2));
+    Placement.GridPosition = FVector2D(i * 2, 0);
+    Listener->ListenToItem(Placement.Item->FindComponentByClass<UGridComponent>());
+  }
+  // overlaps the second placement of the same batch
+  FGridItemPlacement& Overlapping = Placements.AddDefaulted_GetRef();
+  Overlapping.Item = TestWorld.SpawnItem(FVector2D(2, 2));
+  Overlapping.GridPosition = FVector2D(3, 1);
+
+  TArray<int32> FailedPlacements;
+  TestFalse(TEXT("Batch with an overlap"), Grid->PlaceItems(Placements, FailedPlacements));
+  TestTrue(TEXT("Only the overlap failed"), FailedPlacements == TArray<int32>{3});
+  TestEqual(TEXT("Nothing was placed"), Grid->GetManagedItems().Num(), 0);
+  TestEqual(TEXT("A failed batch sends no item events"), Listener->NumPlacedInGrid, 0);
+
+  Placements.Pop();
+  TestTrue(TEXT("Batch without overlaps"), Grid->PlaceItems(Placements, FailedPlacements));
+  TestEqual(TEXT("Everything was placed"), Grid->GetManagedItems().Num(), 3);
+  // the same events as placing the items one by one
+  TestEqual(TEXT("Every item got OnPlacedInGrid"), Listener->NumPlacedInGrid, 3);
+  TestEqual(TEXT("Every item got OnGridChanged"), Listener->NumGridChanged, 3);
+  TestEqual(TEXT("Every item got OnGridPositionRotationChanged"), Listener->NumPositionRotationChanged, 3);
+  TestTrue(TEXT("Batch items remove"), Grid->RemoveItems(Grid->GetManagedItems()));
+  TestTrue(TEXT("Cells are free again"), Grid->CheckIfCellsAreFree(FVector2D(0, 0), FVector2D(6, 2)));
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGridConversionTest, "GridManager.Tests.Conversions", GridTestFlags)
+bool FGridConversionTest::RunTest(const FString& Parameters) {
+  FGridTestWorld TestWorld;
+  AGrid* Grid = TestWorld.SpawnGrid(32, 16, 50.0f);
+  Grid->SetActorLocationAndRotation(FVector(100.0, 200.0, 300.0), FRotator(0.0, 45.0, 0.0));
+
+  for (int32 Y = 0; Y < 16; Y += 3) {
+    for (int32 X = 0; X < 32; X += 5) {
+      const FVector2D GridPosition(X, Y);
+      TestTrue(FString::Printf(TEXT("Round trip of (%d, %d)"), X, Y), Grid->WorldToGrid(Grid->GridToWorld(GridPosition)) == GridPosition);
+    }
+  }
+  TestTrue(TEXT("Off the grid"), Grid->WorldToGrid(Grid->GridToWorld(FVector2D(0, 0)) - FVector(0.0, 0.0, 200.0)) == FVector2D(-1, -1));
+
+  TArray<FVector2D> GridPositions = {FVector2D(0, 0), FVector2D(31, 15), FVector2D(7, 9)};
+  TArray<FVector> WorldPositions;
+  TArray<FVector2D> RoundTrip;
+  Grid->GridToWorldBatch(GridPositions, WorldPositions);
+  Grid->WorldToGridBatch(WorldPositions, RoundTrip);
+  TestTrue(TEXT("Batch round trip"), RoundTrip == GridPositions);
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGridSnapshotTest, "GridManager.Tests.Snapshot", GridTestFlags)
+bool FGridSnapshotTest::RunTest(const FString& Parameters) {
+  FGridTestWorld TestWorld;
+  AGrid* Grid = TestWorld.SpawnGrid(12, 12);
+  Grid->SetCellType(3, 3, EGridCellType::Unusable);
+  Grid->SetWaterLevel(5, 5, 2.0f);
+  // restored items get their class' default size
+  TestTrue(TEXT("Place"), Grid->PlaceItemAtGridPosition(TestWorld.SpawnItem(FVector2D(1, 1)), FVector2D(6, 7)));
+
+  TArray<uint8> Data;
+  Grid->SaveSnapshot(Data);
+  Grid->SetCellType(3, 3, EGridCellType::Ground);
+  Grid->RemoveItems(Grid->GetManagedItems());
+
+  TestTrue(TEXT("Load"), Grid->LoadSnapshot(Data));
+  TestTrue(TEXT("Cell type"), Grid->GetCellType(3, 3) == EGridCellType::Unusable);
+  TestEqual(TEXT("Water level"), Grid->GetWaterLevel(5, 5), 2.0f);
+  TestEqual(TEXT("Items"), Grid->GetManagedItems().Num(), 1);
+  TestTrue(TEXT("Occupancy"), Grid->IsCellOccupied(FIntPoint(6, 7)) && !Grid->IsCellOccupied(FIntPoint(7, 7)));
+  AddExpectedMessage(TEXT("not a valid grid snapshot"), ELogVerbosity::Warning, EAutomationExpectedMessageFlags::Contains, 1);
+  TestFalse(TEXT("Garbage is not a snapshot"), Grid->LoadSnapshot(TArray<uint8>{1, 2, 3}));
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGridAsyncInitializeTest, "GridManager.Tests.AsyncInitialize", GridTestFlags)
+bool FGridAsyncInitializeTest::RunTest(const FString& Parameters) {
+  FGridTestWorld TestWorld;
+  AGrid* Grid = TestWorld.SpawnGrid(16, 16);
+  TStrongObjectPtr<UGridTestListener> Listener(NewObject<UGridTestListener>());
+  Listener->Listen(Grid);
+
+  Grid->GridWidth = 32;
+  Grid->InitializeGridAsync();
+  TestFalse(TEXT("Not ready while the build is pending"), Grid->IsGridReady());
+  TestFalse(TEXT("Cells are not valid while the build is pending"), Grid->IsCellValid(0, 0));
+  TestFalse(TEXT("No placement while the build is pending"), Grid->CheckIfCellsAreFree(FVector2D(0, 0), FVector2D(1, 1)));
+
+  Grid->WaitForGridReady();
+  TestTrue(TEXT("Ready after the wait"), Grid->IsGridReady());
+  TestTrue(TEXT("The wait published the new size"), Grid->IsCellValid(31, 15) && Grid->GetGridSize() == FVector2D(32, 16));
+  TestEqual(TEXT("OnGridReady by the wait"), Listener->NumGridReady, 1);
+  // the publication task queued by InitializeGridAsync finds the build
+  // published already
+  TestWorld.PumpGameThreadTasks();
+  TestEqual(TEXT("OnGridReady only once"), Listener->NumGridReady, 1);
+
+  // a synchronous initialization supersedes the build in flight
+  Grid->GridWidth = 8;
+  Grid->InitializeGridAsync();
+  Grid->GridWidth = 16;
+  Grid->InitializeGrid();
+  TestTrue(TEXT("Ready after the synchronous initialization"), Grid->IsGridReady());
+  Grid->SetCellType(15, 15, EGridCellType::Unusable);
+  TestWorld.PumpGameThreadTasks();
+  TestEqual(TEXT("The superseded build is not published"), Listener->NumGridReady, 1);
+  TestTrue(TEXT("The cells are the synchronous initialization's"),
+    Grid->GetGridSize() == FVector2D(16, 16) && Grid->GetCellType(15, 15) == EGridCellType::Unusable);
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGridResizeTest, "GridManager.Tests.Resize", GridTestFlags)
+bool FGridResizeTest::RunTest(const FString& Parameters) {
+  FGridTestWorld TestWorld;
+  AGrid* Grid = TestWorld.SpawnGrid(8, 8);
+  TStrongObjectPtr<UGridTestListener> Listener(NewObject<UGridTestListener>());
+  Listener->Listen(Grid);
+  Grid->SetCellType(1, 1, EGridCellType::Unusable);
+  Grid->SetWaterLevel(2, 2, 3.0f);
+  AActor* Kept = TestWorld.SpawnItem(FVector2D(1, 1));
+  AActor* Evicted = TestWorld.SpawnItem(FVector2D(2, 2));
+  TestTrue(TEXT("Place"), Grid->PlaceItemAtGridPosition(Kept, FVector2D(3, 3)) && Grid->PlaceItemAtGridPosition(Evicted, FVector2D(6, 6)));
+  const FVector KeptWorldPosition = Grid->GridToWorld(FVector2D(3, 3));
+
+  // grow every side by 2 cells
+  TArray<AActor*> EvictedItems;
+  Grid->ResizeGrid(12, 12, FVector2D(0.5, 0.5), EvictedItems);
+  TestEqual(TEXT("Nothing evicted by growing"), EvictedItems.Num(), 0);
+  TestTrue(TEXT("Size"), Grid->GetGridSize() == FVector2D(12, 12));
+  TestTrue(TEXT("Cell type moved by the anchor offset"), Grid->GetCellType(3, 3) == EGridCellType::Unusable && Grid->GetCellType(1, 1) != EGridCellType::Unusable);
+  TestEqual(TEXT("Attributes moved by the anchor offset"), Grid->GetWaterLevel(4, 4), 3.0f);
+  TestTrue(TEXT("Item moved by the anchor offset"), Grid->GetItemAtXY(5, 5) == Kept && UGridComponent::FindGridComponent(Kept)->Position == FVector2D(5, 5));
+  TestTrue(TEXT("The grid moved to keep the cells in place"), Grid->GridToWorld(FVector2D(5, 5)).Equals(KeptWorldPosition, 0.01));
+  TestTrue(TEXT("Grid location"), Grid->GetActorLocation().Equals(FVector(-200.0, -200.0, 0.0), 0.01));
+  TestEqual(TEXT("OnGridResized"), Listener->NumGridResized, 1);
+
+  // shrink through the evicted item, which is at (8, 8) now
+  AddExpectedMessage(TEXT("no longer fit"), ELogVerbosity::Warning, EAutomationExpectedMessageFlags::Contains, 1);
+  Grid->ResizeGrid(9, 9, FVector2D(0, 0), EvictedItems);
+  TestTrue(TEXT("Evicted items"), EvictedItems == TArray<AActor*>{Evicted});
+  TestTrue(TEXT("Evictions are broadcast"), Listener->NumGridResized == 2 && Listener->LastEvictedItems == EvictedItems);
+  TestFalse(TEXT("Evicted item is not managed"), Grid->IsManagedItem(Evicted));
+  TestFalse(TEXT("Cells of the evicted item are freed"), Grid->IsCellOccupied(FIntPoint(8, 8)));
+  TestTrue(TEXT("Kept item"), Grid->GetItemAtXY(5, 5) == Kept);
+  TestTrue(TEXT("Grid did not move with the (0, 0) anchor"), Grid->GridToWorld(FVector2D(5, 5)).Equals(KeptWorldPosition, 0.01));
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGridReinitializeItemsTest, "GridManager.Tests.ReinitializeItems", GridTestFlags)
+bool FGridReinitializeItemsTest::RunTest(const FString& Parameters) {
+  FGridTestWorld TestWorld;
+  AGrid* Grid = TestWorld.SpawnGrid(16, 16);
+  TStrongObjectPtr<UGridTestListener> Listener(NewObject<UGridTestListener>());
+  Listener->Listen(Grid);
+  AActor* Kept = TestWorld.SpawnItem(FVector2D(2, 2));
+  AActor* Evicted = TestWorld.SpawnItem(FVector2D(2, 2));
+  TestTrue(TEXT("Place"), Grid->PlaceItemAtGridPosition(Kept, FVector2D(4, 4)) && Grid->PlaceItemAtGridPosition(Evicted, FVector2D(13, 13)));
+
+  // a non-preserving initialization at a smaller size
+  AddExpectedMessage(TEXT("no longer fit"), ELogVerbosity::Warning, EAutomationExpectedMessageFlags::Contains, 1);
+  Grid->GridWidth = 12;
+  Grid->InitializeGrid();
+  TestTrue(TEXT("Kept item occupies its cells again"), Grid->GetItemAtXY(4, 4) == Kept && Grid->GetItemAtXY(5, 5) == Kept);
+  TestFalse(TEXT("Nothing can be placed over the kept item"), Grid->CheckIfCellsAreFree(FVector2D(5, 5), FVector2D(1, 1)));
+  TestFalse(TEXT("Evicted item is not managed"), Grid->IsManagedItem(Evicted));
+  TestTrue(TEXT("Evicted item has no footprint"), UGridComponent::FindGridComponent(Evicted)->GetOccupiedFootprint().Area() == 0);
+  TestTrue(TEXT("Evictions are broadcast"), Listener->NumGridResized == 1 && Listener->LastEvictedItems == TArray<AActor*>{Evicted});
+
+  // what a DefaultCellType edit does
+  Grid->DefaultCellType = EGridCellType::Empty;
+  Grid->InitializeGridAsync(false);
+  Grid->WaitForGridReady();
+  TestTrue(TEXT("Kept item occupies its cells after the async rebuild"), Grid->GetItemAtXY(5, 5) == Kept);
+  TestEqual(TEXT("Nothing else evicted"), Listener->NumGridResized, 1);
+
+  // removing the item frees its own cells, and only those
+  AActor* Neighbor = TestWorld.SpawnItem(FVector2D(1, 1));
+  TestTrue(TEXT("Place next to the kept item"), Grid->PlaceItemAtGridPosition(Neighbor, FVector2D(6, 4)));
+  TestTrue(TEXT("Remove the kept item"), Grid->RemoveItem(Kept));
+  TestTrue(TEXT("Its cells are free"), Grid->CheckIfCellsAreFree(FVector2D(4, 4), FVector2D(2, 2)));
+  TestTrue(TEXT("The neighbor keeps its cell"), Grid->GetItemAtXY(6, 4) == Neighbor);
+  return true;
+}
+
+// Number of cells for which the snapshot's answers differ from the live grid's
+static int32 CountQuerySnapshotMismatches(const AGrid* Grid, const FGridQuerySnapshot& Snapshot) {
+  int32 Mismatches = 0;
+  for (int32 Y = 0; Y < Grid->GridHeight; ++Y) {
+    for (int32 X = 0; X < Grid->GridWidth; ++X) {
+      const FVector2D GridPosition(X, Y);
+      bool bMatches = Snapshot.GetCellType(X, Y) == Grid->GetCellType(X, Y);
+      for (const FVector2D& ItemSize : {FVector2D(1, 1), FVector2D(2, 3)}) {
+        bMatches &= Snapshot.CheckIfCellsAreFree(GridPosition, ItemSize) == Grid->CheckIfCellsAreFree(GridPosition, ItemSize);
+      }
+      const FVector WorldPosition = Grid->GridToWorld(GridPosition);
+      bMatches &= Snapshot.GridToWorld(GridPosition).Equals(WorldPosition, 0.01);
+      bMatches &= Snapshot.WorldToGrid(WorldPosition) == Grid->WorldToGrid(WorldPosition);
+      bMatches &= Snapshot.WorldToGrid(WorldPosition + FVector(0.0, 0.0, 1000.0)) == Grid->WorldToGrid(WorldPosition + FVector(0.0, 0.0, 1000.0));
+
+      int32 SnapshotIndices[AGrid::MaxNeighborCells];
+      int32 GridIndices[AGrid::MaxNeighborCells];
+      for (bool bIncludeOccupied : {false, true}) {
+        const int32 NumSnapshot = Snapshot.GetNeighborCellIndices(FIntPoint(X, Y), SnapshotIndices, bIncludeOccupied);
+        const int32 NumGrid = Grid->GetNeighborCellIndices(FIntPoint(X, Y), GridIndices, bIncludeOccupied);
+        bMatches &= NumSnapshot == NumGrid && FMemory::Memcmp(SnapshotIndices, GridIndices, NumGrid * sizeof(int32)) == 0;
+      }
+      Mismatches += bMatches ? 0 : 1;
+    }
+  }
+  return Mismatches;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGridQuerySnapshotTest, "GridManager.Tests.QuerySnapshot", GridTestFlags)
+bool FGridQuerySnapshotTest::RunTest(const FString& Parameters) {
+  FGridTestWorld TestWorld;
+  AGrid* Grid = TestWorld.SpawnGrid(16, 12);
+  Grid->PublishQuerySnapshot();
+  const TSharedPtr<const FGridQuerySnapshot, ESPMode::ThreadSafe> First = Grid->GetQuerySnapshot();
+  if (!TestTrue(TEXT("Published"), First.IsValid())) {
+    return false;
+  }
+  TestEqual(TEXT("First matches"), CountQuerySnapshotMismatches(Grid, *First), 0);
+  Grid->PublishQuerySnapshot();
+  TestTrue(TEXT("No new version without a change"), Grid->GetQuerySnapshot() == First);
+
+  AActor* Item = TestWorld.SpawnItem(FVector2D(2, 2));
+  TestTrue(TEXT("Place"), Grid->PlaceItemAtGridPosition(Item, FVector2D(4, 4)));
+  Grid->PublishQuerySnapshot();
+  const TSharedPtr<const FGridQuerySnapshot, ESPMode::ThreadSafe> Placed = Grid->GetQuerySnapshot();
+  TestTrue(TEXT("New version after a place"), Placed->GetVersion() > First->GetVersion());
+  TestEqual(TEXT("Matches after a place"), CountQuerySnapshotMismatches(Grid, *Placed), 0);
+
+  TestTrue(TEXT("Remove"), Grid->RemoveItem(Item));
+  Grid->PublishQuerySnapshot();
+  const TSharedPtr<const FGridQuerySnapshot, ESPMode::ThreadSafe> Removed = Grid->GetQuerySnapshot();
+  TestTrue(TEXT("New version after a remove"), Removed->GetVersion() > Placed->GetVersion());
+  TestEqual(TEXT("Matches after a remove"), CountQuerySnapshotMismatches(Grid, *Removed), 0);
+
+  Grid->SetCellType(7, 7, EGridCellType::Unusable);
+  Grid->PublishQuerySnapshot();
+  const TSharedPtr<const FGridQuerySnapshot, ESPMode::ThreadSafe> Typed = Grid->GetQuerySnapshot();
+  TestTrue(TEXT("New version after a type change"), Typed->GetVersion() > Removed->GetVersion());
+  TestEqual(TEXT("Matches after a type change"), CountQuerySnapshotMismatches(Grid, *Typed), 0);
+
+  Grid->SetActorLocationAndRotation(FVector(100.0, 200.0, 300.0), FRotator(0.0, 45.0, 0.0));
+  Grid->PublishQuerySnapshot();
+  const TSharedPtr<const FGridQuerySnapshot, ESPMode::ThreadSafe> Moved = Grid->GetQuerySnapshot();
+  TestTrue(TEXT("New version after a move"), Moved->GetVersion() > Typed->GetVersion());
+  TestEqual(TEXT("Matches after a move"), CountQuerySnapshotMismatches(Grid, *Moved), 0);
+  Grid->PublishQuerySnapshot();
+  TestTrue(TEXT("No new version without a change after a move"), Grid->GetQuerySnapshot() == Moved);
+
+  // the older snapshots still show the grid as it was
+  TestTrue(TEXT("The first snapshot is unchanged"), First->CheckIfCellsAreFree(FVector2D(4, 4), FVector2D(2, 2))
+    && First->GetCellType(7, 7) != EGridCellType::Unusable && First->GridToWorld(FVector2D(1, 0)).Equals(FVector(100.0, 0.0, 0.0), 0.01));
+  TestFalse(TEXT("The placed snapshot is unchanged"), Placed->CheckIfCellsAreFree(FVector2D(5, 5), FVector2D(1, 1)));
+  TestTrue(TEXT("The removed snapshot is unchanged"), Removed->GetCellType(7, 7) != EGridCellType::Unusable);
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGridSparseStorageTest, "GridManager.Tests.SparseStorage", GridTestFlags)
+bool FGridSparseStorageTest::RunTest(const FString& Parameters) {
+  FGridCellStore Store;
+  Store.Init(64, 64, EGridCellType::Empty, EGridStorageMode::Sparse);
+  Store.SetType(5, EGridCellType::Empty);
+  TestEqual(TEXT("Writing the default stores nothing"), Store.GetNumSparseCells(), 0);
+
+  // enough cells to grow the table a few times, spread so that their probe
+  // sequences run into each other
+  TMap<int32, EGridCellType> Expected;
+  for (int32 i = 0; i < 500; ++i) {
+    const int32 Index = (i * 37) % Store.Num();
+    const EGridCellType Type = i % 2 ? EGridCellType::Ground : EGridCellType::Unusable;
+    Store.SetType(Index, Type);
+    Expected.Add(Index, Type);
+  }
+  int32 Mismatches = 0;
+  for (int32 Index = 0; Index < Store.Num(); ++Index) {
+    const EGridCellType* Type = Expected.Find(Index);
+    Mismatches += Store.GetType(Index) == (Type ? *Type : EGridCellType::Empty) ? 0 : 1;
+  }
+  TestEqual(TEXT("Every cell reads back"), Mismatches, 0);
+  TestEqual(TEXT("One entry per set cell"), Store.GetNumSparseCells(), Expected.Num());
+
+  // a cell only goes away once all of its values are back to the default
+  const int32 Kept = 37;
+  Store.SetOccupantSlot(Kept, 3);
+  Store.SetAttributeIndex(Kept, 7);
+  Store.SetType(Kept, EGridCellType::Empty);
+  TestTrue(TEXT("Occupant and attributes survive clearing the type"), Store.GetOccupantSlot(Kept) == 3 && Store.GetAttributeIndex(Kept) == 7);
+  TestEqual(TEXT("The cell is still stored"), Store.GetNumSparseCells(), Expected.Num());
+  Store.SetOccupantSlot(Kept, INDEX_NONE);
+  Store.SetAttributeIndex(Kept, INDEX_NONE);
+  Expected.Remove(Kept);
+  TestEqual(TEXT("A cleared cell is removed"), Store.GetNumSparseCells(), Expected.Num());
+
+  // clear every other cell, the rest have to stay reachable past the holes
+  for (int32 i = 0; i < 500; i += 2) {
+    const int32 Index = (i * 37) % Store.Num();
+    Store.SetType(Index, EGridCellType::Empty);
+    Expected.Remove(Index);
+  }
+  Mismatches = 0;
+  for (int32 Index = 0; Index < Store.Num(); ++Index) {
+    const EGridCellType* Type = Expected.Find(Index);
+    Mismatches += Store.GetType(Index) == (Type ? *Type : EGridCellType::Empty) ? 0 : 1;
+  }
+  TestEqual(TEXT("Every cell reads back after clearing"), Mismatches, 0);
+  TestEqual(TEXT("Cleared cells are removed"), Store.GetNumSparseCells(), Expected.Num());
+
+  Store.SetMode(EGridStorageMode::Chunked);
+  Store.SetMode(EGridStorageMode::Sparse);
+  Mismatches = 0;
+  for (const TPair<int32, EGridCellType>& Pair : Expected) {
+    Mismatches += Store.GetType(Pair.Key) == Pair.Value ? 0 : 1;
+  }
+  TestEqual(TEXT("Cells survive a round trip through Chunked"), Mismatches, 0);
+  TestEqual(TEXT("Only the set cells come back"), Store.GetNumSparseCells(), Expected.Num());
+
+  // and through the grid
+  FGridTestWorld TestWorld;
+  AGrid* Grid = TestWorld.SpawnGrid(32, 32);
+  Grid->SetStorageMode(EGridStorageMode::Sparse);
+  Grid->SetCellType(3, 4, EGridCellType::Unusable);
+  TestTrue(TEXT("Grid reads a sparse cell"), Grid->GetCellType(3, 4) == EGridCellType::Unusable);
+  Grid->SetCellType(3, 4, Grid->DefaultCellType);
+  TestTrue(TEXT("Grid clears a sparse cell"), Grid->GetCellType(3, 4) == Grid->DefaultCellType);
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGridSleepTimerTest, "GridManager.Tests.SleepTimer", GridTestFlags)
+bool FGridSleepTimerTest::RunTest(const FString& Parameters) {
+  FGridTestWorld TestWorld;
+  AGrid* Grid = TestWorld.SpawnGrid(8, 8);
+  // nothing updates the items, the timer has to run out anyway
+  Grid->bUpdateItems = false;
+  AActor* Item = TestWorld.SpawnItem(FVector2D(1, 1));
+  TestTrue(TEXT("Place"), Grid->PlaceItemAtGridPosition(Item, FVector2D(2, 2)));
+
+  FGridWakeCondition WakeCondition;
+  WakeCondition.WakeAfterSeconds = 1.0f;
+  TestTrue(TEXT("Sleep"), Grid->SleepItem(Item, WakeCondition));
+  TestTrue(TEXT("Asleep"), Grid->IsItemSleeping(Item));
+
+  TestWorld.GetWorld()->Tick(LEVELTICK_All, 0.5f);
+  TestTrue(TEXT("Still asleep before the timer"), Grid->IsItemSleeping(Item));
+  for (int32 i = 0; i < 3; ++i) {
+    TestWorld.GetWorld()->Tick(LEVELTICK_All, 0.5f);
+  }
+  TestFalse(TEXT("Woken by the timer"), Grid->IsItemSleeping(Item));
+  return true;
+}
+
+// Cost of a path (10 per straight step, 14 per diagonal one), or -1 if a step
+// is not between neighbors, ends on a blocked cell or cuts a corner
+static int32 GetCheckedPathCost(const AGrid* Grid, const TArray<FIntPoint>& Path) {
+  int32 Cost = 0;
+  for (int32 i = 1; i < Path.Num(); ++i) {
+    const FIntPoint Step = Path[i] - Path[i - 1];
+    if (FMath::Abs(Step.X) > 1 || FMath::Abs(Step.Y) > 1 || Step == FIntPoint::ZeroValue || !Grid->IsCellWalkable(Path[i].X, Path[i].Y)) {
+      return -1;
+    }
+    if (Step.X != 0 && Step.Y != 0) {
+      if (!Grid->IsCellWalkable(Path[i - 1].X + Step.X, Path[i - 1].Y) || !Grid->IsCellWalkable(Path[i - 1].X, Path[i - 1].Y + Step.Y)) {
+        return -1;
+      }
+      Cost += FGridPathfinder::DiagonalCost;
+    } else {
+      Cost += FGridPathfinder::StraightCost;
+    }
+  }
+  return Cost;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGridJumpPointTest, "GridManager.Tests.JumpPoint", GridTestFlags)
+bool FGridJumpPointTest::RunTest(const FString& Parameters) {
+  FGridTestWorld TestWorld;
+  AGrid* Grid = TestWorld.SpawnGrid(32, 32);
+
+  // a diagonal step past a single blocked cell would cut its corner
+  Grid->SetCellType(1, 0, EGridCellType::Unusable);
+  for (EGridPathAlgorithm Algorithm : {EGridPathAlgorithm::AStar, EGridPathAlgorithm::JumpPoint}) {
+    TArray<FIntPoint> Path;
+    const TCHAR* Name = Algorithm == EGridPathAlgorithm::AStar ? TEXT("AStar") : TEXT("JumpPoint");
+    TestTrue(FString::Printf(TEXT("%s finds the way around the corner"), Name), Grid->FindPathCells(FIntPoint(0, 0), FIntPoint(1, 1), Path, Algorithm));
+    TestTrue(FString::Printf(TEXT("%s doesn't cut the corner"), Name), Path.Num() == 3 && GetCheckedPathCost(Grid, Path) == 20);
+  }
+  Grid->SetCellType(1, 0, Grid->DefaultCellType);
+
+  // random walls, both algorithms have to agree on the length of every path
+  FRandomStream Random(1234);
+  for (int32 Y = 0; Y < 32; ++Y) {
+    for (int32 X = 0; X < 32; ++X) {
+      if (Random.FRand() < 0.3f) {
+        Grid->SetCellType(X, Y, EGridCellType::Unusable);
+      }
+    }
+  }
+  int32 NumPaths = 0;
+  int32 Mismatches = 0;
+  for (int32 Query = 0; Query < 200; ++Query) {
+    const FIntPoint Start(Random.RandRange(0, 31), Random.RandRange(0, 31));
+    const FIntPoint Goal(Random.RandRange(0, 31), Random.RandRange(0, 31));
+    TArray<FIntPoint> AStarPath;
+    TArray<FIntPoint> JumpPointPath;
+    const bool bAStarFound = Grid->FindPathCells(Start, Goal, AStarPath, EGridPathAlgorithm::AStar);
+    const bool bJumpPointFound = Grid->FindPathCells(Start, Goal, JumpPointPath, EGridPathAlgorithm::JumpPoint);
+    if (bAStarFound != bJumpPointFound) {
+      ++Mismatches;
+      continue;
+    }
+    if (!bAStarFound) {
+      continue;
+    }
+    ++NumPaths;
+    const int32 AStarCost = GetCheckedPathCost(Grid, AStarPath);
+    const int32 JumpPointCost = GetCheckedPathCost(Grid, JumpPointPath);
+    const bool bEnds = AStarPath[0] == Start && AStarPath.Last() == Goal && JumpPointPath[0] == Start && JumpPointPath.Last() == Goal;
+    Mismatches += bEnds && AStarCost >= 0 && AStarCost == JumpPointCost ? 0 : 1;
+  }
+  TestTrue(TEXT("Some paths were found"), NumPaths > 0);
+  TestEqual(TEXT("JumpPoint paths are valid and as short as AStar's"), Mismatches, 0);
+  return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGridJournalTest, "GridManager.Tests.Journal", GridTestFlags)
+bool FGridJournalTest::RunTest(const FString& Parameters) {
+  const FString BaseFilename = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("GridJournalTest"));
+  const FString JournalFilename = FGridJournal::GetJournalFilename(BaseFilename);
+  FGridTestWorld TestWorld;
+  AGrid* Grid = TestWorld.SpawnGrid(16, 16);
+
+  // everything after the start is only in the journal
+  Grid->StartJournal(BaseFilename);
+  Grid->SetCellType(2, 3, EGridCellType::Unusable);
+  Grid->SetWaterLevel(5, 5, 2.0f);
+  TestTrue(TEXT("Place"), Grid->PlaceItemAtGridPosition(TestWorld.SpawnItem(FVector2D(1, 1)), FVector2D(6, 7)));
+  Grid->StopJournal();
+
+  AGrid* Recovered = TestWorld.SpawnGrid(4, 4);
+  TestTrue(TEXT("Recover"), Recovered->RecoverFromJournal(BaseFilename));
+  TestTrue(TEXT("Recovered dimensions"), Recovered->GridWidth == 16 && Recovered->GridHeight == 16);
+  TestTrue(TEXT("Replayed cell type"), Recovered->GetCellType(2, 3) == EGridCellType::Unusable);
+  TestEqual(TEXT("Replayed water level"), Recovered->GetWaterLevel(5, 5), 2.0f);
+  TestTrue(TEXT("Replayed placement"), Recovered->GetManagedItems().Num() == 1 && Recovered->IsCellOccupied(FIntPoint(6, 7)));
+
+  // three frames of one record each
+  {
+    FGridJournal Journal(BaseFilename);
+    FGridSnapshot Snapshot;
+    Grid->CaptureSnapshot(Snapshot);
+    Journal.Compact(MoveTemp(Snapshot));
+    for (int32 Frame = 0; Frame < 3; ++Frame) {
+      FGridJournalRecord Record;
+      Record.Op = EGridJournalOp::CellType;
+      Record.Cell = FIntPoint(Frame, 0);
+      Record.CellType = EGridCellType::Unusable;
+      Journal.Append(Record);
+      Journal.Flush();
+    }
+  }
+  FGridSnapshot Snapshot;
+  TArray<FGridJournalRecord> Records;
+  TestTrue(TEXT("Load"), FGridJournal::Load(BaseFilename, Snapshot, Records));
+  TestEqual(TEXT("Every frame is read"), Records.Num(), 3);
+
+  // where each frame ends, past the magic, version and generation
+  TArray<uint8> Data;
+  TestTrue(TEXT("Read the journal"), FFileHelper::LoadFileToArray(Data, *JournalFilename));
+  TArray<int64> FrameEnds;
+  for (int64 Offset = 2 * sizeof(uint32) + sizeof(uint64); Offset + 2 * int64(sizeof(uint32)) <= Data.Num();) {
+    uint32 Size = 0;
+    FMemory::Memcpy(&Size, Data.GetData() + Offset, sizeof(uint32));
+    Offset += 2 * sizeof(uint32) + Size;
+    FrameEnds.Add(Offset);
+  }
+  if (!TestEqual(TEXT("Three frames on disk"), FrameEnds.Num(), 3)) {
+    return false;
+  }
+
+  // a crash in the middle of the last write
+  AddExpectedMessage(TEXT("damaged frame"), ELogVerbosity::Warning, EAutomationExpectedMessageFlags::Contains, 2);
+  TArray<uint8> Truncated(Data.GetData(), FrameEnds[2] - 1);
+  FFileHelper::SaveArrayToFile(Truncated, *JournalFilename);
+  TestTrue(TEXT("Load a truncated journal"), FGridJournal::Load(BaseFilename, Snapshot, Records));
+  TestEqual(TEXT("The torn frame is dropped"), Records.Num(), 2);
+
+  // a damaged frame ends the journal, even if later frames are intact
+  TArray<uint8> Corrupted = Data;
+  Corrupted[FrameEnds[1] - 1] ^= 0xFF;
+  FFileHelper::SaveArrayToFile(Corrupted, *JournalFilename);
+  TestTrue(TEXT("Load a corrupted journal"), FGridJournal::Load(BaseFilename, Snapshot, Records));
+  TestTrue(TEXT("Only the frames before the damage are read"), Records.Num() == 1 && Records[0].Cell == FIntPoint(0, 0));
+
+  IFileManager::Get().Delete(*FGridJournal::GetSnapshotFilename(BaseFilename));
+  IFileManager::Get().Delete(*JournalFilename);
+  return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS